@@ -0,0 +1,80 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (C) 2019 ScyllaDB Ltd.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include <seastar/core/lowres_clock.hh>
+
+namespace kafka4seastar {
+
+// Health of a single broker, as seen by the responses to the requests sent
+// to it. Acts as a circuit breaker: after failure_threshold consecutive
+// failures the circuit opens and requests fail right away, after open_time
+// a single probe is let through (half-open), which closes the circuit on
+// success and opens it again on failure. Error rate and latency are kept
+// as exponentially weighted moving averages.
+class broker_health final {
+public:
+    using clock = seastar::lowres_clock;
+
+    enum class circuit_state {
+        CLOSED,
+        OPEN,
+        HALF_OPEN
+    };
+
+private:
+    static constexpr double EWMA_WEIGHT = 0.2;
+
+    uint32_t _failure_threshold;
+    clock::duration _open_time;
+
+    circuit_state _state = circuit_state::CLOSED;
+    uint32_t _consecutive_failures = 0;
+    clock::time_point _open_until;
+    bool _probe_in_flight = false;
+
+    double _error_rate = 0;
+    double _latency_ms = 0;
+
+    void open(clock::time_point now);
+
+public:
+    broker_health(uint32_t failure_threshold, clock::duration open_time);
+
+    // Whether a request can be sent now, when half-open only the
+    // first call returns true until the result of the probe is known.
+    bool allow_request(clock::time_point now);
+    void record_success(clock::duration latency);
+    void record_failure(clock::time_point now);
+
+    // Whether new records should be routed to the broker, if they can go elsewhere.
+    bool healthy() const noexcept;
+    circuit_state state() const noexcept;
+    double error_rate() const noexcept;
+    double latency_ms() const noexcept;
+};
+
+}
@@ -22,11 +22,28 @@
 
 #pragma once
 
+#include <kafka4seastar/connection/broker_health.hh>
+#include <kafka4seastar/connection/connection_properties.hh>
 #include <kafka4seastar/connection/kafka_connection.hh>
+#include <kafka4seastar/connection/window_controller.hh>
+#include <kafka4seastar/utils/exceptions.hh>
 #include <kafka4seastar/protocol/metadata_response.hh>
 #include <kafka4seastar/protocol/metadata_request.hh>
 
+#include <deque>
+#include <limits>
 #include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <vector>
+
+#include <seastar/core/gate.hh>
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/metrics_registration.hh>
+#include <seastar/core/semaphore.hh>
+#include <seastar/core/shared_future.hh>
+#include <seastar/core/sleep.hh>
 
 namespace kafka4seastar {
 
@@ -40,30 +57,162 @@ public:
     explicit connection_exception(const seastar::sstring& message) : runtime_error(message) {}
 };
 
+// Responses telling for how long the broker throttles the client.
+template<typename ResponseType, typename = void>
+struct has_throttle_time : std::false_type {};
+
+template<typename ResponseType>
+struct has_throttle_time<ResponseType, std::void_t<decltype(std::declval<ResponseType&>().throttle_time_ms)>> : std::true_type {};
+
+// First version of the request with which a throttled broker responds
+// right away and expects the client to hold off sending (KIP-219).
+// With the earlier ones the broker delays the response by itself.
+// Requests added to the client have to be listed here if their API
+// predates KIP-219, the later ones are throttled by the client from
+// their first version.
+constexpr int16_t first_client_throttled_version(int16_t api_key) noexcept {
+    switch (api_key) {
+    case 0: // Produce
+        return 6;
+    case 1: // Fetch
+        return 8;
+    case 2: // ListOffsets
+        return 3;
+    case 3: // Metadata
+        return 6;
+    case 8: // OffsetCommit
+        return 4;
+    case 9: // OffsetFetch
+        return 4;
+    case 10: // FindCoordinator
+        return 2;
+    case 11: // JoinGroup
+        return 3;
+    case 12: // Heartbeat
+        return 2;
+    case 13: // LeaveGroup
+        return 2;
+    case 14: // SyncGroup
+        return 2;
+    case 18: // ApiVersions
+        return 2;
+    default:
+        return 0;
+    }
+}
+
+// Keeps a pool of connections (lanes) to every broker. Requests of a
+// partition always go through the same lane, so that their ordering is
+// preserved, the lane being picked by the least outstanding bytes the
+// first time the partition is seen. Requests not tied to a partition
+// can use a dedicated control lane, so that they don't wait behind
+// large produce or fetch requests. Lanes are connected lazily.
+//
+// Brokers are kept in a table indexed by broker_handle, the address
+// being looked up only once to obtain the handle (see handle_of()), so
+// that sending to a known broker doesn't compare any strings.
 class connection_manager {
 public:
 
     using connection_id = std::pair<seastar::sstring, uint16_t>;
-    using connection_iterator = std::map<connection_id, std::unique_ptr<kafka_connection>>::iterator;
+    using topic_partition = std::pair<seastar::sstring, int32_t>;
+    // Index of a broker in the connection table. Handles are never
+    // reused, so they stay valid for the lifetime of the manager.
+    using broker_handle = uint32_t;
+
+    static constexpr broker_handle NO_BROKER = std::numeric_limits<broker_handle>::max();
+
+    // Sends through the lane with the least outstanding bytes.
+    static constexpr size_t ANY_LANE = std::numeric_limits<size_t>::max();
+    // Sends through the dedicated control lane, or any lane if there is none.
+    static constexpr size_t CONTROL_LANE = ANY_LANE - 1;
 
 private:
 
-    std::map<connection_id, std::unique_ptr<kafka_connection>> _connections;
+    using lanes = std::vector<std::unique_ptr<kafka_connection>>;
+
+    struct lane_window {
+        window_controller controller;
+        uint32_t in_flight = 0;
+        std::deque<seastar::promise<>> waiters;
+
+        lane_window(uint32_t initial_window, uint32_t max_window) : controller(initial_window, max_window) {}
+    };
+
+    struct broker_entry {
+        connection_id address;
+        lanes connections;
+        // Connections being established, so that a lane is never connected twice.
+        std::vector<std::optional<seastar::shared_future<kafka_connection*>>> connecting;
+        // Keeps the order of the requests sent through every lane, see send_unpaced().
+        std::deque<seastar::semaphore> sending;
+        std::vector<lane_window> windows;
+        std::map<topic_partition, size_t> partition_lanes;
+        // Versions negotiated with the broker, reused when reconnecting.
+        std::optional<api_versions_response> api_versions;
+        // TLS session of the last connection, resumed when reconnecting.
+        seastar::tls::session_data tls_session;
+        broker_health health;
+        // Until when the broker asked to hold off sending (KIP-219).
+        seastar::lowres_clock::time_point throttled_until;
+        seastar::semaphore pacing = 1;
+
+        broker_entry(connection_id address, size_t lane_count, const connection_properties& properties);
+    };
+
+    std::vector<std::unique_ptr<broker_entry>> _brokers;
+    std::map<connection_id, broker_handle> _handles;
+    uint32_t _connect_timeout = 0;
+    seastar::gate _warm_ups;
+    seastar::shared_ptr<seastar::tls::certificate_credentials> _tls_credentials;
+
+    uint64_t _throttle_time_ms = 0;
+    uint64_t _throttled_responses = 0;
+    seastar::metrics::metric_groups _metrics;
     seastar::sstring _client_id;
+    connection_properties _properties;
 
-    seastar::semaphore _send_semaphore;
     seastar::future<> _pending_queue;
 
-    seastar::future<connection_iterator> connect(const seastar::sstring& host, uint16_t port, uint32_t timeout);
-    seastar::future<> disconnect(const connection_id& connection);
+    broker_entry& entry_of(broker_handle broker) {
+        return *_brokers[broker];
+    }
 
-    connection_iterator get_connection(const connection_id& connection);
+    // Only the responses to the versions of the request which leave the
+    // throttling to the client make it hold off sending to the broker.
+    template<typename RequestType, typename ResponseType>
+    void record_throttle(broker_entry& entry, const ResponseType& response, int16_t api_version) {
+        if constexpr (has_throttle_time<ResponseType>::value) {
+            record_throttle(entry, *response.throttle_time_ms,
+                    api_version >= first_client_throttled_version(RequestType::API_KEY));
+        }
+    }
+    void record_throttle(broker_entry& entry, int32_t throttle_time_ms, bool client_throttled);
+
+    bool window_open(broker_entry& entry, size_t lane, const lane_window& window);
+    seastar::future<> enter_window(broker_handle broker, size_t lane);
+    void leave_window(broker_handle broker, size_t lane, bool congested, seastar::lowres_clock::duration rtt);
+    size_t lane_count() const noexcept;
+    size_t resolve_lane(broker_entry& entry, size_t lane);
+
+    std::optional<api_versions_response> cached_api_versions(const broker_entry& entry) const;
+    seastar::future<kafka_connection*> connect(broker_handle broker, size_t lane, uint32_t timeout);
+    seastar::future<> disconnect(broker_handle broker, size_t lane);
+    seastar::future<> disconnect_lanes();
+
+    kafka_connection* get_connection(broker_handle broker, size_t lane);
 
     template<typename RequestType>
-    seastar::future<seastar::future<typename RequestType::response_type>> perform_request(connection_iterator& conn, RequestType& request, bool with_response) {
+    seastar::future<seastar::future<typename RequestType::response_type>> perform_request(kafka_connection* conn,
+            RequestType& request, bool with_response, broker_handle broker) {
+        auto api_version = conn->api_versions().template max_version<RequestType>();
         auto send_future = with_response
-                           ? conn->second->send(std::move(request))
-                           : conn->second->send_without_response(std::move(request));
+                           ? conn->send(std::move(request), api_version)
+                           : conn->send_without_response(std::move(request), api_version);
+        send_future = send_future.then([this, broker, api_version] (auto response) {
+            record_throttle<RequestType>(entry_of(broker), response, api_version);
+            return response;
+        });
 
         seastar::promise<> promise;
         auto f = promise.get_future();
@@ -79,20 +228,24 @@ private:
         return seastar::make_ready_future<decltype(send_future)>(std::move(send_future));
     }
 
-public:
-
-    explicit connection_manager(seastar::sstring client_id)
-        : _client_id(std::move(client_id)),
-        _send_semaphore(1),
-        _pending_queue(seastar::make_ready_future<>()) {}
-
-    seastar::future<> init(const std::set<connection_id>& servers, uint32_t request_timeout);
+    // Response to a request the circuit breaker of the broker didn't let through:
+    // the broker keeps failing, so don't wait for another timeout.
+    template<typename RequestType>
+    static seastar::future<typename RequestType::response_type> rejected() {
+        typename RequestType::response_type response;
+        response.error_code = error::kafka_error_code::NETWORK_EXCEPTION;
+        return seastar::make_ready_future<typename RequestType::response_type>(std::move(response));
+    }
 
+    // Requests admitted into the window of the lane (see send()) were
+    // already let through by the circuit breaker of the broker, and
+    // leave the window once their response arrives.
     template<typename RequestType>
-    seastar::future<typename RequestType::response_type> send(RequestType&& request, const seastar::sstring& host,
-            uint16_t port, uint32_t timeout, bool with_response=true) {
+    seastar::future<typename RequestType::response_type> send_unpaced(RequestType&& request, broker_handle broker,
+            uint32_t timeout, bool with_response, size_t lane, bool windowed) {
         // In order to preserve ordering of sends, a semaphore with
-        // count = 1 is used due to its FIFO guarantees.
+        // count = 1 is used due to its FIFO guarantees, one per lane,
+        // so that connecting a lane doesn't hold up the other ones.
         //
         // It is important that connect() and send() are done
         // with semaphore, as naive implementation
@@ -108,44 +261,147 @@ public:
         // returned as future<future<response>> and "unpacked"
         // outside the semaphore - scheduling inside semaphore
         // (only 1 at the time) and waiting for result outside it.
-        return with_semaphore(_send_semaphore, 1, [this, request = std::move(request), host, port, timeout, with_response] () mutable {
-            auto conn = get_connection({host, port});
-            if (conn != _connections.end()) {
-                return perform_request<RequestType>(conn, request, with_response);
+        auto& entry = entry_of(broker);
+        if (!windowed && !entry.health.allow_request(seastar::lowres_clock::now())) {
+            return rejected<RequestType>();
+        }
+        // Latencies are measured from when the request is written, so
+        // that neither the pacing nor connecting the lane add to them.
+        auto written = seastar::make_lw_shared<seastar::lowres_clock::time_point>();
+
+        lane = resolve_lane(entry, lane);
+        return with_semaphore(entry.sending[lane], 1, [this, request = std::move(request), broker, timeout, with_response, lane, written] () mutable {
+            auto conn = get_connection(broker, lane);
+            if (conn) {
+                *written = seastar::lowres_clock::now();
+                return perform_request<RequestType>(conn, request, with_response, broker);
             } else {
-                return connect(host, port, timeout).then([this, request = std::move(request), with_response](connection_iterator conn) mutable {
-                    return perform_request<RequestType>(conn, request, with_response);
+                return connect(broker, lane, timeout).then([this, request = std::move(request), with_response, broker, written](kafka_connection* conn) mutable {
+                    *written = seastar::lowres_clock::now();
+                    return perform_request<RequestType>(conn, request, with_response, broker);
                 });
             }
         }).then([] (seastar::future<typename RequestType::response_type> send_future) {
             return send_future;
-        }).then([this, host, port] (typename RequestType::response_type response) {
-            if (response.error_code == error::kafka_error_code::REQUEST_TIMED_OUT ||
-                response.error_code == error::kafka_error_code::CORRUPT_MESSAGE ||
-                response.error_code == error::kafka_error_code::NETWORK_EXCEPTION) {
-                _pending_queue = _pending_queue.then([this, host, port] {
-                    return disconnect({host, port});
+        }).then([this, broker, lane, windowed, written] (typename RequestType::response_type response) {
+            auto now = seastar::lowres_clock::now();
+            auto& entry = entry_of(broker);
+            bool failed = response.error_code == error::kafka_error_code::REQUEST_TIMED_OUT ||
+                    response.error_code == error::kafka_error_code::CORRUPT_MESSAGE ||
+                    response.error_code == error::kafka_error_code::NETWORK_EXCEPTION;
+            if (failed) {
+                entry.health.record_failure(now);
+                _pending_queue = _pending_queue.then([this, broker, lane] {
+                    return disconnect(broker, lane);
                 });
+            } else {
+                entry.health.record_success(now - *written);
+            }
+            if (windowed) {
+                bool congested = failed && response.error_code != error::kafka_error_code::CORRUPT_MESSAGE;
+                if constexpr (has_throttle_time<typename RequestType::response_type>::value) {
+                    congested = congested || *response.throttle_time_ms > 0;
+                }
+                leave_window(broker, lane, congested, now - *written);
             }
             return response;
-        }).handle_exception([this, host, port] (std::exception_ptr ep) {
-            try {
-                _pending_queue = _pending_queue.then([this, host, port] {
-                    return disconnect({host, port});
-                });
-                std::rethrow_exception(ep);
-            } catch (seastar::timed_out_error& e) {
-                typename RequestType::response_type response;
-                response.error_code = error::kafka_error_code::REQUEST_TIMED_OUT;
-                return response;
-            } catch (...) {
-                typename RequestType::response_type response;
-                response.error_code = error::kafka_error_code::NETWORK_EXCEPTION;
-                return response;
+        }).handle_exception([this, broker, lane, windowed] (std::exception_ptr ep) {
+            auto now = seastar::lowres_clock::now();
+            entry_of(broker).health.record_failure(now);
+            _pending_queue = _pending_queue.then([this, broker, lane] {
+                return disconnect(broker, lane);
+            });
+            if (windowed) {
+                leave_window(broker, lane, true, seastar::lowres_clock::duration::zero());
             }
+            typename RequestType::response_type response;
+            response.error_code = try_catch<seastar::timed_out_error>(ep)
+                                  ? error::kafka_error_code::REQUEST_TIMED_OUT
+                                  : error::kafka_error_code::NETWORK_EXCEPTION;
+            return response;
+        });
+    }
+
+    template<typename RequestType>
+    seastar::future<typename RequestType::response_type> send_paced(RequestType&& request, broker_handle broker,
+            uint32_t timeout, bool with_response, size_t lane, bool windowed=false) {
+        auto& entry = entry_of(broker);
+        if (entry.throttled_until <= seastar::lowres_clock::now() && entry.pacing.available_units() == 1
+                && entry.pacing.waiters() == 0) {
+            return send_unpaced<RequestType>(std::move(request), broker, timeout, with_response, lane, windowed);
+        }
+
+        // The broker asked to hold off sending (KIP-219). Requests are
+        // queued in a semaphore with count = 1, so that they keep their
+        // order, and are sent once the throttle time has passed.
+        return with_semaphore(entry.pacing, 1, [this, &entry, request = std::move(request), broker, timeout, with_response, lane, windowed] () mutable {
+            auto delay = entry.throttled_until - seastar::lowres_clock::now();
+            auto wait = delay > seastar::lowres_clock::duration::zero()
+                        ? seastar::sleep(std::chrono::duration_cast<std::chrono::microseconds>(delay))
+                        : seastar::make_ready_future<>();
+            return wait.then([this, request = std::move(request), broker, timeout, with_response, lane, windowed] () mutable {
+                auto send_future = send_unpaced<RequestType>(std::move(request), broker, timeout, with_response, lane, windowed);
+                return seastar::make_ready_future<decltype(send_future)>(std::move(send_future));
+            });
+        }).then([] (seastar::future<typename RequestType::response_type> send_future) {
+            return send_future;
         });
     }
 
+public:
+
+    explicit connection_manager(seastar::sstring client_id, const connection_properties& properties = {})
+        : _client_id(std::move(client_id)),
+        _properties(properties),
+        _pending_queue(seastar::make_ready_future<>()) {}
+
+    seastar::future<> init(const std::set<connection_id>& servers, uint32_t request_timeout);
+
+    // Handle of the broker with the given address, added to the table
+    // if it wasn't known yet.
+    broker_handle handle_of(const connection_id& connection);
+    const connection_id& address_of(broker_handle broker) const;
+
+    // Connects every lane to the brokers in the background, if warm_up_connections is set.
+    void warm_up(const std::set<broker_handle>& brokers);
+
+    // Whether the broker answers requests, see broker_health::healthy().
+    bool is_healthy(broker_handle broker) const;
+    // Bytes of the requests sent to the broker which still await
+    // their response, on all lanes.
+    size_t outstanding_bytes(broker_handle broker) const;
+    // Moving average of the latency of the requests to the broker, see broker_health.
+    double latency_ms(broker_handle broker) const;
+
+    // Lane the requests of the partition sent to the broker should go through.
+    size_t lane_for(broker_handle broker, const topic_partition& partition);
+
+    // Requests sent through a lane given explicitly (produce requests
+    // of the partitions pinned to it) are admitted into the lane's
+    // adaptive window of requests in flight, see window_controller.
+    // Requests the circuit breaker of the broker rejects fail before
+    // entering the window, so that they don't shrink it.
+    template<typename RequestType>
+    seastar::future<typename RequestType::response_type> send(RequestType&& request, broker_handle broker,
+            uint32_t timeout, bool with_response=true, size_t lane=CONTROL_LANE) {
+        if (lane == ANY_LANE || lane == CONTROL_LANE) {
+            return send_paced<RequestType>(std::move(request), broker, timeout, with_response, lane);
+        }
+
+        if (!entry_of(broker).health.allow_request(seastar::lowres_clock::now())) {
+            return rejected<RequestType>();
+        }
+        return enter_window(broker, lane).then([this, request = std::move(request), broker, timeout, with_response, lane] () mutable {
+            return send_paced<RequestType>(std::move(request), broker, timeout, with_response, lane, true);
+        });
+    }
+
+    template<typename RequestType>
+    seastar::future<typename RequestType::response_type> send(RequestType&& request, const seastar::sstring& host,
+            uint16_t port, uint32_t timeout, bool with_response=true, size_t lane=CONTROL_LANE) {
+        return send(std::move(request), handle_of({host, port}), timeout, with_response, lane);
+    }
+
     seastar::future<metadata_response> ask_for_metadata(metadata_request&& request);
 
     seastar::future<> disconnect_all();
@@ -0,0 +1,109 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (C) 2019 ScyllaDB Ltd.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include <seastar/core/sstring.hh>
+
+namespace kafka4seastar {
+
+class connection_properties final {
+
+public:
+
+    // number of connections used to send produce and fetch requests to a single broker,
+    // every partition is pinned to one of them
+    uint32_t connections_per_broker = 1;
+    // whether requests not tied to a partition (metadata, group coordination)
+    // go through an additional connection, instead of sharing the ones above
+    bool dedicated_control_connection = false;
+    // whether to connect to the leaders of the partitions in use (and negotiate
+    // API versions with them) right after every metadata refresh, instead of
+    // on the first request sent to each of them
+    bool warm_up_connections = false;
+    // number of produce requests in flight on a single connection to start with, the window
+    // grows while the latency of the broker stays flat and shrinks once it rises
+    uint32_t initial_in_flight_requests = 4;
+    // max number of produce requests in flight on a single connection
+    uint32_t max_in_flight_requests = 32;
+    // number of bytes in flight on a single connection allowed per request of its window
+    uint32_t in_flight_bytes_per_request = 1024 * 1024;
+    // number of consecutive failed requests (timeouts or network errors) after which
+    // requests to the broker fail right away, without being sent
+    uint32_t circuit_failure_threshold = 5;
+    // number of ms after which a single request is let through again to a broker
+    // failing right away, its success lets all the following requests through
+    uint32_t circuit_open_time = 5000;
+    // number of ms resolved broker addresses are cached for
+    uint32_t dns_ttl = 60000;
+    // number of ms a failed resolution is cached for, so that a broker which can't
+    // be resolved doesn't make every reconnect attempt query the resolver again,
+    // also the longest addresses are still used for after failing to connect to them
+    uint32_t dns_negative_ttl = 1000;
+    // number of ms after which the next address of a broker is tried in parallel,
+    // if the connection to the previous one is neither established nor failed yet
+    uint32_t connect_stagger = 250;
+    // number of us during which requests written to a connection are gathered
+    // to be flushed together, 0 flushes the requests written within the same
+    // reactor tick together
+    uint32_t flush_window = 0;
+    // max number of bytes gathered before flushing, regardless of flush_window
+    uint32_t max_flush_bytes = 64 * 1024;
+    // initial size of the buffers data is received into, adjusted between
+    // min_read_buffer_size and max_read_buffer_size to the amount of data
+    // available on the socket, responses fitting in one buffer are not copied
+    uint32_t read_buffer_size = 8192;
+    uint32_t min_read_buffer_size = 512;
+    uint32_t max_read_buffer_size = 1024 * 1024;
+    // max size of a single response, a larger frame fails the connection
+    // before anything is allocated for it
+    uint32_t max_response_size = 100 * 1024 * 1024;
+    // max number of bytes of the responses received on a single connection
+    // which are not decoded yet, the next response is read once there is room
+    // for it; records of fetch responses, which keep referring to the response
+    // they were received in, are capped by max_buffered_bytes of the consumer
+    uint32_t max_response_memory = 256 * 1024 * 1024;
+    // max length of a single string or bytes field and max number of elements
+    // of a single array in a response, longer ones fail its decoding
+    uint32_t max_string_length = 100 * 1024 * 1024;
+    uint32_t max_array_length = 1024 * 1024;
+    // whether to connect to the brokers over TLS
+    bool tls = false;
+    // PEM file with the certificates the brokers are verified against,
+    // the system trust store is used if empty
+    seastar::sstring tls_ca_file;
+    // PEM files with the certificate and the private key of the client, sent to
+    // brokers requiring client authentication, none is sent if either is empty
+    seastar::sstring tls_certificate_file;
+    seastar::sstring tls_key_file;
+    // name the certificates of the brokers are verified against (and sent
+    // in the server name indication), the host of the broker if empty
+    seastar::sstring tls_server_name;
+    // whether the TLS session of the previous connection to a broker is resumed
+    // when reconnecting to it, skipping the full handshake
+    bool tls_session_resumption = true;
+
+};
+
+}
@@ -0,0 +1,75 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (C) 2019 ScyllaDB Ltd.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <exception>
+#include <unordered_map>
+#include <vector>
+
+#include <seastar/core/future.hh>
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/shared_future.hh>
+#include <seastar/core/sstring.hh>
+#include <seastar/net/inet_address.hh>
+#include <seastar/util/noncopyable_function.hh>
+
+namespace kafka4seastar {
+
+// Caches addresses of the brokers, one instance per shard. Failed
+// resolutions are cached too, for a shorter time, and concurrent
+// resolutions of the same host are done once.
+class dns_cache final {
+public:
+    using clock = seastar::lowres_clock;
+    using resolver = seastar::noncopyable_function<
+            seastar::future<std::vector<seastar::net::inet_address>>(const seastar::sstring&)>;
+
+private:
+    struct entry {
+        std::vector<seastar::net::inet_address> addresses;
+        std::exception_ptr error;
+        clock::time_point expires;
+    };
+
+    resolver _resolver;
+    std::unordered_map<seastar::sstring, entry> _entries;
+    std::unordered_map<seastar::sstring, seastar::shared_future<std::vector<seastar::net::inet_address>>> _resolving;
+
+public:
+    // Resolves with seastar::net::dns.
+    dns_cache();
+    explicit dns_cache(resolver resolve_host);
+
+    static dns_cache& local();
+
+    seastar::future<std::vector<seastar::net::inet_address>> resolve(const seastar::sstring& host,
+            std::chrono::milliseconds ttl, std::chrono::milliseconds negative_ttl);
+    // Called when none of the addresses could be connected to, as the
+    // broker might have moved elsewhere. The addresses are still used for
+    // up to ttl, so that reconnecting to a broker which is down doesn't
+    // query the resolver on every attempt.
+    void expire_within(const seastar::sstring& host, std::chrono::milliseconds ttl);
+};
+
+}
@@ -26,21 +26,39 @@
 #include <kafka4seastar/protocol/headers.hh>
 #include <kafka4seastar/protocol/api_versions_request.hh>
 #include <kafka4seastar/protocol/api_versions_response.hh>
+#include <kafka4seastar/protocol/kafka_buffer_istream.hh>
+#include <kafka4seastar/utils/exceptions.hh>
+
+#include <cstring>
+#include <optional>
+#include <type_traits>
 
 #include <boost/iostreams/device/back_inserter.hpp>
 #include <boost/iostreams/stream.hpp>
-#include <boost/iostreams/device/array.hpp>
 
 namespace kafka4seastar {
 
+// Responses which refer to the buffer they were deserialized from,
+// instead of copying parts of it, define share_buffer().
+template<typename ResponseType, typename = void>
+struct shares_response_buffer : std::false_type {};
+
+template<typename ResponseType>
+struct shares_response_buffer<ResponseType, std::void_t<decltype(std::declval<ResponseType&>()
+        .share_buffer(std::declval<const seastar::temporary_buffer<char>&>()))>> : std::true_type {};
+
 class kafka_connection final {
 
     tcp_connection _connection;
     seastar::sstring _client_id;
     int32_t _correlation_id;
+    // Bytes of the requests which are not yet written or still await the response.
+    size_t _outstanding_bytes = 0;
     api_versions_response _api_versions;
-    seastar::semaphore _send_semaphore;
+    seastar::future<> _api_versions_refresh = seastar::make_ready_future<>();
     seastar::semaphore _receive_semaphore;
+    // Responses are decoded one at a time, all of them through this stream.
+    seastar::lw_shared_ptr<kafka_buffer_istream> _response_stream;
 
     template<typename RequestType>
     seastar::temporary_buffer<char> serialize_request(RequestType request, int32_t correlation_id, int16_t api_version) {
@@ -52,7 +70,7 @@ class kafka_connection final {
         req_header.api_version = api_version;
         req_header.correlation_id = correlation_id;
         req_header.client_id = _client_id;
-        req_header.serialize(header_stream, 0);
+        req_header.serialize(header_stream, request_header_version<RequestType>(api_version));
         header_stream.flush();
 
         std::vector<char> payload;
@@ -80,27 +98,38 @@ class kafka_connection final {
 
     template<typename RequestType>
     seastar::future<typename RequestType::response_type> receive_response(int32_t correlation_id, int16_t api_version) {
-        return _connection.read(4).then([] (seastar::temporary_buffer<char> response_size) {
-            boost::iostreams::stream<boost::iostreams::array_source> response_size_stream
-                    (response_size.get(), response_size.size());
-
-            kafka_int32_t size;
-            size.deserialize(response_size_stream, 0);
-            return *size;
-        }).then([this] (int32_t response_size) {
-            return _connection.read(response_size);
-        }).then([correlation_id, api_version] (seastar::temporary_buffer<char> response) {
-            boost::iostreams::stream<boost::iostreams::array_source> response_stream
-                    (response.get(), response.size());
-
-            response_header response_header;
-            response_header.deserialize(response_stream, 0);
-            if (*response_header.correlation_id != correlation_id) {
-                throw parsing_exception("Received invalid correlation id");
+        // The response memory taken by the frame is released once it is decoded, even
+        // if the response shares its buffer, so that records held by the application
+        // don't keep other responses from being read.
+        return _connection.read_frame().then([correlation_id, api_version, stream = _response_stream]
+                (tcp_connection::frame frame) {
+            auto& response = frame.data;
+            typename RequestType::response_type deserialized_response;
+            int32_t response_correlation_id;
+            if (response.size() < sizeof(response_correlation_id)) {
+                // Received response without header.
+                deserialized_response.error_code = error::kafka_error_code::CORRUPT_MESSAGE;
+                return deserialized_response;
+            }
+            std::memcpy(&response_correlation_id, response.get(), sizeof(response_correlation_id));
+            if (seastar::net::ntoh(response_correlation_id) != correlation_id) {
+                // Received invalid correlation id.
+                deserialized_response.error_code = error::kafka_error_code::CORRUPT_MESSAGE;
+                return deserialized_response;
+            }
+
+            response.trim_front(sizeof(int32_t));
+            auto& response_stream = *stream;
+            response_stream.reset(response.get(), response.size());
+            if (response_header_version<RequestType>(api_version) >= 1) {
+                kafka_tagged_fields_t header_tagged_fields;
+                header_tagged_fields.deserialize(response_stream, api_version);
             }
 
-            typename RequestType::response_type deserialized_response;
             deserialized_response.deserialize(response_stream, api_version);
+            if constexpr (shares_response_buffer<typename RequestType::response_type>::value) {
+                deserialized_response.share_buffer(response);
+            }
 
             return deserialized_response;
         });
@@ -108,41 +137,54 @@ class kafka_connection final {
 
     template<typename RequestType>
     seastar::future<typename RequestType::response_type> handle_response_exceptions(std::exception_ptr ep) {
-        try {
-            std::rethrow_exception(ep);
-        } catch (seastar::timed_out_error& e) {
-            typename RequestType::response_type response;
+        typename RequestType::response_type response;
+        if (try_catch<seastar::timed_out_error>(ep)) {
             response.error_code = error::kafka_error_code::REQUEST_TIMED_OUT;
-            return seastar::make_ready_future<typename RequestType::response_type>(std::move(response));
-        } catch (parsing_exception& e) {
-            typename RequestType::response_type response;
+        } else if (try_catch<parsing_exception>(ep)) {
             response.error_code = error::kafka_error_code::CORRUPT_MESSAGE;
-            return seastar::make_ready_future<typename RequestType::response_type>(std::move(response));
-        } catch (...) {
-            typename RequestType::response_type response;
+        } else {
             response.error_code = error::kafka_error_code::NETWORK_EXCEPTION;
-            return seastar::make_ready_future<typename RequestType::response_type>(std::move(response));
         }
+        return seastar::make_ready_future<typename RequestType::response_type>(std::move(response));
     }
 
     seastar::future<> init();
 
+    seastar::future<> negotiate_api_versions(int16_t api_version);
+
 public:
+    // With the versions negotiated by a previous connection to the broker, the
+    // connection is usable right away and ApiVersions is refreshed in the background.
     static seastar::future<std::unique_ptr<kafka_connection>> connect(const seastar::sstring& host, uint16_t port,
-            const seastar::sstring& client_id, uint32_t timeout_ms);
+            const seastar::sstring& client_id, uint32_t timeout_ms, const connection_properties& properties = {},
+            std::optional<api_versions_response> cached_api_versions = std::nullopt, tls_parameters tls = {});
 
-    kafka_connection(tcp_connection connection, seastar::sstring client_id) :
+    kafka_connection(tcp_connection connection, seastar::sstring client_id, decode_limits limits = {}) :
         _connection(std::move(connection)),
         _client_id(std::move(client_id)),
         _correlation_id(0),
-        _send_semaphore(1),
-        _receive_semaphore(1) {}
+        _receive_semaphore(1),
+        _response_stream(seastar::make_lw_shared<kafka_buffer_istream>()) {
+        limits.apply(*_response_stream);
+    }
 
     kafka_connection(kafka_connection&& other) = default;
     kafka_connection(kafka_connection& other) = delete;
 
     seastar::future<> close();
 
+    const api_versions_response& api_versions() const noexcept {
+        return _api_versions;
+    }
+
+    size_t outstanding_bytes() const noexcept {
+        return _outstanding_bytes;
+    }
+
+    seastar::future<seastar::tls::session_data> tls_session() {
+        return _connection.tls_session();
+    }
+
     template<typename RequestType>
     seastar::future<typename RequestType::response_type> send(RequestType request) {
         return send(std::move(request), _api_versions.max_version<RequestType>());
@@ -153,27 +195,29 @@ public:
         auto correlation_id = _correlation_id++;
         auto serialized_message = serialize_request(std::move(request), correlation_id, api_version);
 
-        // In order to preserve ordering of sends, two semaphores with
-        // count = 1 are used due to its FIFO guarantees.
+        // Requests are queued for writing by tcp_connection right away,
+        // so they are sent in the order of send() calls, and the ones
+        // sent in quick succession are flushed together.
         //
-        // Send and receive are always queued jointly,
-        // so that receive will get response from correct
-        // request. Kafka guarantees that responses will
-        // be sent in the same order that requests were sent.
+        // Receives are queued jointly with sends, in a semaphore
+        // with count = 1 due to its FIFO guarantees, so that receive
+        // will get response from correct request. Kafka guarantees
+        // that responses will be sent in the same order that
+        // requests were sent.
         //
-        // Usage of two semaphores makes it possible for
-        // requests to be sent without waiting for
-        // the previous response.
-        auto request_future = with_semaphore(_send_semaphore, 1,
-        [this, serialized_message = std::move(serialized_message)]() mutable {
-            return send_request(std::move(serialized_message));
-        }).handle_exception([] (std::exception_ptr ep) {
+        // This makes it possible for requests to be sent
+        // without waiting for the previous response.
+        auto message_size = serialized_message.size();
+        _outstanding_bytes += message_size;
+        auto request_future = send_request(std::move(serialized_message)).handle_exception([] (std::exception_ptr ep) {
             // Ignore exception as it will be handled in response_future
         });
         auto response_future = with_semaphore(_receive_semaphore, 1, [this, correlation_id, api_version] {
             return receive_response<RequestType>(correlation_id, api_version);
         }).handle_exception([this] (std::exception_ptr ep) {
             return handle_response_exceptions<RequestType>(ep);
+        }).finally([this, message_size] {
+            _outstanding_bytes -= message_size;
         });
         return response_future;
     }
@@ -188,15 +232,16 @@ public:
         auto correlation_id = _correlation_id++;
         auto serialized_message = serialize_request(std::move(request), correlation_id, api_version);
 
-        auto request_future = with_semaphore(_send_semaphore, 1,
-        [this, serialized_message = std::move(serialized_message)]() mutable {
-            return send_request(std::move(serialized_message));
-        }).then([] {
+        auto message_size = serialized_message.size();
+        _outstanding_bytes += message_size;
+        auto request_future = send_request(std::move(serialized_message)).then([] {
             typename RequestType::response_type response;
             response.error_code = error::kafka_error_code::NONE;
             return response;
         }).handle_exception([this] (auto ep) {
             return handle_response_exceptions<RequestType>(ep);
+        }).finally([this, message_size] {
+            _outstanding_bytes -= message_size;
         });
         return request_future;
     }
@@ -23,10 +23,20 @@
 #pragma once
 
 #include <seastar/core/future.hh>
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/semaphore.hh>
+#include <seastar/core/shared_future.hh>
+#include <seastar/core/shared_ptr.hh>
+#include <seastar/core/timer.hh>
 #include <seastar/net/api.hh>
 #include <seastar/net/net.hh>
 #include <seastar/net/inet_address.hh>
+#include <seastar/net/tls.hh>
+#include <memory>
 #include <string>
+#include <vector>
+
+#include <kafka4seastar/connection/connection_properties.hh>
 
 namespace kafka4seastar {
 
@@ -34,35 +44,107 @@ struct tcp_connection_exception final : public std::runtime_error {
     explicit tcp_connection_exception(const seastar::sstring& message) : runtime_error(message) {}
 };
 
+// Credentials of the connections over TLS (null for plaintext ones) and the
+// session of a previous connection to the broker, resumed if not empty.
+struct tls_parameters {
+    seastar::shared_ptr<seastar::tls::certificate_credentials> credentials;
+    seastar::tls::session_data session;
+};
+
+// Writes are corked: buffers written within flush_window (or the same
+// reactor tick) are gathered into one batch, written back to back and
+// flushed once. A batch reaching max_flush_bytes is flushed right away.
+// Batches are flushed one at a time, in the order they were written.
+//
+// Received data is kept in the buffers returned by the socket and frames
+// are shared out of them, a frame is copied only when it straddles two
+// buffers. Reads are done one at a time, their deadline is kept by a
+// single lowres_clock timer of the connection. A frame waits for units of
+// the response memory of the connection before it is read, they are
+// held apart from its data, so that it can be kept after they are released.
+//
+// Connections over TLS are established like plaintext ones, the socket
+// being wrapped once connected. The handshake is done along with the
+// first write.
 class tcp_connection final {
+public:
+    struct frame {
+        seastar::temporary_buffer<char> data;
+        // Releases the units of response memory taken by the frame when destroyed.
+        seastar::deleter memory;
+    };
+
+private:
 
     seastar::net::inet_address _host;
     uint16_t _port;
     uint32_t _timeout_ms;
+    connection_properties _properties;
     seastar::connected_socket _fd;
+    bool _tls;
     seastar::input_stream<char> _read_buf;
     seastar::output_stream<char> _write_buf;
 
+    // Shared with the frames, which may outlive the connection.
+    seastar::lw_shared_ptr<seastar::semaphore> _response_memory;
+    seastar::temporary_buffer<char> _read_ahead;
+    seastar::timer<seastar::lowres_clock> _read_timer;
+    bool _read_timed_out = false;
+
+    std::vector<seastar::temporary_buffer<char>> _batch;
+    size_t _batch_bytes = 0;
+    uint64_t _batch_id = 0;
+    std::unique_ptr<seastar::shared_promise<>> _batch_flushed;
+    seastar::future<> _flush_trigger = seastar::make_ready_future<>();
+    seastar::future<> _flushing = seastar::make_ready_future<>();
+
+    void schedule_flush();
+    void flush_batch();
+
+    seastar::future<seastar::temporary_buffer<char>> read_buffered(size_t bytes_to_read);
+    seastar::future<seastar::temporary_buffer<char>> with_read_deadline(
+            seastar::future<seastar::temporary_buffer<char>> read_future);
+    seastar::future<seastar::temporary_buffer<char>> premature_end();
+
 public:
-    static seastar::future<tcp_connection> connect(const seastar::sstring& host, uint16_t port, uint32_t timeout_ms);
+    static seastar::future<tcp_connection> connect(const seastar::sstring& host, uint16_t port, uint32_t timeout_ms,
+            const connection_properties& properties = {}, tls_parameters tls = {});
+    // Loads the files given in the properties, null if TLS is not enabled.
+    static seastar::future<seastar::shared_ptr<seastar::tls::certificate_credentials>> make_tls_credentials(
+            const connection_properties& properties);
 
-    tcp_connection(const seastar::net::inet_address& host, uint16_t port, uint32_t timeout_ms, seastar::connected_socket&& fd) noexcept
+    tcp_connection(const seastar::net::inet_address& host, uint16_t port, uint32_t timeout_ms,
+            const connection_properties& properties, seastar::connected_socket&& fd, bool tls = false) noexcept
             : _host(host)
             , _port(port)
             , _timeout_ms(timeout_ms)
+            , _properties(properties)
             , _fd(std::move(fd))
-            , _read_buf(_fd.input())
-            , _write_buf(_fd.output()) {
+            , _tls(tls)
+            , _read_buf(_fd.input(seastar::connected_socket_input_stream_config{properties.read_buffer_size,
+                    properties.min_read_buffer_size, properties.max_read_buffer_size}))
+            , _write_buf(_fd.output())
+            , _response_memory(seastar::make_lw_shared<seastar::semaphore>(properties.max_response_memory)) {
         _fd.set_nodelay(true);
     };
 
     tcp_connection(tcp_connection&& other) = default;
     tcp_connection(tcp_connection& other) = delete;
 
+    // The buffer is queued right away, so the order of writes is the order
+    // of the calls. Resolves once the batch containing it is flushed.
     seastar::future<> write(seastar::temporary_buffer<char> buff);
     seastar::future<seastar::temporary_buffer<char>> read(size_t bytes_to_read);
+    // Reads a frame prefixed with its 32-bit size, the size is not returned.
+    seastar::future<frame> read_frame();
     seastar::future<> close();
 
+    // Session to be resumed by the next connection to the broker, empty
+    // for plaintext connections. Completes the handshake if not done yet.
+    seastar::future<seastar::tls::session_data> tls_session();
+    // Whether the handshake resumed the session of a previous connection.
+    seastar::future<bool> tls_session_resumed();
+
 };
 
 }
@@ -0,0 +1,61 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (C) 2019 ScyllaDB Ltd.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace kafka4seastar {
+
+// Size of the window of requests in flight to a broker, adapted to the
+// observed round-trip times in the spirit of TCP Vegas: the estimated
+// number of requests queued at the broker is kept between ALPHA and BETA,
+// growing the window by one request per window while latency stays flat
+// and shrinking it once it rises. Throttling and timeouts halve it.
+class window_controller final {
+public:
+    static constexpr double ALPHA = 1;
+    static constexpr double BETA = 3;
+    static constexpr double EWMA_WEIGHT = 0.25;
+    // The base round-trip time is re-estimated periodically, so that
+    // it follows the changes of the network and the broker.
+    static constexpr uint32_t BASE_RTT_SAMPLES = 1000;
+
+private:
+    double _window;
+    double _max_window;
+
+    double _base_rtt_ms = 0;
+    double _rtt_ms = 0;
+    uint32_t _samples = 0;
+
+public:
+    window_controller(uint32_t initial_window, uint32_t max_window);
+
+    void on_success(double rtt_ms);
+    void on_congestion();
+
+    uint32_t window() const noexcept;
+    double rtt_ms() const noexcept;
+};
+
+}
@@ -0,0 +1,121 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (C) 2019 ScyllaDB Ltd.
+ */
+
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <set>
+#include <memory>
+#include <optional>
+
+#include <seastar/core/future.hh>
+#include <seastar/util/noncopyable_function.hh>
+
+#include <kafka4seastar/connection/connection_properties.hh>
+#include <kafka4seastar/consumer/partition_assignor.hh>
+#include <kafka4seastar/utils/defaults.hh>
+
+namespace kafka4seastar {
+
+enum class offset_reset_policy {
+    EARLIEST,
+    LATEST
+};
+
+class consumer_properties final {
+
+public:
+
+    // Name of the consumer group to join
+    seastar::sstring group_id {};
+    // Identifier of a static member of the group (KIP-345), a consumer restarted
+    // with the same identifier within session_timeout takes back its partitions
+    // without triggering a rebalance
+    std::optional<seastar::sstring> group_instance_id {};
+
+    // number of ms without heartbeats after which the coordinator removes the consumer from the group
+    uint32_t session_timeout = 10000;
+    // number of ms between consecutive heartbeats sent to the coordinator
+    uint32_t heartbeat_interval = 3000;
+    // max time in ms the coordinator waits for all members to rejoin the group during a rebalance
+    uint32_t rebalance_timeout = 30000;
+    // number of ms after which a request is considered to have timed out, the coordinator
+    // holds JoinGroup requests for up to rebalance_timeout, so it should be larger than that
+    uint32_t request_timeout = 35000;
+    // max time in ms after which a new metadata refresh will be sent, even if no changes have been noticed
+    uint32_t metadata_refresh = 300000;
+    // max time in ms the broker waits for fetch_min_bytes of data before answering a fetch request
+    uint32_t fetch_max_wait = 500;
+    // min amount of data the broker should return for a fetch request
+    uint32_t fetch_min_bytes = 1;
+    // max amount of data the broker should return for a fetch request
+    uint32_t fetch_max_bytes = 52428800;
+    // max amount of data the broker should return for a single partition in a fetch request
+    uint32_t max_partition_fetch_bytes = 1048576;
+    // max amount of fetched data of a single partition buffered until polled,
+    // the partition is not fetched while it's over the limit
+    uint32_t max_partition_buffered_bytes = 2097152;
+    // max amount of fetched data buffered until polled, no fetch requests are sent while it's over the limit
+    uint32_t max_buffered_bytes = 104857600;
+    // number of ms to wait before fetching again from a broker which failed to respond
+    uint32_t retry_backoff = 100;
+    // number of ms during which offset commits are gathered to be sent in a single request,
+    // 0 sends every commit right away
+    uint32_t commit_window = 100;
+    // where to start consuming a partition with no valid position
+    offset_reset_policy auto_offset_reset = offset_reset_policy::LATEST;
+    // maximum number of retries to be performed before giving up on joining the group
+    uint32_t retries = 10;
+
+    // Options of the connections to the brokers, e.g. how writes are coalesced or TLS
+    connection_properties connection {};
+
+    // Identifier of the created consumer instance
+    seastar::sstring client_id {};
+    // a list of host-port pairs to use for establishing the initial connection to the cluster
+    std::set<std::pair<seastar::sstring, uint16_t>> servers {};
+
+    // Strategy used to distribute partitions between members of the group,
+    // when this consumer is elected as the group leader
+    std::unique_ptr<partition_assignor> assignment_strategy = defaults::cooperative_sticky_assignor();
+    // Strategy describing how long to wait between consecutive retries,
+    // based on how many have already been performed
+    seastar::noncopyable_function<seastar::future<>(uint32_t)> retry_backoff_strategy = defaults::exp_retry_backoff(20, 1000);
+
+    // Called with the partitions taken away from this consumer during a rebalance.
+    // With cooperative rebalancing only the partitions moving to another member are revoked,
+    // the remaining ones are consumed without interruption.
+    seastar::noncopyable_function<seastar::future<>(const std::vector<topic_partition>&)> on_partitions_revoked =
+            [] (const std::vector<topic_partition>&) { return seastar::make_ready_future<>(); };
+    // Called with the partitions newly given to this consumer during a rebalance
+    seastar::noncopyable_function<seastar::future<>(const std::vector<topic_partition>&)> on_partitions_assigned =
+            [] (const std::vector<topic_partition>&) { return seastar::make_ready_future<>(); };
+    // Called instead of on_partitions_revoked when the consumer was removed from the group
+    // (e.g. its session expired), so the partitions might already be owned by another member
+    seastar::noncopyable_function<seastar::future<>(const std::vector<topic_partition>&)> on_partitions_lost =
+            [] (const std::vector<topic_partition>&) { return seastar::make_ready_future<>(); };
+
+};
+
+}
@@ -0,0 +1,84 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (C) 2019 ScyllaDB Ltd.
+ */
+
+
+#pragma once
+
+#include <map>
+
+#include <kafka4seastar/consumer/partition_assignor.hh>
+#include <kafka4seastar/protocol/fetch_request.hh>
+
+namespace kafka4seastar {
+
+// Client side of an incremental fetch session (KIP-227) with a single broker.
+// The first request of a session lists all partitions, later ones only
+// the partitions which were added or changed their fetch position, and
+// the partitions which are not fetched anymore as forgotten. The broker
+// responds only with partitions which have data or changed metadata.
+// Partitions which are kept but shouldn't return records for now
+// (e.g. paused) are requested with max_bytes = 0.
+// Brokers older than version 7 of Fetch never create a session, so
+// every request stays a full one.
+class fetch_session {
+public:
+    static constexpr int32_t INVALID_SESSION_ID = 0;
+    static constexpr int32_t INITIAL_EPOCH = 0;
+    static constexpr int32_t FINAL_EPOCH = -1;
+
+    struct partition_data {
+        int64_t fetch_offset;
+        int32_t max_bytes;
+
+        bool operator==(const partition_data& other) const {
+            return fetch_offset == other.fetch_offset && max_bytes == other.max_bytes;
+        }
+    };
+    using partitions = std::map<topic_partition, partition_data>;
+
+private:
+    int32_t _session_id = INVALID_SESSION_ID;
+    int32_t _epoch = INITIAL_EPOCH;
+    // Partitions as known by the broker after the last successful request.
+    partitions _session_partitions;
+    // Partitions sent in the request awaiting a response.
+    partitions _pending_partitions;
+
+public:
+    // Fills topics, forgotten topics and session fields of the request.
+    // Only one request of a session can be in flight at a time.
+    fetch_request build_request(const partitions& wanted);
+    // Returns false if the session was rejected, in which case
+    // the response doesn't contain any partition data.
+    bool handle_response(const fetch_response& response);
+    // Request closing the session (KIP-227 final epoch) without fetching
+    // anything, the session is dropped as if reset() was called.
+    fetch_request close_request();
+    // Drops the session, so that the next request is a full one.
+    void reset();
+
+    bool is_incremental() const;
+    int32_t session_id() const;
+    int32_t epoch() const;
+};
+
+}
@@ -0,0 +1,149 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (C) 2019 ScyllaDB Ltd.
+ */
+
+
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <set>
+#include <optional>
+
+#include <seastar/core/condition-variable.hh>
+#include <seastar/core/future.hh>
+#include <seastar/core/gate.hh>
+
+#include <kafka4seastar/connection/connection_manager.hh>
+#include <kafka4seastar/consumer/consumer_properties.hh>
+#include <kafka4seastar/consumer/fetch_session.hh>
+#include <kafka4seastar/consumer/offset_manager.hh>
+#include <kafka4seastar/protocol/kafka_records_view.hh>
+#include <kafka4seastar/utils/metadata_manager.hh>
+
+namespace kafka4seastar {
+
+// Records of a single partition received in one fetch. The batches share
+// the buffer of the fetch response and records are decoded only while
+// iterating over them.
+class fetched_partition {
+public:
+    topic_partition partition;
+    // Batches are returned whole, so the first one can
+    // start before the position the fetch was sent from.
+    int64_t first_offset;
+    // Offset following the last batch, skipped control batches included.
+    int64_t next_offset;
+    std::vector<kafka_record_batch_view> batches;
+    size_t size_bytes = 0;
+
+    // Throws unsupported_compression_exception on a compressed batch,
+    // the batches before it are already passed to func.
+    template<typename Func>
+    void for_each_record(Func&& func) const {
+        for (const auto& batch : batches) {
+            for (const auto& record : batch) {
+                if (record.offset() >= first_offset) {
+                    func(record);
+                }
+            }
+        }
+    }
+};
+
+// Fetches records of the assigned partitions from their leaders, keeping
+// an incremental fetch session with every broker. Fetching runs ahead
+// of the application: as soon as a response from a broker arrives, the
+// next request is sent to it, while the records are buffered until
+// polled. Buffered bytes are capped per partition and in total, a
+// partition over its cap (or paused) stays in the fetch session but
+// is requested with no bytes. Sessions with brokers which don't lead
+// any of the partitions anymore are closed, all of them on stop().
+class fetcher {
+public:
+    using broker_handle = connection_manager::broker_handle;
+
+private:
+    connection_manager& _connection_manager;
+    metadata_manager& _metadata_manager;
+    offset_manager& _offset_manager;
+    consumer_properties& _properties;
+
+    std::set<topic_partition> _assignment;
+    std::set<topic_partition> _paused;
+    // Offsets the next fetch of every partition starts from.
+    std::map<topic_partition, int64_t> _positions;
+    // Offsets of the next records to be returned by poll().
+    std::map<topic_partition, int64_t> _consumed_positions;
+    std::map<broker_handle, fetch_session> _sessions;
+    std::set<broker_handle> _in_flight;
+    bool _resetting_positions = false;
+
+    std::deque<fetched_partition> _completed;
+    std::map<topic_partition, size_t> _buffered_bytes_per_partition;
+    size_t _buffered_bytes = 0;
+    seastar::condition_variable _fetch_completed;
+    std::exception_ptr _fetch_error;
+
+    bool _stopped = false;
+    seastar::gate _pending_fetches;
+
+    std::optional<broker_handle> leader_for(const topic_partition& partition);
+    // Whether poll() has something to return right away.
+    bool ready_to_poll() const;
+
+    void maybe_fetch();
+    seastar::future<> reset_positions();
+    seastar::future<> reset_to_policy();
+    seastar::future<> fetch_from(broker_handle broker, const fetch_session::partitions& partitions);
+    seastar::future<> close_session(broker_handle broker);
+    void handle_partition(const seastar::sstring& topic, const fetch_response_partition& partition,
+            const fetch_session::partitions& requested);
+    void drop_buffered(const topic_partition& partition);
+
+public:
+    fetcher(connection_manager& connection_manager, metadata_manager& metadata_manager,
+            offset_manager& offset_manager, consumer_properties& properties);
+
+    // Partitions which are no longer assigned lose their position and
+    // buffered records, the new ones start from their committed offsets,
+    // or from auto_offset_reset if nothing was committed.
+    void assign(const std::set<topic_partition>& assignment);
+    // Buffered records of the partition are dropped.
+    void seek(const topic_partition& partition, int64_t offset);
+    // Offset of the next record of the partition to be returned by poll().
+    std::optional<int64_t> position(const topic_partition& partition) const;
+
+    // A paused partition is not fetched and its buffered records
+    // are held back until it is resumed.
+    void pause(const topic_partition& partition);
+    void resume(const topic_partition& partition);
+
+    // Returns the buffered records of partitions which aren't paused,
+    // waiting up to timeout for some to arrive if there are none.
+    // Control batches are skipped. Errors of the background fetches,
+    // e.g. corrupted batches, are rethrown by the next call.
+    seastar::future<std::vector<fetched_partition>> poll(std::chrono::milliseconds timeout);
+    seastar::future<> stop();
+};
+
+}
@@ -0,0 +1,111 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (C) 2019 ScyllaDB Ltd.
+ */
+
+
+#pragma once
+
+#include <set>
+#include <chrono>
+#include <optional>
+
+#include <seastar/core/future.hh>
+#include <seastar/core/abort_source.hh>
+
+#include <kafka4seastar/connection/connection_manager.hh>
+#include <kafka4seastar/consumer/consumer_properties.hh>
+#include <kafka4seastar/protocol/join_group_response.hh>
+#include <kafka4seastar/protocol/sync_group_request.hh>
+#include <kafka4seastar/utils/metadata_manager.hh>
+#include <kafka4seastar/utils/retry_helper.hh>
+
+namespace kafka4seastar {
+
+struct group_exception : public std::runtime_error {
+public:
+    explicit group_exception(const seastar::sstring& message) : runtime_error(message) {}
+};
+
+// Keeps the consumer a member of its group: finds the group coordinator,
+// joins the group and syncs the assignment (running the assignor when
+// elected as the leader), and sends heartbeats in the background.
+// Rebalances are cooperative (KIP-429): owned partitions are reported
+// when rejoining and only the ones given to other members get revoked.
+class group_manager {
+public:
+    using connection_id = std::pair<seastar::sstring, uint16_t>;
+
+private:
+    connection_manager& _connection_manager;
+    metadata_manager& _metadata_manager;
+    consumer_properties& _properties;
+    retry_helper _retry_helper;
+
+    std::vector<seastar::sstring> _subscription;
+    std::set<topic_partition> _assignment;
+
+    std::optional<connection_manager::broker_handle> _coordinator;
+    seastar::sstring _member_id;
+    int32_t _generation_id = -1;
+    bool _rejoin_needed = true;
+    seastar::semaphore _rebalance_semaphore = 1;
+
+    bool _keep_heartbeating = false;
+    seastar::semaphore _heartbeat_finished = 0;
+    seastar::abort_source _stop_heartbeat;
+
+    seastar::future<do_retry> rebalance_round();
+    seastar::future<do_retry> sync_group(join_group_response response);
+    std::vector<sync_group_request_assignment> perform_assignment(const join_group_response& response);
+    seastar::future<> update_assignment(std::set<topic_partition> assignment);
+    seastar::future<> lose_partitions();
+    seastar::future<> handle_group_error(const kafka_error_code_t& error_code);
+    seastar::sstring serialize_subscription() const;
+
+    seastar::future<> heartbeat();
+    seastar::future<> heartbeat_coroutine(std::chrono::milliseconds dur);
+
+public:
+    group_manager(connection_manager& connection_manager, metadata_manager& metadata_manager,
+            consumer_properties& properties);
+
+    seastar::future<> subscribe(std::vector<seastar::sstring> topics);
+    // Rejoins the group if a rebalance is pending, resolves
+    // once this consumer is a stable member of the group.
+    seastar::future<> ensure_active_group();
+    seastar::future<> leave();
+
+    // Looks up the coordinator of the group, unless it is already known.
+    // The coordinator stays unknown if no broker could tell it.
+    seastar::future<> ensure_coordinator();
+    const std::optional<connection_manager::broker_handle>& coordinator() const;
+    // Called when the coordinator didn't respond or moved elsewhere.
+    void reset_coordinator();
+
+    void start_heartbeat();
+    seastar::future<> stop_heartbeat();
+
+    const std::set<topic_partition>& assignment() const;
+    const seastar::sstring& member_id() const;
+    int32_t generation_id() const;
+};
+
+}
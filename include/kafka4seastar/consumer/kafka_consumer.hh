@@ -0,0 +1,71 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (C) 2019 ScyllaDB Ltd.
+ */
+
+
+#pragma once
+
+#include <chrono>
+#include <set>
+#include <vector>
+
+#include <seastar/core/future.hh>
+
+#include <kafka4seastar/consumer/consumer_properties.hh>
+#include <kafka4seastar/consumer/fetcher.hh>
+#include <kafka4seastar/consumer/group_manager.hh>
+#include <kafka4seastar/consumer/offset_manager.hh>
+#include <kafka4seastar/connection/connection_manager.hh>
+#include <kafka4seastar/utils/metadata_manager.hh>
+
+namespace kafka4seastar {
+
+class kafka_consumer final {
+
+    consumer_properties _properties;
+    connection_manager _connection_manager;
+    metadata_manager _metadata_manager;
+    group_manager _group_manager;
+    offset_manager _offset_manager;
+    fetcher _fetcher;
+
+public:
+    explicit kafka_consumer(consumer_properties&& properties);
+    seastar::future<> init();
+    // Joins the consumer group with the given subscription,
+    // resolves once the first assignment has been received.
+    seastar::future<> subscribe(std::vector<seastar::sstring> topics);
+    const std::set<topic_partition>& assignment() const;
+    // Returns the records fetched in the background, waiting up to
+    // timeout for some to arrive if none are buffered.
+    seastar::future<std::vector<fetched_partition>> poll(std::chrono::milliseconds timeout);
+    void pause(const topic_partition& partition);
+    void resume(const topic_partition& partition);
+    // Commits are sent in the background, coalesced within commit_window,
+    // the returned future resolves once the coordinator acknowledged them.
+    seastar::future<> commit(const topic_partition& partition, int64_t offset);
+    // Commits the positions of all assigned partitions.
+    seastar::future<> commit();
+    seastar::future<> close();
+
+};
+
+}
@@ -0,0 +1,93 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (C) 2019 ScyllaDB Ltd.
+ */
+
+
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <vector>
+
+#include <seastar/core/abort_source.hh>
+#include <seastar/core/future.hh>
+
+#include <kafka4seastar/connection/connection_manager.hh>
+#include <kafka4seastar/consumer/consumer_properties.hh>
+#include <kafka4seastar/consumer/group_manager.hh>
+
+namespace kafka4seastar {
+
+struct commit_exception : public std::runtime_error {
+public:
+    explicit commit_exception(const seastar::sstring& message) : runtime_error(message) {}
+};
+
+// Commits and fetches offsets of the group. Commits are coalesced: all
+// of them made within commit_window are sent to the coordinator as one
+// request, and a commit of a partition supersedes the previous one
+// which wasn't acknowledged yet, so that it is never retried.
+// Only one commit request is in flight at a time, so the offsets
+// reach the coordinator in the order they were committed.
+class offset_manager {
+private:
+    struct pending_commit {
+        int64_t offset = 0;
+        uint32_t attempts = 0;
+        std::vector<seastar::promise<>> waiters;
+    };
+    using commits = std::map<topic_partition, pending_commit>;
+
+    connection_manager& _connection_manager;
+    group_manager& _group_manager;
+    consumer_properties& _properties;
+
+    commits _pending;
+    seastar::semaphore _commit_semaphore = 1;
+
+    bool _keep_flushing = false;
+    seastar::semaphore _flush_finished = 0;
+    seastar::abort_source _stop_flush;
+
+    seastar::future<> send_commits(commits& to_send);
+    void commit_failed(const topic_partition& partition, pending_commit&& commit,
+            const kafka_error_code_t& error_code);
+    seastar::future<> flush_coroutine(std::chrono::milliseconds dur);
+
+public:
+    offset_manager(connection_manager& connection_manager, group_manager& group_manager,
+            consumer_properties& properties);
+
+    // Resolves once the offset (or a later commit
+    // of the same partition) is acknowledged.
+    seastar::future<> commit(const topic_partition& partition, int64_t offset);
+    seastar::future<> flush();
+
+    // Partitions without a committed offset are left out.
+    seastar::future<std::map<topic_partition, int64_t>> fetch_committed(const std::vector<topic_partition>& partitions);
+
+    void start_flush();
+    // Sends the pending commits once more, the ones
+    // which still didn't succeed are failed.
+    seastar::future<> stop_flush();
+};
+
+}
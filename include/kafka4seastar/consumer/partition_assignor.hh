@@ -0,0 +1,69 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (C) 2019 ScyllaDB Ltd.
+ */
+
+
+#pragma once
+
+#include <map>
+#include <vector>
+#include <utility>
+
+#include <seastar/core/sstring.hh>
+
+namespace kafka4seastar {
+
+using topic_partition = std::pair<seastar::sstring, int32_t>;
+
+struct member_subscription {
+    std::vector<seastar::sstring> topics;
+    // Partitions owned by the member in the previous generation,
+    // as reported in its subscription.
+    std::vector<topic_partition> owned_partitions;
+};
+
+// Strategy run by the group leader to distribute partitions
+// of the subscribed topics between members of the group.
+class partition_assignor {
+public:
+    using member_id = seastar::sstring;
+    using assignment = std::map<member_id, std::vector<topic_partition>>;
+
+    virtual seastar::sstring name() const = 0;
+    virtual assignment assign(const std::map<member_id, member_subscription>& subscriptions,
+            const std::map<seastar::sstring, int32_t>& partitions_per_topic) = 0;
+    virtual ~partition_assignor() = default;
+};
+
+// Balanced assignment which keeps partitions with their previous owners
+// whenever possible and follows the cooperative rebalancing protocol
+// (KIP-429): a partition which has to move to another member is left
+// unassigned in this generation. Its previous owner revokes it and
+// rejoins, and the follow-up rebalance hands it over. Members never
+// have to give up partitions which are not moving.
+class cooperative_sticky_assignor : public partition_assignor {
+public:
+    seastar::sstring name() const override;
+    assignment assign(const std::map<member_id, member_subscription>& subscriptions,
+            const std::map<seastar::sstring, int32_t>& partitions_per_topic) override;
+};
+
+}
@@ -42,6 +42,8 @@ class kafka_producer final {
     metadata_manager _metadata_manager;
     batcher _batcher;
 
+    partition_state partition_state_of(const metadata_response_partition& partition) const;
+
 public:
     explicit kafka_producer(producer_properties&& properties);
     seastar::future<> init();
@@ -30,6 +30,7 @@
 #include <seastar/util/bool_class.hh>
 #include <seastar/util/noncopyable_function.hh>
 
+#include <kafka4seastar/connection/connection_properties.hh>
 #include <kafka4seastar/utils/defaults.hh>
 #include <kafka4seastar/utils/partitioner.hh>
 
@@ -66,21 +67,26 @@ public:
     uint32_t buffer_memory = 32 * 1024 * 1024;
     // maximum number of retries to be performed before considering the request as failed
     uint32_t retries = 10;
-    // max number of requests in one batch
+    // number of bytes of records without a key sent to a partition
+    // before the default partitioner switches to another one
     uint32_t batch_size = 16384;
     // number of ms after which the connection attempt is considered to have timed out
     uint32_t request_timeout = 500;
     // max time in ms after which a new metadata refresh will be sent, even if no changes have been noticed
     uint32_t metadata_refresh = 300000;
 
+    // Options of the connections to the brokers, e.g. how writes are coalesced or TLS
+    connection_properties connection {};
+
     // Identifier of the created producer instance
     seastar::sstring client_id {};
     // a list of host-port pairs to use for establishing the initial connection to the cluster
     std::set<std::pair<seastar::sstring, uint16_t>> servers {};
 
     // Strategy according to which we should choose the target partition,
-    // based on the given key (or lack thereof)
-    std::unique_ptr<partitioner> partitioning_strategy = defaults::round_robin_partitioner();
+    // based on the given key (or lack thereof), if null the producer uses
+    // defaults::sticky_partitioner(batch_size)
+    std::unique_ptr<partitioner> partitioning_strategy;
     // Strategy describing how long to wait between consecutive retries,
     // based on how many have already been performed
     seastar::noncopyable_function<seastar::future<>(uint32_t)> retry_backoff_strategy = defaults::exp_retry_backoff(20, 1000);
@@ -71,27 +71,27 @@ struct sender_message {
 
 class sender {
 public:
-    using connection_id = std::pair<seastar::sstring, uint16_t>;
     using topic_partition = std::pair<seastar::sstring, int32_t>;
+    // Broker and the lane of its connection pool a request goes through.
+    using destination = std::pair<connection_manager::broker_handle, size_t>;
 
 private:
     connection_manager& _connection_manager;
     metadata_manager& _metadata_manager;
     std::vector<sender_message> _messages;
 
-    std::map<connection_id, std::map<seastar::sstring, std::map<int32_t, std::vector<sender_message*>>>> _messages_split_by_broker_topic_partition;
+    std::map<destination, std::map<seastar::sstring, std::map<int32_t, std::vector<sender_message*>>>> _messages_split_by_broker_topic_partition;
     std::map<topic_partition, std::vector<sender_message*>> _messages_split_by_topic_partition;
-    std::vector<seastar::future<std::pair<connection_id, produce_response>>> _responses;
+    std::vector<seastar::future<std::pair<destination, produce_response>>> _responses;
 
     uint32_t _connection_timeout;
 
     ack_policy _acks;
 
-    std::optional<connection_id> broker_for_topic_partition(const seastar::sstring& topic, int32_t partition_index);
-    connection_id broker_for_id(int32_t id);
+    connection_manager::broker_handle broker_for_topic_partition(const seastar::sstring& topic, int32_t partition_index);
 
-    void set_error_code_for_broker(const connection_id& broker, const error::kafka_error_code& error_code);
-    void set_success_for_broker(const connection_id& broker);
+    void set_error_code_for_broker(const destination& broker, const error::kafka_error_code& error_code);
+    void set_success_for_broker(const destination& broker);
     void set_error_code_for_topic_partition(const seastar::sstring& topic, int32_t partition_index,
             const error::kafka_error_code& error_code);
     void set_success_for_topic_partition(const seastar::sstring& topic, int32_t partition_index);
@@ -99,7 +99,7 @@ private:
     void split_messages();
     void queue_requests();
 
-    void set_error_codes_for_responses(std::vector<seastar::future<std::pair<connection_id, produce_response>>>& responses);
+    void set_error_codes_for_responses(std::vector<seastar::future<std::pair<destination, produce_response>>>& responses);
     void filter_messages();
     seastar::future<> process_messages_errors();
     
@@ -34,7 +34,12 @@ public:
     using response_type = api_versions_response;
     static constexpr int16_t API_KEY = 18;
     static constexpr int16_t MIN_SUPPORTED_VERSION = 0;
-    static constexpr int16_t MAX_SUPPORTED_VERSION = 2;
+    static constexpr int16_t MAX_SUPPORTED_VERSION = 3;
+    static constexpr int16_t FIRST_FLEXIBLE_VERSION = 3;
+
+    kafka_string_t client_software_name{"kafka4seastar"};
+    kafka_string_t client_software_version{"1.0"};
+    kafka_tagged_fields_t tagged_fields;
 
     void serialize(std::ostream& os, int16_t api_version) const;
     void deserialize(std::istream& is, int16_t api_version);
@@ -36,6 +36,7 @@ public:
     kafka_int16_t api_key;
     kafka_int16_t min_version;
     kafka_int16_t max_version;
+    kafka_tagged_fields_t tagged_fields;
 
     bool operator<(const api_versions_response_key& other) const noexcept;
     bool operator<(int16_t api_key) const noexcept;
@@ -47,9 +48,12 @@ public:
 
 class api_versions_response {
 public:
+    static constexpr int16_t FIRST_FLEXIBLE_VERSION = 3;
+
     kafka_error_code_t error_code;
     kafka_array_t<api_versions_response_key> api_keys;
     kafka_int32_t throttle_time_ms;
+    kafka_tagged_fields_t tagged_fields;
 
     template<typename RequestType>
     int16_t max_version() const {
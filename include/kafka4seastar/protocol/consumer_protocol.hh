@@ -0,0 +1,77 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (C) 2019 ScyllaDB Ltd.
+ */
+
+
+#pragma once
+
+#include <kafka4seastar/protocol/kafka_primitives.hh>
+
+namespace kafka4seastar {
+
+// Schemas of the opaque metadata and assignment bytes exchanged
+// through JoinGroup and SyncGroup by members using the "consumer"
+// protocol type. Both start with their own version, which is
+// written by serialize() and read back by deserialize(), so the
+// api_version passed to deserialize() is ignored. Newer versions
+// only append fields, so they can always be read as older ones.
+
+class consumer_protocol_topic_partitions {
+public:
+    kafka_string_t topic;
+    kafka_array_t<kafka_int32_t> partitions;
+
+    void serialize(std::ostream& os, int16_t api_version) const;
+
+    void deserialize(std::istream& is, int16_t api_version);
+};
+
+class consumer_protocol_subscription {
+public:
+    static constexpr auto PROTOCOL_TYPE = "consumer";
+    // Version 1 adds owned partitions, required by
+    // the cooperative rebalancing protocol (KIP-429).
+    static constexpr int16_t MAX_SUPPORTED_VERSION = 1;
+
+    kafka_int16_t version;
+    kafka_array_t<kafka_string_t> topics;
+    kafka_nullable_bytes_t user_data;
+    kafka_array_t<consumer_protocol_topic_partitions> owned_partitions;
+
+    void serialize(std::ostream& os, int16_t api_version) const;
+
+    void deserialize(std::istream& is, int16_t api_version);
+};
+
+class consumer_protocol_assignment {
+public:
+    static constexpr int16_t MAX_SUPPORTED_VERSION = 1;
+
+    kafka_int16_t version;
+    kafka_array_t<consumer_protocol_topic_partitions> assigned_partitions;
+    kafka_nullable_bytes_t user_data;
+
+    void serialize(std::ostream& os, int16_t api_version) const;
+
+    void deserialize(std::istream& is, int16_t api_version);
+};
+
+}
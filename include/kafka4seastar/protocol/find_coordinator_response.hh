@@ -0,0 +1,44 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (C) 2019 ScyllaDB Ltd.
+ */
+
+
+#pragma once
+
+#include <kafka4seastar/protocol/kafka_primitives.hh>
+
+namespace kafka4seastar {
+
+class find_coordinator_response {
+public:
+    kafka_int32_t throttle_time_ms;
+    kafka_error_code_t error_code;
+    kafka_nullable_string_t error_message;
+    kafka_int32_t node_id;
+    kafka_string_t host;
+    kafka_int32_t port;
+
+    void serialize(std::ostream& os, int16_t api_version) const;
+
+    void deserialize(std::istream& is, int16_t api_version);
+};
+
+}
@@ -23,28 +23,51 @@
 #pragma once
 
 #include <kafka4seastar/protocol/kafka_primitives.hh>
+#include <kafka4seastar/protocol/api_versions_request.hh>
+
+#include <type_traits>
 
 namespace kafka4seastar {
 
+// The headers are serialized with their own versions, not the ones of the
+// messages: flexible versions of the messages use request header version 2
+// and response header version 1, which end with tagged fields.
 class request_header {
 public:
     kafka_int16_t api_key;
     kafka_int16_t api_version;
     kafka_int32_t correlation_id;
     kafka_nullable_string_t client_id;
+    kafka_tagged_fields_t tagged_fields;
 
-    void serialize(std::ostream& os, int16_t api_version) const;
+    void serialize(std::ostream& os, int16_t header_version) const;
 
-    void deserialize(std::istream& is, int16_t api_version);
+    void deserialize(std::istream& is, int16_t header_version);
 };
 
 class response_header {
 public:
     kafka_int32_t correlation_id;
+    kafka_tagged_fields_t tagged_fields;
 
-    void serialize(std::ostream& os, int16_t api_version) const;
+    void serialize(std::ostream& os, int16_t header_version) const;
 
-    void deserialize(std::istream& is, int16_t api_version);
+    void deserialize(std::istream& is, int16_t header_version);
 };
 
+template<typename RequestType>
+constexpr int16_t request_header_version(int16_t api_version) noexcept {
+    return api_version >= first_flexible_version<RequestType>::value ? 2 : 1;
+}
+
+template<typename RequestType>
+constexpr int16_t response_header_version(int16_t api_version) noexcept {
+    // The header of ApiVersions responses is never flexible, so that clients
+    // can read it before they know which versions the broker supports.
+    if constexpr (std::is_same_v<RequestType, api_versions_request>) {
+        return 0;
+    }
+    return api_version >= first_flexible_version<typename RequestType::response_type>::value ? 1 : 0;
+}
+
 }
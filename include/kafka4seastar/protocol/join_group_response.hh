@@ -0,0 +1,56 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (C) 2019 ScyllaDB Ltd.
+ */
+
+
+#pragma once
+
+#include <kafka4seastar/protocol/kafka_primitives.hh>
+
+namespace kafka4seastar {
+
+class join_group_response_member {
+public:
+    kafka_string_t member_id;
+    kafka_nullable_string_t group_instance_id;
+    kafka_bytes_t metadata;
+
+    void serialize(std::ostream& os, int16_t api_version) const;
+
+    void deserialize(std::istream& is, int16_t api_version);
+};
+
+class join_group_response {
+public:
+    kafka_int32_t throttle_time_ms;
+    kafka_error_code_t error_code;
+    kafka_int32_t generation_id;
+    kafka_string_t protocol_name;
+    kafka_string_t leader;
+    kafka_string_t member_id;
+    kafka_array_t<join_group_response_member> members;
+
+    void serialize(std::ostream& os, int16_t api_version) const;
+
+    void deserialize(std::istream& is, int16_t api_version);
+};
+
+}
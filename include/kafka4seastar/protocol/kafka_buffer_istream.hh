@@ -0,0 +1,81 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (C) 2019 ScyllaDB Ltd.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <istream>
+#include <streambuf>
+
+// Input stream reading a buffer in place, so that responses are deserialized
+// straight out of the frames they were received in. The stream is reused
+// for consecutive buffers, which spares setting up a stream (and its locale)
+// for every response, and keeps the decode limits applied to it.
+
+namespace kafka4seastar {
+
+class kafka_buffer_istream final : public std::istream {
+    class buffer final : public std::streambuf {
+    public:
+        void reset(const char* data, size_t size) noexcept {
+            auto begin = const_cast<char*>(data);
+            setg(begin, begin, begin + size);
+        }
+
+    protected:
+        pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode which) override {
+            if (!(which & std::ios_base::in)) {
+                return pos_type(off_type(-1));
+            }
+            off_type size = egptr() - eback();
+            off_type base = direction == std::ios_base::beg ? 0
+                            : direction == std::ios_base::cur ? gptr() - eback()
+                            : size;
+            auto position = base + offset;
+            if (position < 0 || position > size) {
+                return pos_type(off_type(-1));
+            }
+            setg(eback(), eback() + position, egptr());
+            return pos_type(position);
+        }
+
+        pos_type seekpos(pos_type position, std::ios_base::openmode which) override {
+            return seekoff(off_type(position), std::ios_base::beg, which);
+        }
+    };
+
+    buffer _buffer;
+
+public:
+    kafka_buffer_istream() : std::istream(nullptr) {
+        rdbuf(&_buffer);
+    }
+
+    // Points the stream at the beginning of the buffer and clears the state
+    // left by the previous one. The buffer has to outlive its reads.
+    void reset(const char* data, size_t size) {
+        _buffer.reset(data, size);
+        clear();
+    }
+};
+
+}
@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include <array>
 #include <string>
 #include <cstdint>
 #include <seastar/core/sstring.hh>
@@ -37,6 +38,117 @@ using is_retriable = seastar::bool_class<is_retriable_tag>;
 struct invalidates_metadata_tag {};
 using should_invalidate_metadata = seastar::bool_class<invalidates_metadata_tag>;
 
+// Properties of the error codes, indexed by code - MIN_ERROR_CODE, so
+// that they can be checked without looking up the kafka_error_code.
+struct error_traits {
+    bool retriable;
+    bool invalidates_metadata;
+};
+
+constexpr int16_t MIN_ERROR_CODE = -1;
+constexpr int16_t MAX_ERROR_CODE = 87;
+constexpr size_t ERROR_CODE_COUNT = MAX_ERROR_CODE - MIN_ERROR_CODE + 1;
+
+inline constexpr std::array<error_traits, ERROR_CODE_COUNT> ERROR_TRAITS = {{
+    {false, false}, // -1 UNKNOWN_SERVER_ERROR
+    {false, false}, // 0 NONE
+    {false, false}, // 1 OFFSET_OUT_OF_RANGE
+    {true, false}, // 2 CORRUPT_MESSAGE
+    {true, true}, // 3 UNKNOWN_TOPIC_OR_PARTITION
+    {false, false}, // 4 INVALID_FETCH_SIZE
+    {true, true}, // 5 LEADER_NOT_AVAILABLE
+    {true, true}, // 6 NOT_LEADER_FOR_PARTITION
+    {true, false}, // 7 REQUEST_TIMED_OUT
+    {false, false}, // 8 BROKER_NOT_AVAILABLE
+    {false, false}, // 9 REPLICA_NOT_AVAILABLE
+    {false, false}, // 10 MESSAGE_TOO_LARGE
+    {false, false}, // 11 STALE_CONTROLLER_EPOCH
+    {false, false}, // 12 OFFSET_METADATA_TOO_LARGE
+    {true, true}, // 13 NETWORK_EXCEPTION
+    {true, false}, // 14 COORDINATOR_LOAD_IN_PROGRESS
+    {true, false}, // 15 COORDINATOR_NOT_AVAILABLE
+    {true, false}, // 16 NOT_COORDINATOR
+    {false, false}, // 17 INVALID_TOPIC_EXCEPTION
+    {false, false}, // 18 RECORD_LIST_TOO_LARGE
+    {true, false}, // 19 NOT_ENOUGH_REPLICAS
+    {true, false}, // 20 NOT_ENOUGH_REPLICAS_AFTER_APPEND
+    {false, false}, // 21 INVALID_REQUIRED_ACKS
+    {false, false}, // 22 ILLEGAL_GENERATION
+    {false, false}, // 23 INCONSISTENT_PROTOCOL
+    {false, false}, // 24 INVALID_GROUP_ID
+    {false, false}, // 25 UNKNOWN_MEMBER_ID
+    {false, false}, // 26 INVALID_SESSION_TIMEOUT
+    {false, false}, // 27 REBALANCE_IN_PROGRESS
+    {false, false}, // 28 INVALID_COMMIT_OFFSET_SIZE
+    {false, false}, // 29 TOPIC_AUTHORIZATION_FAILED
+    {false, false}, // 30 GROUP_AUTHORIZATION_FAILED
+    {false, false}, // 31 CLUSTER_AUTHORIZATION_FAILED
+    {false, false}, // 32 INVALID_TIMESTAMP
+    {false, false}, // 33 UNSUPPORTED_SASL_MECHANISM
+    {false, false}, // 34 ILLEGAL_SASL_STATE
+    {false, false}, // 35 UNSUPPORTED_VERSION
+    {false, false}, // 36 TOPIC_ALREADY_EXISTS
+    {false, false}, // 37 INVALID_PARTITIONS
+    {false, false}, // 38 INVALID_REPLICATION_FACTOR
+    {false, false}, // 39 INVALID_REPLICA_ASSIGNMENT
+    {false, false}, // 40 INVALID_CONFIG
+    {true, false}, // 41 NOT_CONTROLLER
+    {false, false}, // 42 INVALID_REQUEST
+    {false, false}, // 43 UNSUPPORTED_FOR_MESSAGE_FORMAT
+    {false, false}, // 44 POLICY_VIOLATION
+    {false, false}, // 45 OUT_OF_ORDER_SEQUENCE_NUMBER
+    {false, false}, // 46 DUPLICATE_SEQUENCE_NUMBER
+    {false, false}, // 47 INVALID_PRODUCER_EPOCH
+    {false, false}, // 48 INVALID_TXN_STATE
+    {false, false}, // 49 INVALID_PRODUCER_ID_MAPPING
+    {false, false}, // 50 INVALID_TRANSACTION_TIMEOUT
+    {false, false}, // 51 CONCURRENT_TRANSACTIONS
+    {false, false}, // 52 TRANSACTION_COORDINATOR_FENCED
+    {false, false}, // 53 TRANSACTIONAL_ID_AUTHORIZATION_FAILED
+    {false, false}, // 54 SECURITY_DISABLED
+    {false, false}, // 55 OPERATION_NOT_ATTEMPTED
+    {true, true}, // 56 KAFKA_STORAGE_ERROR
+    {false, false}, // 57 LOG_DIR_NOT_FOUND
+    {false, false}, // 58 SASL_AUTHENTICATION_FAILED
+    {false, false}, // 59 UNKNOWN_PRODUCER_ID
+    {false, false}, // 60 REASSIGNMENT_IN_PROGRESS
+    {false, false}, // 61 DELEGATION_TOKEN_AUTH_DISABLED
+    {false, false}, // 62 DELEGATION_TOKEN_NOT_FOUND
+    {false, false}, // 63 DELEGATION_TOKEN_OWNER_MISMATCH
+    {false, false}, // 64 DELEGATION_TOKEN_REQUEST_NOT_ALLOWED
+    {false, false}, // 65 DELEGATION_TOKEN_AUTHORIZATION_FAILED
+    {false, false}, // 66 DELEGATION_TOKEN_EXPIRED
+    {false, false}, // 67 INVALID_PRINCIPAL_TYPE
+    {false, false}, // 68 NON_EMPTY_GROUP
+    {false, false}, // 69 GROUP_ID_NOT_FOUND
+    {true, false}, // 70 FETCH_SESSION_ID_NOT_FOUND
+    {true, false}, // 71 INVALID_FETCH_SESSION_EPOCH
+    {true, true}, // 72 LISTENER_NOT_FOUND
+    {false, false}, // 73 TOPIC_DELETION_DISABLED
+    {true, true}, // 74 FENCED_LEADER_EPOCH
+    {true, false}, // 75 UNKNOWN_LEADER_EPOCH
+    {false, false}, // 76 UNSUPPORTED_COMPRESSION_TYPE
+    {false, false}, // 77 STALE_BROKER_EPOCH
+    {true, false}, // 78 OFFSET_NOT_AVAILABLE
+    {false, false}, // 79 MEMBER_ID_REQUIRED
+    {true, true}, // 80 PREFERRED_LEADER_NOT_AVAILABLE
+    {false, false}, // 81 GROUP_MAX_SIZE_REACHED
+    {false, false}, // 82 FENCED_INSTANCE_ID
+    {true, true}, // 83 ELIGIBLE_LEADERS_NOT_AVAILABLE
+    {true, true}, // 84 ELECTION_NOT_NEEDED
+    {false, false}, // 85 NO_REASSIGNMENT_IN_PROGRESS
+    {false, false}, // 86 GROUP_SUBSCRIBED_TO_TOPIC
+    {false, false}, // 87 INVALID_RECORD
+}};
+
+constexpr bool is_known_error(int16_t code) noexcept {
+    return code >= MIN_ERROR_CODE && code <= MAX_ERROR_CODE;
+}
+
+constexpr const error_traits& traits_of(int16_t code) noexcept {
+    return ERROR_TRAITS[code - MIN_ERROR_CODE];
+}
+
 class kafka_error_code {
 
 public:
@@ -46,13 +158,10 @@ public:
     is_retriable retriable;
     should_invalidate_metadata invalidates_metadata;
 
-    kafka_error_code(
-        int16_t error_code,
-        seastar::sstring error_message,
-        is_retriable retriable,
-        should_invalidate_metadata invalidates_metadata);
+    kafka_error_code(int16_t error_code, seastar::sstring error_message);
 
-    static const kafka_error_code& get_error(int16_t value);
+    // UNKNOWN_SERVER_ERROR if the code is not known.
+    static const kafka_error_code& get_error(int16_t value) noexcept;
 
     static const kafka_error_code UNKNOWN_SERVER_ERROR;
     static const kafka_error_code NONE;
@@ -26,13 +26,17 @@
 #include <ostream>
 #include <istream>
 #include <array>
+#include <limits>
 #include <vector>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
 
 #include <seastar/net/byteorder.hh>
 #include <seastar/core/bitops.hh>
 
 #include <kafka4seastar/protocol/kafka_error_code.hh>
+#include <kafka4seastar/protocol/kafka_varint.hh>
 
 namespace kafka4seastar {
 
@@ -52,6 +56,53 @@ public:
     parsing_exception(const seastar::sstring& message) : runtime_error(message) {}
 };
 
+// Limits of the lengths read from the input, checked before anything is
+// allocated for them. Lengths are checked against the input remaining in
+// the stream as well, so that a corrupt length fails the decoding instead
+// of allocating memory for data which is not there. Responses are always
+// decoded from memory, where the whole input is available upfront.
+struct decode_limits {
+    // max length of a single string or bytes field
+    size_t max_string_length = std::numeric_limits<int32_t>::max();
+    // max number of elements of a single array
+    size_t max_array_length = std::numeric_limits<int32_t>::max();
+
+    // Makes the deserialization from the stream use these limits,
+    // they have to outlive it. Streams without them are only
+    // checked against the remaining input.
+    void apply(std::ios_base& stream) const noexcept {
+        stream.pword(index()) = const_cast<decode_limits*>(this);
+    }
+
+    static const decode_limits& of(std::ios_base& stream) noexcept {
+        static const decode_limits defaults;
+        auto limits = static_cast<const decode_limits*>(stream.pword(index()));
+        return limits ? *limits : defaults;
+    }
+
+private:
+    static int index() noexcept {
+        static const int index = std::ios_base::xalloc();
+        return index;
+    }
+};
+
+namespace details {
+
+    // Throws if a length just read from the stream exceeds the limit
+    // or the number of bytes remaining in the stream (every element
+    // of an array takes up at least one).
+    inline void check_length(std::istream& is, size_t length, size_t limit, const char* what) {
+        if (length > limit) {
+            throw parsing_exception(seastar::sstring("Length of ") + what + " exceeds the limit");
+        }
+        if (static_cast<std::streamsize>(length) > is.rdbuf()->in_avail()) {
+            throw parsing_exception(seastar::sstring("Stream ended prematurely when reading ") + what);
+        }
+    }
+
+}
+
 template<typename NumberType>
 class kafka_number_t {
 private:
@@ -72,6 +123,10 @@ public:
         return *this;
     }
 
+    [[nodiscard]] static constexpr size_t serialized_size(int16_t api_version) noexcept {
+        return NUMBER_SIZE;
+    }
+
     void serialize(std::ostream& os, int16_t api_version) const {
         std::array<char, NUMBER_SIZE> buffer{};
         auto value = seastar::net::hton(_value);
@@ -91,14 +146,26 @@ public:
     }
 };
 
+// Keeps the traits of the error next to its code, so that checking
+// them doesn't look up the kafka_error_code.
 class kafka_error_code_t {
 private:
     int16_t _value;
+    error::error_traits _traits;
     static constexpr auto NUMBER_SIZE = sizeof(int16_t);
 
 public:
-    kafka_error_code_t() noexcept : _value(0) {}
-    kafka_error_code_t(const error::kafka_error_code& error) noexcept : _value(error.error_code) {}
+    kafka_error_code_t() noexcept : _value(0), _traits(error::traits_of(0)) {}
+    kafka_error_code_t(const error::kafka_error_code& error) noexcept
+        : _value(error.error_code), _traits(error::traits_of(error.error_code)) {}
+
+    [[nodiscard]] bool retriable() const noexcept {
+        return _traits.retriable;
+    }
+
+    [[nodiscard]] bool invalidates_metadata() const noexcept {
+        return _traits.invalidates_metadata;
+    }
 
     [[nodiscard]] const error::kafka_error_code& operator*() const noexcept {
         return error::kafka_error_code::get_error(_value);
@@ -110,9 +177,14 @@ public:
 
     kafka_error_code_t& operator=(const error::kafka_error_code& error) noexcept {
         _value = error.error_code;
+        _traits = error::traits_of(_value);
         return *this;
     }
 
+    [[nodiscard]] static constexpr size_t serialized_size(int16_t api_version) noexcept {
+        return NUMBER_SIZE;
+    }
+
     void serialize(std::ostream& os, int16_t api_version) const {
         std::array<char, NUMBER_SIZE> buffer{};
         auto value = seastar::net::hton(_value);
@@ -129,11 +201,10 @@ public:
             throw parsing_exception("Stream ended prematurely when reading number");
         }
         _value = seastar::net::ntoh(*reinterpret_cast<int16_t*>(buffer.data()));
-        try {
-            error::kafka_error_code::get_error(_value);
-        } catch (const std::out_of_range& e) {
+        if (!error::is_known_error(_value)) {
             throw parsing_exception("Error with such code does not exist");
         }
+        _traits = error::traits_of(_value);
     }
 
     bool operator==(const error::kafka_error_code& other) const {
@@ -152,56 +223,149 @@ using kafka_int64_t = kafka_number_t<int64_t>;
 using kafka_uint32_t = kafka_number_t<uint32_t>;
 using kafka_bool_t = kafka_number_t<uint8_t>;
 
-class kafka_varint_t {
+namespace details {
+
+// Reads the bytes of a single varint, up to the first one without the
+// continuation bit or max_size of them, returning how many were read.
+inline size_t read_varint(std::istream& is, char* buffer, size_t max_size) {
+    auto stream_buffer = is.rdbuf();
+    for (size_t i = 0; i < max_size; i++) {
+        auto current_byte = stream_buffer->sbumpc();
+        if (current_byte == std::istream::traits_type::eof()) {
+            is.setstate(std::ios_base::eofbit | std::ios_base::failbit);
+            throw parsing_exception("Stream ended prematurely when reading varint");
+        }
+        buffer[i] = static_cast<char>(current_byte);
+        if (!(current_byte & 0x80)) {
+            return i + 1;
+        }
+    }
+    return max_size;
+}
+
+}
+
+// Zigzag encoded varint (32-bit) or varlong (64-bit) of the record format.
+template<typename IntegerType>
+class kafka_signed_varint_t {
+private:
+    static_assert(std::is_same_v<IntegerType, int32_t> || std::is_same_v<IntegerType, int64_t>,
+            "Only 32-bit and 64-bit varints are supported");
+    static constexpr size_t MAX_SIZE = sizeof(IntegerType) == sizeof(int32_t) ? MAX_VARINT_SIZE : MAX_VARLONG_SIZE;
+
+    IntegerType _value;
+public:
+    kafka_signed_varint_t() noexcept : kafka_signed_varint_t(0) {}
+
+    explicit kafka_signed_varint_t(IntegerType value) noexcept : _value(value) {}
+
+    [[nodiscard]] const IntegerType& operator*() const noexcept { return _value; }
+
+    [[nodiscard]] IntegerType& operator*() noexcept { return _value; }
+
+    kafka_signed_varint_t& operator=(IntegerType value) noexcept {
+        _value = value;
+        return *this;
+    }
+
+    [[nodiscard]] size_t serialized_size(int16_t api_version) const noexcept {
+        return unsigned_varint_size(zigzag_encode(_value));
+    }
+
+    void serialize(std::ostream& os, int16_t api_version) const {
+        std::array<char, MAX_SIZE> buffer;
+        auto end = encode_unsigned_varint(zigzag_encode(_value), buffer.data());
+        os.write(buffer.data(), end - buffer.data());
+    }
+
+    void deserialize(std::istream& is, int16_t api_version) {
+        std::array<char, MAX_SIZE> buffer;
+        auto size = details::read_varint(is, buffer.data(), MAX_SIZE);
+        const char* position = buffer.data();
+        bool decoded;
+        if constexpr (std::is_same_v<IntegerType, int32_t>) {
+            decoded = decode_varint(position, buffer.data() + size, _value);
+        } else {
+            decoded = decode_varlong(position, buffer.data() + size, _value);
+        }
+        if (!decoded) {
+            throw parsing_exception(sizeof(IntegerType) == sizeof(int32_t)
+                    ? "Deserialized varint is larger than 32 bits"
+                    : "Deserialized varlong is larger than 64 bits");
+        }
+    }
+};
+
+using kafka_varint_t = kafka_signed_varint_t<int32_t>;
+using kafka_varlong_t = kafka_signed_varint_t<int64_t>;
+
+class kafka_unsigned_varint_t {
+private:
+    uint32_t _value;
+public:
+    kafka_unsigned_varint_t() noexcept : kafka_unsigned_varint_t(0) {}
+
+    explicit kafka_unsigned_varint_t(uint32_t value) noexcept : _value(value) {}
+
+    [[nodiscard]] const uint32_t& operator*() const noexcept { return _value; }
+
+    [[nodiscard]] uint32_t& operator*() noexcept { return _value; }
+
+    kafka_unsigned_varint_t& operator=(uint32_t value) noexcept {
+        _value = value;
+        return *this;
+    }
+
+    [[nodiscard]] size_t serialized_size(int16_t api_version) const noexcept {
+        return unsigned_varint_size(_value);
+    }
+
+    void serialize(std::ostream& os, int16_t api_version) const {
+        std::array<char, MAX_VARINT_SIZE> buffer;
+        auto end = encode_unsigned_varint(_value, buffer.data());
+        os.write(buffer.data(), end - buffer.data());
+    }
+
+    void deserialize(std::istream& is, int16_t api_version) {
+        std::array<char, MAX_VARINT_SIZE> buffer;
+        auto size = details::read_varint(is, buffer.data(), MAX_VARINT_SIZE);
+        const char* position = buffer.data();
+        if (!decode_unsigned_varint(position, buffer.data() + size, _value)) {
+            throw parsing_exception("Deserialized unsigned varint is larger than 32 bits");
+        }
+    }
+};
+
+// Length of the compact strings, bytes and arrays of flexible versions,
+// written as an unsigned varint of the length plus one, so that -1 (null)
+// takes up a single zero byte.
+class kafka_compact_length_t {
 private:
     int32_t _value;
 public:
-    kafka_varint_t() noexcept : kafka_varint_t(0) {}
+    kafka_compact_length_t() noexcept : kafka_compact_length_t(0) {}
 
-    explicit kafka_varint_t(int32_t value) noexcept : _value(value) {}
+    explicit kafka_compact_length_t(int32_t value) noexcept : _value(value) {}
 
     [[nodiscard]] const int32_t& operator*() const noexcept { return _value; }
 
     [[nodiscard]] int32_t& operator*() noexcept { return _value; }
 
-    kafka_varint_t& operator=(int32_t value) noexcept {
-        _value = value;
-        return *this;
+    [[nodiscard]] size_t serialized_size(int16_t api_version) const noexcept {
+        return kafka_unsigned_varint_t(static_cast<uint32_t>(_value) + 1).serialized_size(api_version);
     }
 
     void serialize(std::ostream& os, int16_t api_version) const {
-        auto current_value = (static_cast<uint32_t>(_value) << 1) ^ static_cast<uint32_t>(_value >> 31);
-        do {
-            uint8_t current_byte = current_value & 0x7F;
-            current_value >>= 7;
-            if (current_value != 0) {
-                current_byte |= 0x80;
-            }
-            os.write(reinterpret_cast<const char*>(&current_byte), 1);
-        } while (current_value != 0);
+        kafka_unsigned_varint_t(static_cast<uint32_t>(_value) + 1).serialize(os, api_version);
     }
 
     void deserialize(std::istream& is, int16_t api_version) {
-        uint32_t current_value = 0;
-        int32_t current_offset = 0;
-        char current_byte = 0;
-        do {
-            is.read(&current_byte, 1);
-            if (is.gcount() != 1) {
-                throw parsing_exception("Stream ended prematurely when reading varint");
-            }
-            if (current_byte == 0) {
-                break;
-            }
-            auto max_bit_write = current_offset + 32 -  seastar::count_leading_zeros(static_cast<unsigned int>(static_cast<uint8_t>(current_byte)));
-            if (max_bit_write > 32) {
-                throw parsing_exception("Deserialized varint is larger than 32 bits");
-            }
-            current_value |= static_cast<int32_t>(current_byte & 0x7F) << current_offset;
-            current_offset += 7;
-        } while (current_byte & 0x80);
-        current_value = (current_value >> 1) ^ -(current_value & 1);
-        _value = current_value;
+        kafka_unsigned_varint_t length;
+        length.deserialize(is, api_version);
+        if (*length > static_cast<uint32_t>(std::numeric_limits<int32_t>::max()) + 1) {
+            throw parsing_exception("Compact length is too large");
+        }
+        _value = static_cast<int32_t>(*length - 1);
     }
 };
 
@@ -232,20 +396,46 @@ public:
         return *this;
     }
 
-    void serialize(std::ostream& os, int16_t api_version) const {
-        SizeType length(_value.size());
+    [[nodiscard]] size_t serialized_size(int16_t api_version, bool compact = false) const noexcept {
+        if (compact) {
+            return kafka_compact_length_t(_value.size()).serialized_size(api_version) + _value.size();
+        }
+        return SizeType::serialized_size(api_version) + _value.size();
+    }
+
+    void serialize(std::ostream& os, int16_t api_version, bool compact = false) const {
+        if (compact) {
+            serialize_with<kafka_compact_length_t>(os, api_version);
+        } else {
+            serialize_with<SizeType>(os, api_version);
+        }
+    }
+
+    void deserialize(std::istream& is, int16_t api_version, bool compact = false) {
+        if (compact) {
+            deserialize_with<kafka_compact_length_t>(is, api_version);
+        } else {
+            deserialize_with<SizeType>(is, api_version);
+        }
+    }
+
+private:
+    template<typename LengthType>
+    void serialize_with(std::ostream& os, int16_t api_version) const {
+        LengthType length(_value.size());
         length.serialize(os, api_version);
 
         os.write(_value.data(), _value.size());
     }
 
-    void deserialize(std::istream& is, int16_t api_version) {
-        SizeType length;
+    template<typename LengthType>
+    void deserialize_with(std::istream& is, int16_t api_version) {
+        LengthType length;
         length.deserialize(is, api_version);
-        // TODO: Max length check
         if (*length < 0) {
             throw parsing_exception("Length of buffer is negative");
         }
+        details::check_length(is, *length, decode_limits::of(is).max_string_length, "buffer");
 
         seastar::sstring value;
         value.resize(*length);
@@ -303,23 +493,50 @@ public:
         return *this;
     }
 
-    void serialize(std::ostream& os, int16_t api_version) const {
+    [[nodiscard]] size_t serialized_size(int16_t api_version, bool compact = false) const noexcept {
+        auto size = _value ? _value->size() : 0;
+        if (compact) {
+            return kafka_compact_length_t(_value ? size : -1).serialized_size(api_version) + size;
+        }
+        return SizeType::serialized_size(api_version) + size;
+    }
+
+    void serialize(std::ostream& os, int16_t api_version, bool compact = false) const {
+        if (compact) {
+            serialize_with<kafka_compact_length_t>(os, api_version);
+        } else {
+            serialize_with<SizeType>(os, api_version);
+        }
+    }
+
+    void deserialize(std::istream& is, int16_t api_version, bool compact = false) {
+        if (compact) {
+            deserialize_with<kafka_compact_length_t>(is, api_version);
+        } else {
+            deserialize_with<SizeType>(is, api_version);
+        }
+    }
+
+private:
+    template<typename LengthType>
+    void serialize_with(std::ostream& os, int16_t api_version) const {
         if (!_value) {
-            SizeType null_indicator(-1);
+            LengthType null_indicator(-1);
             null_indicator.serialize(os, api_version);
         } else {
-            SizeType length(_value->size());
+            LengthType length(_value->size());
             length.serialize(os, api_version);
             os.write(_value->data(), _value->size());
         }
     }
 
-    void deserialize(std::istream& is, int16_t api_version) {
-        SizeType length;
+    template<typename LengthType>
+    void deserialize_with(std::istream& is, int16_t api_version) {
+        LengthType length;
         length.deserialize(is, api_version);
         if (*length >= 0) {
+            details::check_length(is, *length, decode_limits::of(is).max_string_length, "nullable buffer");
             seastar::sstring value;
-            // TODO: Max length check
             value.resize(*length);
             is.read(value.data(), *length);
 
@@ -341,6 +558,20 @@ using kafka_nullable_string_t = kafka_nullable_buffer_t<kafka_int16_t>;
 using kafka_bytes_t = kafka_buffer_t<kafka_int32_t>;
 using kafka_nullable_bytes_t = kafka_nullable_buffer_t<kafka_int32_t>;
 
+namespace details {
+
+    // Strings and bytes inside of compact arrays are compact as well.
+    template<typename T>
+    struct is_buffer : std::false_type {};
+
+    template<typename SizeType>
+    struct is_buffer<kafka_buffer_t<SizeType>> : std::true_type {};
+
+    template<typename SizeType>
+    struct is_buffer<kafka_nullable_buffer_t<SizeType>> : std::true_type {};
+
+}
+
 template<typename ElementType, typename ElementCountType = kafka_int32_t>
 class kafka_array_t {
 private:
@@ -397,35 +628,193 @@ public:
         _elems = {};
     }
 
-    void serialize(std::ostream& os, int16_t api_version) const {
-        if (!_elems) {
-            ElementCountType null_indicator(-1);
-            null_indicator.serialize(os, api_version);
+    [[nodiscard]] size_t serialized_size(int16_t api_version, bool compact = false) const {
+        size_t size = length_size(api_version, compact);
+        if (_elems) {
+            for (const auto& elem : *_elems) {
+                if constexpr (details::is_buffer<ElementType>::value) {
+                    size += elem.serialized_size(api_version, compact);
+                } else {
+                    size += elem.serialized_size(api_version);
+                }
+            }
+        }
+        return size;
+    }
+
+    void serialize(std::ostream& os, int16_t api_version, bool compact = false) const {
+        serialize_length(os, api_version, compact);
+        if (_elems) {
+            for (const auto& elem : *_elems) {
+                if constexpr (details::is_buffer<ElementType>::value) {
+                    elem.serialize(os, api_version, compact);
+                } else {
+                    elem.serialize(os, api_version);
+                }
+            }
+        }
+    }
+
+    void deserialize(std::istream& is, int16_t api_version, bool compact = false) {
+        auto length = deserialize_length(is, api_version, compact);
+        if (length >= 0) {
+            std::vector<ElementType> elems(length);
+            for (int32_t i = 0; i < length; i++) {
+                if constexpr (details::is_buffer<ElementType>::value) {
+                    elems[i].deserialize(is, api_version, compact);
+                } else {
+                    elems[i].deserialize(is, api_version);
+                }
+            }
+            _elems = std::move(elems);
         } else {
-            ElementCountType length(_elems->size());
-            length.serialize(os, api_version);
+            set_null();
+        }
+    }
+
+    // The overloads below are used by the generated messages, whose
+    // structures are serialized with the version fixed at compile time.
+    template<int16_t Version>
+    [[nodiscard]] size_t serialized_size(bool compact = false) const {
+        size_t size = length_size(Version, compact);
+        if (_elems) {
             for (const auto& elem : *_elems) {
-                elem.serialize(os, api_version);
+                size += elem.template serialized_size<Version>();
             }
         }
+        return size;
     }
 
-    void deserialize(std::istream& is, int16_t api_version) {
-        ElementCountType length;
-        length.deserialize(is, api_version);
-        if (*length >= 0) {
-            // TODO: Max length check
-            std::vector<ElementType> elems(*length);
-            for (int32_t i = 0; i < *length; i++) {
-                elems[i].deserialize(is, api_version);
+    template<int16_t Version>
+    void serialize(std::ostream& os, bool compact = false) const {
+        serialize_length(os, Version, compact);
+        if (_elems) {
+            for (const auto& elem : *_elems) {
+                elem.template serialize<Version>(os);
+            }
+        }
+    }
+
+    template<int16_t Version>
+    void deserialize(std::istream& is, bool compact = false) {
+        auto length = deserialize_length(is, Version, compact);
+        if (length >= 0) {
+            std::vector<ElementType> elems(length);
+            for (int32_t i = 0; i < length; i++) {
+                elems[i].template deserialize<Version>(is);
             }
             _elems = std::move(elems);
-        } else if (*length == -1) {
+        } else {
             set_null();
+        }
+    }
+
+private:
+    [[nodiscard]] size_t length_size(int16_t api_version, bool compact) const noexcept {
+        int32_t length = _elems ? _elems->size() : -1;
+        if (compact) {
+            return kafka_compact_length_t(length).serialized_size(api_version);
+        }
+        return ElementCountType(length).serialized_size(api_version);
+    }
+
+    void serialize_length(std::ostream& os, int16_t api_version, bool compact) const {
+        int32_t length = _elems ? _elems->size() : -1;
+        if (compact) {
+            kafka_compact_length_t(length).serialize(os, api_version);
         } else {
+            ElementCountType(length).serialize(os, api_version);
+        }
+    }
+
+    // Returns -1 for null arrays.
+    int32_t deserialize_length(std::istream& is, int16_t api_version, bool compact) const {
+        int32_t length;
+        if (compact) {
+            kafka_compact_length_t compact_length;
+            compact_length.deserialize(is, api_version);
+            length = *compact_length;
+        } else {
+            ElementCountType count;
+            count.deserialize(is, api_version);
+            length = *count;
+        }
+        if (length < -1) {
             throw parsing_exception("Length of array is invalid");
         }
+        if (length > 0) {
+            details::check_length(is, length, decode_limits::of(is).max_array_length, "array");
+        }
+        return length;
     }
 };
 
+// Tagged fields end every structure in the flexible versions of messages.
+// The client doesn't use any of them, so they are kept as raw bytes.
+class kafka_tagged_fields_t {
+private:
+    std::vector<std::pair<uint32_t, seastar::sstring>> _fields;
+public:
+    [[nodiscard]] const std::vector<std::pair<uint32_t, seastar::sstring>>& operator*() const noexcept {
+        return _fields;
+    }
+
+    [[nodiscard]] std::vector<std::pair<uint32_t, seastar::sstring>>& operator*() noexcept {
+        return _fields;
+    }
+
+    [[nodiscard]] size_t serialized_size(int16_t api_version) const noexcept {
+        size_t size = kafka_unsigned_varint_t(_fields.size()).serialized_size(api_version);
+        for (const auto& [tag, data] : _fields) {
+            size += kafka_unsigned_varint_t(tag).serialized_size(api_version);
+            size += kafka_unsigned_varint_t(data.size()).serialized_size(api_version);
+            size += data.size();
+        }
+        return size;
+    }
+
+    void serialize(std::ostream& os, int16_t api_version) const {
+        kafka_unsigned_varint_t(_fields.size()).serialize(os, api_version);
+        for (const auto& [tag, data] : _fields) {
+            kafka_unsigned_varint_t(tag).serialize(os, api_version);
+            kafka_unsigned_varint_t(data.size()).serialize(os, api_version);
+            os.write(data.data(), data.size());
+        }
+    }
+
+    void deserialize(std::istream& is, int16_t api_version) {
+        kafka_unsigned_varint_t count;
+        count.deserialize(is, api_version);
+        std::vector<std::pair<uint32_t, seastar::sstring>> fields;
+        for (uint32_t i = 0; i < *count; i++) {
+            kafka_unsigned_varint_t tag;
+            tag.deserialize(is, api_version);
+            if (!fields.empty() && *tag <= fields.back().first) {
+                throw parsing_exception("Tagged fields are not in ascending order");
+            }
+            kafka_unsigned_varint_t size;
+            size.deserialize(is, api_version);
+            details::check_length(is, *size, decode_limits::of(is).max_string_length, "tagged field");
+            seastar::sstring data;
+            data.resize(*size);
+            is.read(data.data(), *size);
+            if (is.gcount() != static_cast<std::streamsize>(*size)) {
+                throw parsing_exception("Stream ended prematurely when reading tagged field");
+            }
+            fields.emplace_back(*tag, std::move(data));
+        }
+        _fields = std::move(fields);
+    }
+};
+
+// Messages with flexible versions define FIRST_FLEXIBLE_VERSION. Starting with it,
+// strings, bytes and arrays are compact, and every structure ends with tagged fields.
+template<typename MessageType, typename = void>
+struct first_flexible_version
+        : std::integral_constant<int16_t, std::numeric_limits<int16_t>::max()> {};
+
+template<typename MessageType>
+struct first_flexible_version<MessageType, std::void_t<decltype(MessageType::FIRST_FLEXIBLE_VERSION)>>
+        : std::integral_constant<int16_t, MessageType::FIRST_FLEXIBLE_VERSION> {};
+
 }
@@ -26,6 +26,8 @@
 
 #include <vector>
 
+std::uint32_t crc32c(const char* first, const char* last);
+
 namespace kafka4seastar {
 
 class kafka_record_header {
@@ -40,7 +42,7 @@ public:
 
 class kafka_record {
 public:
-    kafka_varint_t timestamp_delta;
+    kafka_varlong_t timestamp_delta;
     kafka_varint_t offset_delta;
     std::optional<seastar::sstring> key;
     std::optional<seastar::sstring> value;
@@ -86,9 +88,12 @@ class kafka_records {
 public:
     std::vector<kafka_record_batch> record_batches;
 
-    void serialize(std::ostream& os, int16_t api_version) const;
+    // Batches are compressed while serializing, so they are serialized to be measured.
+    [[nodiscard]] size_t serialized_size(int16_t api_version, bool compact = false) const;
 
-    void deserialize(std::istream& is, int16_t api_version);
+    void serialize(std::ostream& os, int16_t api_version, bool compact = false) const;
+
+    void deserialize(std::istream& is, int16_t api_version, bool compact = false);
 };
 
 }
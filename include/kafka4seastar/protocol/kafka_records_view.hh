@@ -0,0 +1,190 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (C) 2019 ScyllaDB Ltd.
+ */
+
+
+#pragma once
+
+#include <iterator>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include <seastar/core/temporary_buffer.hh>
+
+#include <kafka4seastar/protocol/kafka_primitives.hh>
+#include <kafka4seastar/protocol/kafka_records.hh>
+
+namespace kafka4seastar {
+
+namespace details {
+
+// Decodes the varint length prefixed bytes at pos, advancing it past them.
+std::optional<std::string_view> decode_varint_bytes(const char*& pos, const char* end);
+
+}
+
+// Thrown when the records of a compressed batch are read, as decompression
+// is not supported. Unlike a parsing_exception, it doesn't mean that the
+// batch is malformed: its header is valid and can still be inspected.
+struct unsupported_compression_exception : public std::runtime_error {
+public:
+    explicit unsupported_compression_exception(const seastar::sstring& message) : runtime_error(message) {}
+};
+
+// A single record decoded in place. Key, value and headers point into
+// the buffer of the batch, so the view is valid only as long as the
+// batch it was read from.
+class kafka_record_view {
+private:
+    int64_t _offset = 0;
+    int64_t _timestamp = 0;
+    std::optional<std::string_view> _key;
+    std::optional<std::string_view> _value;
+    int32_t _header_count = 0;
+    std::string_view _headers;
+
+    friend class kafka_record_batch_view;
+
+public:
+    [[nodiscard]] int64_t offset() const noexcept { return _offset; }
+    [[nodiscard]] int64_t timestamp() const noexcept { return _timestamp; }
+    [[nodiscard]] const std::optional<std::string_view>& key() const noexcept { return _key; }
+    [[nodiscard]] const std::optional<std::string_view>& value() const noexcept { return _value; }
+    [[nodiscard]] int32_t header_count() const noexcept { return _header_count; }
+
+    // Calls func(std::string_view key, std::optional<std::string_view> value) for every header.
+    template<typename Func>
+    void for_each_header(Func&& func) const {
+        auto pos = _headers.data();
+        auto end = _headers.data() + _headers.size();
+        for (int32_t i = 0; i < _header_count; i++) {
+            auto key = details::decode_varint_bytes(pos, end);
+            if (!key) {
+                throw parsing_exception("Record header key is null");
+            }
+            auto value = details::decode_varint_bytes(pos, end);
+            func(*key, value);
+        }
+    }
+};
+
+// Record batch (magic 2) over a buffer shared with the response it
+// was received in. The batch header is validated (including the CRC)
+// once, when the view is created, records are decoded lazily while
+// iterating, without copying or allocating.
+class kafka_record_batch_view {
+private:
+    seastar::temporary_buffer<char> _buffer;
+
+public:
+    class iterator {
+    private:
+        const kafka_record_batch_view* _batch = nullptr;
+        const char* _position = nullptr;
+        const char* _end = nullptr;
+        int32_t _remaining = 0;
+        kafka_record_view _current;
+
+        void decode();
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = kafka_record_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const kafka_record_view*;
+        using reference = const kafka_record_view&;
+
+        iterator() = default;
+        iterator(const kafka_record_batch_view* batch, const char* position, const char* end, int32_t remaining);
+
+        reference operator*() const noexcept { return _current; }
+        pointer operator->() const noexcept { return &_current; }
+        iterator& operator++();
+        iterator operator++(int);
+
+        bool operator==(const iterator& other) const noexcept {
+            return _remaining == other._remaining;
+        }
+        bool operator!=(const iterator& other) const noexcept {
+            return !(*this == other);
+        }
+    };
+
+    // Size of the fields preceding the records.
+    static constexpr size_t HEADER_SIZE = 61;
+
+    // Throws parsing_exception if the batch is malformed or its CRC doesn't match.
+    explicit kafka_record_batch_view(seastar::temporary_buffer<char> buffer);
+
+    [[nodiscard]] int64_t base_offset() const noexcept;
+    [[nodiscard]] int32_t partition_leader_epoch() const noexcept;
+    [[nodiscard]] int8_t magic() const noexcept;
+    [[nodiscard]] kafka_record_compression_type compression_type() const noexcept;
+    [[nodiscard]] kafka_record_timestamp_type timestamp_type() const noexcept;
+    [[nodiscard]] bool is_transactional() const noexcept;
+    [[nodiscard]] bool is_control_batch() const noexcept;
+    [[nodiscard]] int32_t last_offset_delta() const noexcept;
+    [[nodiscard]] int64_t last_offset() const noexcept;
+    [[nodiscard]] int64_t first_timestamp() const noexcept;
+    [[nodiscard]] int64_t max_timestamp() const noexcept;
+    [[nodiscard]] int64_t producer_id() const noexcept;
+    [[nodiscard]] int16_t producer_epoch() const noexcept;
+    [[nodiscard]] int32_t base_sequence() const noexcept;
+    [[nodiscard]] int32_t records_count() const noexcept;
+    [[nodiscard]] const seastar::temporary_buffer<char>& buffer() const noexcept { return _buffer; }
+
+    // Throws unsupported_compression_exception if the batch is compressed.
+    [[nodiscard]] iterator begin() const;
+    [[nodiscard]] iterator end() const;
+};
+
+// Nullable records field of a response. Deserialization only remembers
+// where the records are in the response, share_buffer() attaches them
+// to the buffer the response was deserialized from, so that no bytes
+// are copied.
+class kafka_records_view {
+private:
+    int32_t _size = -1;
+    std::streamoff _offset = 0;
+    seastar::temporary_buffer<char> _buffer;
+
+public:
+    kafka_records_view() = default;
+    explicit kafka_records_view(seastar::temporary_buffer<char> buffer);
+
+    [[nodiscard]] bool is_null() const noexcept { return _size < 0; }
+    [[nodiscard]] const seastar::temporary_buffer<char>& buffer() const noexcept { return _buffer; }
+
+    void share_buffer(const seastar::temporary_buffer<char>& response_buffer);
+
+    // Complete batches of the records. The broker can return a part of
+    // the last batch if it didn't fit into max_bytes, which is skipped.
+    [[nodiscard]] std::vector<kafka_record_batch_view> batches() const;
+
+    [[nodiscard]] size_t serialized_size(int16_t api_version, bool compact = false) const;
+
+    void serialize(std::ostream& os, int16_t api_version, bool compact = false) const;
+
+    void deserialize(std::istream& is, int16_t api_version, bool compact = false);
+};
+
+}
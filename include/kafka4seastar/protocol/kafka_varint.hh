@@ -0,0 +1,186 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (C) 2019 ScyllaDB Ltd.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include <seastar/core/bitops.hh>
+
+// Codec of the variable-length integers of the protocol, operating
+// directly on raw buffers. Every byte holds 7 bits of the value, lowest
+// first, with the highest bit set on all bytes but the last. Signed
+// values are zigzag encoded first, so that small negative numbers stay
+// short. Varints hold 32-bit values, varlongs 64-bit ones.
+
+namespace kafka4seastar {
+
+constexpr size_t MAX_VARINT_SIZE = 5;
+constexpr size_t MAX_VARLONG_SIZE = 10;
+
+constexpr uint32_t zigzag_encode(int32_t value) noexcept {
+    return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+constexpr uint64_t zigzag_encode(int64_t value) noexcept {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+constexpr int32_t zigzag_decode(uint32_t value) noexcept {
+    return static_cast<int32_t>((value >> 1) ^ -(value & 1));
+}
+
+constexpr int64_t zigzag_decode(uint64_t value) noexcept {
+    return static_cast<int64_t>((value >> 1) ^ -(value & 1));
+}
+
+// The size follows from the index of the highest set bit, so that
+// precomputing the length of a message does not loop over its bytes.
+// The lowest bit is always set, as zero has no leading one and still
+// takes up a single byte.
+inline size_t unsigned_varint_size(uint64_t value) noexcept {
+    return (64 - seastar::count_leading_zeros(value | 1) + 6) / 7;
+}
+
+inline size_t varint_size(int32_t value) noexcept {
+    return unsigned_varint_size(zigzag_encode(value));
+}
+
+inline size_t varlong_size(int64_t value) noexcept {
+    return unsigned_varint_size(zigzag_encode(value));
+}
+
+// Encoders write the value at out, which must have room for its size,
+// and return the position right past it.
+inline char* encode_unsigned_varint(uint64_t value, char* out) noexcept {
+    auto size = unsigned_varint_size(value);
+    for (size_t i = 1; i < size; i++) {
+        *out++ = static_cast<char>(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = static_cast<char>(value);
+    return out;
+}
+
+inline char* encode_varint(int32_t value, char* out) noexcept {
+    return encode_unsigned_varint(zigzag_encode(value), out);
+}
+
+inline char* encode_varlong(int64_t value, char* out) noexcept {
+    return encode_unsigned_varint(zigzag_encode(value), out);
+}
+
+namespace details {
+
+// Decodes at most max_size bytes at pos, without looking at the end of
+// the buffer, so the caller has to make sure that many bytes are there.
+inline bool decode_unsigned_varint_unchecked(const char*& pos, size_t max_size, uint64_t& value) noexcept {
+    auto bytes = reinterpret_cast<const uint8_t*>(pos);
+    uint64_t result = 0;
+    for (size_t i = 0; i < max_size; i++) {
+        auto current_byte = bytes[i];
+        result |= static_cast<uint64_t>(current_byte & 0x7F) << (7 * i);
+        if (!(current_byte & 0x80)) {
+            // The tenth byte of a varlong has room for just the highest bit.
+            if (i == MAX_VARLONG_SIZE - 1 && current_byte > 1) {
+                return false;
+            }
+            pos += i + 1;
+            value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+inline bool decode_unsigned_varint(const char*& pos, const char* end, size_t max_size, uint64_t& value) noexcept {
+    if (pos != end && !(*pos & 0x80)) {
+        value = static_cast<uint8_t>(*pos++);
+        return true;
+    }
+    auto available = static_cast<size_t>(end - pos);
+    return decode_unsigned_varint_unchecked(pos, available < max_size ? available : max_size, value);
+}
+
+}
+
+// Decoders advance pos past the decoded value. They return false, leaving
+// pos and value untouched, if the buffer ends before the last byte of the
+// value or the value does not fit in its type.
+inline bool decode_unsigned_varint(const char*& pos, const char* end, uint32_t& value) noexcept {
+    auto current = pos;
+    uint64_t result;
+    if (!details::decode_unsigned_varint(current, end, MAX_VARINT_SIZE, result)
+            || result > std::numeric_limits<uint32_t>::max()) {
+        return false;
+    }
+    pos = current;
+    value = static_cast<uint32_t>(result);
+    return true;
+}
+
+inline bool decode_varint(const char*& pos, const char* end, int32_t& value) noexcept {
+    uint32_t result;
+    if (!decode_unsigned_varint(pos, end, result)) {
+        return false;
+    }
+    value = zigzag_decode(result);
+    return true;
+}
+
+inline bool decode_varlong(const char*& pos, const char* end, int64_t& value) noexcept {
+    uint64_t result;
+    if (!details::decode_unsigned_varint(pos, end, MAX_VARLONG_SIZE, result)) {
+        return false;
+    }
+    value = zigzag_decode(result);
+    return true;
+}
+
+// Decodes count consecutive varlongs, like the fields at the start of
+// a record. When the buffer is long enough to hold all of them at their
+// largest, it is not bounds checked for each one. On failure pos is left
+// unchanged, but the values before the malformed one are already written.
+inline bool decode_varlongs(const char*& pos, const char* end, int64_t* values, size_t count) noexcept {
+    auto current = pos;
+    if (static_cast<size_t>(end - pos) >= count * MAX_VARLONG_SIZE) {
+        for (size_t i = 0; i < count; i++) {
+            uint64_t result;
+            if (!details::decode_unsigned_varint_unchecked(current, MAX_VARLONG_SIZE, result)) {
+                return false;
+            }
+            values[i] = zigzag_decode(result);
+        }
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            if (!decode_varlong(current, end, values[i])) {
+                return false;
+            }
+        }
+    }
+    pos = current;
+    return true;
+}
+
+}
@@ -20,61 +20,48 @@
  * Copyright (C) 2019 ScyllaDB Ltd.
  */
 
+
 #pragma once
 
 #include <kafka4seastar/protocol/kafka_primitives.hh>
+#include <kafka4seastar/protocol/list_offsets_response.hh>
 
 namespace kafka4seastar {
 
-class metadata_response_broker {
+class list_offsets_request_partition {
 public:
-    kafka_int32_t node_id;
-    kafka_string_t host;
-    kafka_int32_t port;
-    kafka_nullable_string_t rack;
-
-    void serialize(std::ostream& os, int16_t api_version) const;
+    static constexpr int64_t LATEST_TIMESTAMP = -1;
+    static constexpr int64_t EARLIEST_TIMESTAMP = -2;
 
-    void deserialize(std::istream& is, int16_t api_version);
-};
-
-class metadata_response_partition {
-public:
-    kafka_error_code_t error_code;
     kafka_int32_t partition_index;
-    kafka_int32_t leader_id;
-    kafka_int32_t leader_epoch;
-    kafka_array_t<kafka_int32_t> replica_nodes;
-    kafka_array_t<kafka_int32_t> isr_nodes;
-    kafka_array_t<kafka_int32_t> offline_replicas;
+    kafka_int32_t current_leader_epoch;
+    kafka_int64_t timestamp;
 
     void serialize(std::ostream& os, int16_t api_version) const;
 
     void deserialize(std::istream& is, int16_t api_version);
 };
 
-class metadata_response_topic {
+class list_offsets_request_topic {
 public:
-    kafka_error_code_t error_code;
     kafka_string_t name;
-    kafka_bool_t is_internal;
-    kafka_array_t<metadata_response_partition> partitions;
-    kafka_int32_t topic_authorized_operations;
+    kafka_array_t<list_offsets_request_partition> partitions;
 
     void serialize(std::ostream& os, int16_t api_version) const;
 
     void deserialize(std::istream& is, int16_t api_version);
 };
 
-class metadata_response {
+class list_offsets_request {
 public:
-    kafka_int32_t throttle_time_ms;
-    kafka_array_t<metadata_response_broker> brokers;
-    kafka_nullable_string_t cluster_id;
-    kafka_int32_t controller_id;
-    kafka_array_t<metadata_response_topic> topics;
-    kafka_int32_t cluster_authorized_operations;
-    kafka_error_code_t error_code;
+    using response_type = list_offsets_response;
+    static constexpr int16_t API_KEY = 2;
+    static constexpr int16_t MIN_SUPPORTED_VERSION = 1; // Kafka 0.10.1.0
+    static constexpr int16_t MAX_SUPPORTED_VERSION = 5;
+
+    kafka_int32_t replica_id;
+    kafka_int8_t isolation_level;
+    kafka_array_t<list_offsets_request_topic> topics;
 
     void serialize(std::ostream& os, int16_t api_version) const;
 
@@ -20,45 +20,41 @@
  * Copyright (C) 2019 ScyllaDB Ltd.
  */
 
+
 #pragma once
 
 #include <kafka4seastar/protocol/kafka_primitives.hh>
-#include <kafka4seastar/protocol/kafka_records.hh>
-#include <kafka4seastar/protocol/produce_response.hh>
 
 namespace kafka4seastar {
 
-class produce_request_partition_produce_data {
+class list_offsets_response_partition {
 public:
     kafka_int32_t partition_index;
-    kafka_records records;
+    kafka_error_code_t error_code;
+    kafka_int64_t timestamp;
+    kafka_int64_t offset;
+    kafka_int32_t leader_epoch;
 
     void serialize(std::ostream& os, int16_t api_version) const;
 
     void deserialize(std::istream& is, int16_t api_version);
 };
 
-class produce_request_topic_produce_data {
+class list_offsets_response_topic {
 public:
     kafka_string_t name;
-    kafka_array_t<produce_request_partition_produce_data> partitions;
+    kafka_array_t<list_offsets_response_partition> partitions;
 
     void serialize(std::ostream& os, int16_t api_version) const;
 
     void deserialize(std::istream& is, int16_t api_version);
 };
 
-class produce_request {
+class list_offsets_response {
 public:
-    using response_type = produce_response;
-    static constexpr int16_t API_KEY = 0;
-    static constexpr int16_t MIN_SUPPORTED_VERSION = 2; // Kafka 0.10.0.0
-    static constexpr int16_t MAX_SUPPORTED_VERSION = 8;
-
-    kafka_nullable_string_t transactional_id;
-    kafka_int16_t acks;
-    kafka_int32_t timeout_ms;
-    kafka_array_t<produce_request_topic_produce_data> topics;
+    kafka_int32_t throttle_time_ms;
+    kafka_array_t<list_offsets_response_topic> topics;
+    kafka_error_code_t error_code;
 
     void serialize(std::ostream& os, int16_t api_version) const;
 
@@ -20,33 +20,38 @@
  * Copyright (C) 2019 ScyllaDB Ltd.
  */
 
+
 #pragma once
 
 #include <kafka4seastar/protocol/kafka_primitives.hh>
-#include <kafka4seastar/protocol/metadata_response.hh>
 
 namespace kafka4seastar {
 
-class metadata_request_topic {
+class offset_commit_response_partition {
+public:
+    kafka_int32_t partition_index;
+    kafka_error_code_t error_code;
+
+    void serialize(std::ostream& os, int16_t api_version) const;
+
+    void deserialize(std::istream& is, int16_t api_version);
+};
+
+class offset_commit_response_topic {
 public:
     kafka_string_t name;
+    kafka_array_t<offset_commit_response_partition> partitions;
 
     void serialize(std::ostream& os, int16_t api_version) const;
 
     void deserialize(std::istream& is, int16_t api_version);
 };
 
-class metadata_request {
+class offset_commit_response {
 public:
-    using response_type = metadata_response;
-    static constexpr int16_t API_KEY = 3;
-    static constexpr int16_t MIN_SUPPORTED_VERSION = 1; // Kafka 0.10.0.0
-    static constexpr int16_t MAX_SUPPORTED_VERSION = 8;
-
-    kafka_array_t<metadata_request_topic> topics;
-    kafka_bool_t allow_auto_topic_creation;
-    kafka_bool_t include_cluster_authorized_operations;
-    kafka_bool_t include_topic_authorized_operations;
+    kafka_int32_t throttle_time_ms;
+    kafka_array_t<offset_commit_response_topic> topics;
+    kafka_error_code_t error_code;
 
     void serialize(std::ostream& os, int16_t api_version) const;
 
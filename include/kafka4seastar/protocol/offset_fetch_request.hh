@@ -0,0 +1,58 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (C) 2019 ScyllaDB Ltd.
+ */
+
+
+#pragma once
+
+#include <kafka4seastar/protocol/kafka_primitives.hh>
+#include <kafka4seastar/protocol/offset_fetch_response.hh>
+
+namespace kafka4seastar {
+
+class offset_fetch_request_topic {
+public:
+    kafka_string_t name;
+    kafka_array_t<kafka_int32_t> partition_indexes;
+
+    void serialize(std::ostream& os, int16_t api_version) const;
+
+    void deserialize(std::istream& is, int16_t api_version);
+};
+
+class offset_fetch_request {
+public:
+    using response_type = offset_fetch_response;
+    static constexpr int16_t API_KEY = 9;
+    // Version 0 reads offsets stored in ZooKeeper.
+    static constexpr int16_t MIN_SUPPORTED_VERSION = 1;
+    static constexpr int16_t MAX_SUPPORTED_VERSION = 5;
+
+    kafka_string_t group_id;
+    // Null fetches offsets of all partitions (since version 2).
+    kafka_array_t<offset_fetch_request_topic> topics;
+
+    void serialize(std::ostream& os, int16_t api_version) const;
+
+    void deserialize(std::istream& is, int16_t api_version);
+};
+
+}
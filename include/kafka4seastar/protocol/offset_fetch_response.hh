@@ -20,55 +20,40 @@
  * Copyright (C) 2019 ScyllaDB Ltd.
  */
 
+
 #pragma once
 
 #include <kafka4seastar/protocol/kafka_primitives.hh>
 
 namespace kafka4seastar {
 
-class produce_response_batch_index_and_error_message {
-private:
-    kafka_int32_t batch_index;
-    kafka_nullable_string_t batch_index_error_message;
-public:
-    [[nodiscard]] const kafka_int32_t& get_batch_index() const;
-
-    [[nodiscard]] const kafka_nullable_string_t& get_batch_index_error_message() const;
-
-    void serialize(std::ostream& os, int16_t api_version) const;
-
-    void deserialize(std::istream& is, int16_t api_version);
-};
-
-class produce_response_partition_produce_response {
+class offset_fetch_response_partition {
 public:
     kafka_int32_t partition_index;
+    kafka_int64_t committed_offset;
+    kafka_int32_t committed_leader_epoch;
+    kafka_nullable_string_t metadata;
     kafka_error_code_t error_code;
-    kafka_int64_t base_offset;
-    kafka_int64_t log_append_time_ms;
-    kafka_int64_t log_start_offset;
-    kafka_array_t<produce_response_batch_index_and_error_message> record_errors;
-    kafka_nullable_string_t error_message;
 
     void serialize(std::ostream& os, int16_t api_version) const;
 
     void deserialize(std::istream& is, int16_t api_version);
 };
 
-class produce_response_topic_produce_response {
+class offset_fetch_response_topic {
 public:
     kafka_string_t name;
-    kafka_array_t<produce_response_partition_produce_response> partitions;
+    kafka_array_t<offset_fetch_response_partition> partitions;
 
     void serialize(std::ostream& os, int16_t api_version) const;
 
     void deserialize(std::istream& is, int16_t api_version);
 };
 
-class produce_response {
+class offset_fetch_response {
 public:
-    kafka_array_t<produce_response_topic_produce_response> responses;
     kafka_int32_t throttle_time_ms;
+    kafka_array_t<offset_fetch_response_topic> topics;
     kafka_error_code_t error_code;
 
     void serialize(std::ostream& os, int16_t api_version) const;
@@ -29,6 +29,7 @@
 #include <seastar/util/noncopyable_function.hh>
 
 #include <kafka4seastar/utils/partitioner.hh>
+#include <kafka4seastar/consumer/partition_assignor.hh>
 
 namespace kafka4seastar {
 
@@ -38,6 +39,9 @@ seastar::noncopyable_function<seastar::future<>(uint32_t)> exp_retry_backoff(uin
 
 std::unique_ptr<partitioner> round_robin_partitioner();
 std::unique_ptr<partitioner> random_partitioner();
+std::unique_ptr<partitioner> sticky_partitioner(uint32_t batch_size);
+
+std::unique_ptr<partition_assignor> cooperative_sticky_assignor();
 
 }
 
@@ -0,0 +1,59 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (C) 2019 ScyllaDB Ltd.
+ */
+
+#pragma once
+
+#include <exception>
+#include <typeinfo>
+
+namespace kafka4seastar {
+
+// Returns the exception held by ep if it is an Ex (or derives from it),
+// nullptr otherwise. Unlike std::rethrow_exception in a try/catch, it
+// doesn't unwind the stack, whose cost (and the lock taken by the
+// unwinder) matters when every request of a shard fails at once, e.g.
+// during a broker outage.
+template<typename Ex>
+Ex* try_catch(const std::exception_ptr& ep) noexcept {
+    if (!ep) {
+        return nullptr;
+    }
+#if defined(__GLIBCXX__)
+    // The exception object is the only member of std::exception_ptr,
+    // its type is matched the same way a catch clause does it.
+    void* object = *reinterpret_cast<void* const*>(&ep);
+    if (typeid(Ex).__do_catch(ep.__cxa_exception_type(), &object, 1)) {
+        return static_cast<Ex*>(object);
+    }
+    return nullptr;
+#else
+    try {
+        std::rethrow_exception(ep);
+    } catch (Ex& e) {
+        return &e;
+    } catch (...) {
+        return nullptr;
+    }
+#endif
+}
+
+}
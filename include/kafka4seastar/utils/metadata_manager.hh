@@ -23,6 +23,8 @@
 #pragma once
 
 #include <chrono>
+#include <set>
+#include <vector>
 
 #include <kafka4seastar/connection/connection_manager.hh>
 #include <seastar/core/future.hh>
@@ -39,19 +41,35 @@ private:
     seastar::semaphore _refresh_finished = 0;
     seastar::abort_source _stop_refresh;
     uint32_t _expiration_time;
+    std::set<seastar::sstring> _topics_of_interest;
+    // Handles of the brokers indexed by node id less the smallest one,
+    // or in the order of the brokers if their ids are too sparse.
+    std::vector<connection_manager::broker_handle> _broker_handles;
+    int32_t _first_node_id = 0;
+    bool _dense_node_ids = true;
+
+    static constexpr int64_t MAX_NODE_ID_SPAN = 1 << 16;
 
     seastar::future<> refresh_coroutine(std::chrono::milliseconds dur);
+    void index_brokers();
+    void warm_up_leaders();
 
 public:
     explicit metadata_manager(connection_manager& manager, uint32_t expiration_time)
     : _connection_manager(manager), _expiration_time(expiration_time) {}
 
     seastar::future<> refresh_metadata();
+    // Topics whose leaders are connected to after every refresh (see
+    // connection_properties::warm_up_connections), all of them if empty.
+    void set_topics_of_interest(std::set<seastar::sstring> topics);
     void start_refresh();
     seastar::future<> stop_refresh();
     // Capturing resulting metadata response object is forbidden,
     // it can be destroyed any time.
     const metadata_response& get_metadata();
+    // Handle of the broker with the given node id in the current
+    // metadata, connection_manager::NO_BROKER if there is none.
+    connection_manager::broker_handle broker_handle_for(int32_t node_id) const;
 
 };
 
@@ -23,26 +23,120 @@
 #pragma once
 
 #include <atomic>
+#include <optional>
+#include <random>
+#include <string_view>
+#include <unordered_map>
+
+#include <seastar/util/noncopyable_function.hh>
+
 #include <kafka4seastar/protocol/metadata_response.hh>
 
 namespace kafka4seastar {
 
+// State of a partition, as seen by the producer.
+struct partition_state {
+    // Whether records sent to the partition can be written right away:
+    // the metadata shows no error and a leader which answers requests.
+    bool available = false;
+    // Node id of the leader, -1 if there is none.
+    int32_t leader_id = -1;
+    // Bytes sent to the leader and not yet acknowledged by it, on all
+    // connections to it, shared by the partitions it leads.
+    size_t queue_depth = 0;
+    // Moving average of the latency of the requests to the leader,
+    // 0 until the first of them completes.
+    double latency_ms = 0;
+};
+
+// What the producer knows about a record and the topic it is produced
+// to, besides the metadata of the partitions.
+struct partitioner_context {
+    const seastar::sstring& topic;
+    // Size of the key and value of the record.
+    size_t record_size;
+    seastar::noncopyable_function<partition_state(const metadata_response_partition&)> state_of;
+};
+
+// Hash of the key used by the Java client (and librdkafka's
+// murmur2_random), so that records with the same key end up
+// in the same partition regardless of the client producing them.
+int32_t murmur2(std::string_view key) noexcept;
+
+// Bucket of the key among the given number of them (Lamping, Veach),
+// when the number grows only 1/buckets of the keys move, all of them
+// to the new buckets.
+int32_t jump_consistent_hash(uint64_t key, int32_t buckets) noexcept;
+
 class partitioner {
 public:
-    virtual const metadata_response_partition& get_partition(const seastar::sstring& key, const kafka_array_t<metadata_response_partition>& partitions) = 0;
+    virtual const metadata_response_partition& get_partition(const partitioner_context& context,
+            std::optional<std::string_view> key, const kafka_array_t<metadata_response_partition>& partitions) = 0;
     virtual ~partitioner() = default;
 };
 
+// Records without a key go to a random partition, the next available
+// one if it isn't. Records with a key go to a random partition as well.
 class basic_partitioner : public partitioner {
 public:
-    const metadata_response_partition& get_partition(const seastar::sstring& key, const kafka_array_t<metadata_response_partition>& partitions) override;
+    const metadata_response_partition& get_partition(const partitioner_context& context,
+            std::optional<std::string_view> key, const kafka_array_t<metadata_response_partition>& partitions) override;
 };
 
+// Records without a key go to the partitions in turn, skipping the
+// ones which are not available. Records with a key are hashed.
 class rr_partitioner : public partitioner {
 public:
-    const metadata_response_partition& get_partition(const seastar::sstring& key, const kafka_array_t<metadata_response_partition>& partitions) override;
+    const metadata_response_partition& get_partition(const partitioner_context& context,
+            std::optional<std::string_view> key, const kafka_array_t<metadata_response_partition>& partitions) override;
 private:
     uint32_t counter = 0;
 };
 
+enum class key_hashing {
+    // The partition of the key is its murmur2 hash modulo the number of
+    // partitions, as in the DefaultPartitioner of the Java client.
+    MURMUR2,
+    // The murmur2 hash is mapped with jump_consistent_hash(), so that adding
+    // partitions remaps as few keys as possible. Not compatible with other
+    // clients, nor with MURMUR2 itself.
+    CONSISTENT
+};
+
+// Records without a key stick to a single partition of their topic until
+// batch_size bytes of them were sent there, so that they form large
+// batches, instead of one record going to every partition (KIP-794).
+// The next partition is drawn among the available ones whose leader is
+// not overloaded, with the odds falling with the queue depth of its
+// leader, so that slow brokers get less of the traffic. The partition is
+// left early once it becomes unavailable. Records with a key are hashed
+// as set by key_hashing, regardless of the state of the partition.
+class sticky_partitioner : public partitioner {
+public:
+    // A leader is overloaded when its latency exceeds both this many times
+    // the lowest latency among the leaders and MIN_OVERLOADED_LATENCY_MS.
+    static constexpr double OVERLOADED_LATENCY_FACTOR = 4;
+    static constexpr double MIN_OVERLOADED_LATENCY_MS = 50;
+
+    explicit sticky_partitioner(size_t batch_size, key_hashing hashing = key_hashing::MURMUR2);
+
+    const metadata_response_partition& get_partition(const partitioner_context& context,
+            std::optional<std::string_view> key, const kafka_array_t<metadata_response_partition>& partitions) override;
+
+private:
+    struct sticky_partition {
+        // Position in the partitions of the topic, not the partition index.
+        size_t position = 0;
+        size_t produced_bytes = 0;
+    };
+
+    size_t _batch_size;
+    key_hashing _hashing;
+    std::unordered_map<seastar::sstring, sticky_partition> _sticky_partitions;
+    std::mt19937 _random;
+
+    size_t draw_partition(const partitioner_context& context,
+            const kafka_array_t<metadata_response_partition>& partitions);
+};
+
 }
@@ -0,0 +1,91 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (C) 2019 ScyllaDB Ltd.
+ */
+
+#include <kafka4seastar/connection/broker_health.hh>
+
+namespace kafka4seastar {
+
+broker_health::broker_health(uint32_t failure_threshold, clock::duration open_time)
+        : _failure_threshold(failure_threshold),
+        _open_time(open_time) {}
+
+void broker_health::open(clock::time_point now) {
+    _state = circuit_state::OPEN;
+    _open_until = now + _open_time;
+    _probe_in_flight = false;
+}
+
+bool broker_health::allow_request(clock::time_point now) {
+    switch (_state) {
+    case circuit_state::CLOSED:
+        return true;
+    case circuit_state::OPEN:
+        if (now < _open_until) {
+            return false;
+        }
+        _state = circuit_state::HALF_OPEN;
+        _probe_in_flight = true;
+        return true;
+    case circuit_state::HALF_OPEN:
+        if (_probe_in_flight) {
+            return false;
+        }
+        _probe_in_flight = true;
+        return true;
+    }
+    return true;
+}
+
+void broker_health::record_success(clock::duration latency) {
+    auto latency_ms = std::chrono::duration<double, std::milli>(latency).count();
+    _latency_ms = _latency_ms == 0 ? latency_ms : EWMA_WEIGHT * latency_ms + (1 - EWMA_WEIGHT) * _latency_ms;
+    _error_rate = (1 - EWMA_WEIGHT) * _error_rate;
+    _consecutive_failures = 0;
+    _state = circuit_state::CLOSED;
+    _probe_in_flight = false;
+}
+
+void broker_health::record_failure(clock::time_point now) {
+    _error_rate = EWMA_WEIGHT + (1 - EWMA_WEIGHT) * _error_rate;
+    ++_consecutive_failures;
+    if (_state == circuit_state::HALF_OPEN || _consecutive_failures >= _failure_threshold) {
+        open(now);
+    }
+}
+
+bool broker_health::healthy() const noexcept {
+    return _state == circuit_state::CLOSED && _error_rate < 0.5;
+}
+
+broker_health::circuit_state broker_health::state() const noexcept {
+    return _state;
+}
+
+double broker_health::error_rate() const noexcept {
+    return _error_rate;
+}
+
+double broker_health::latency_ms() const noexcept {
+    return _latency_ms;
+}
+
+}
@@ -19,10 +19,11 @@
 /*
  * Copyright (C) 2019 ScyllaDB Ltd.
  */
-
 #include <kafka4seastar/connection/connection_manager.hh>
+#include <seastar/core/metrics.hh>
 #include <seastar/core/thread.hh>
 
+#include <algorithm>
 #include <memory>
 #include <utility>
 
@@ -30,65 +31,286 @@ using namespace seastar;
 
 namespace kafka4seastar {
 
-future<connection_manager::connection_iterator> connection_manager::connect(const seastar::sstring& host, uint16_t port, uint32_t timeout) {
-    auto conn = _connections.find({host, port});
-    return conn != _connections.end()
-       ? make_ready_future<connection_manager::connection_iterator>(conn)
-       : kafka_connection::connect(host, port, _client_id, timeout)
-       .then([this, host, port] (std::unique_ptr<kafka_connection> conn) {
-            return make_ready_future<connection_manager::connection_iterator>(_connections.emplace(std::make_pair<>(host, port), std::move(conn)).first);
-        });
+connection_manager::broker_entry::broker_entry(connection_id address, size_t lane_count,
+        const connection_properties& properties)
+        : address(std::move(address)),
+        connections(lane_count),
+        connecting(lane_count),
+        health(properties.circuit_failure_threshold, std::chrono::milliseconds(properties.circuit_open_time)) {
+    windows.reserve(lane_count);
+    for (size_t lane = 0; lane < lane_count; lane++) {
+        windows.emplace_back(properties.initial_in_flight_requests, properties.max_in_flight_requests);
+        sending.emplace_back(1);
+    }
 }
 
-future<> connection_manager::init(const std::set<connection_id>& servers, uint32_t request_timeout) {
-    std::vector<future<>> fs;
+connection_manager::broker_handle connection_manager::handle_of(const connection_id& connection) {
+    auto handle = _handles.find(connection);
+    if (handle != _handles.end()) {
+        return handle->second;
+    }
+    auto broker = static_cast<broker_handle>(_brokers.size());
+    _brokers.emplace_back(std::make_unique<broker_entry>(connection, lane_count(), _properties));
+    _handles.emplace(connection, broker);
+    return broker;
+}
+
+const connection_manager::connection_id& connection_manager::address_of(broker_handle broker) const {
+    return _brokers[broker]->address;
+}
+
+void connection_manager::record_throttle(broker_entry& entry, int32_t throttle_time_ms, bool client_throttled) {
+    if (throttle_time_ms <= 0) {
+        return;
+    }
+    if (client_throttled) {
+        entry.throttled_until = std::max(entry.throttled_until,
+                lowres_clock::now() + std::chrono::milliseconds(throttle_time_ms));
+    }
+    _throttle_time_ms += throttle_time_ms;
+    ++_throttled_responses;
+}
+
+bool connection_manager::window_open(broker_entry& entry, size_t lane, const lane_window& window) {
+    if (window.in_flight == 0) {
+        return true;
+    }
+    auto& conn = entry.connections[lane];
+    auto outstanding_bytes = conn ? conn->outstanding_bytes() : 0;
+    return window.in_flight < window.controller.window()
+           && outstanding_bytes < size_t(window.controller.window()) * _properties.in_flight_bytes_per_request;
+}
 
-    fs.reserve(servers.size());
+future<> connection_manager::enter_window(broker_handle broker, size_t lane) {
+    auto& entry = entry_of(broker);
+    auto& window = entry.windows[lane];
+    if (window.waiters.empty() && window_open(entry, lane, window)) {
+        ++window.in_flight;
+        return make_ready_future<>();
+    }
+    window.waiters.emplace_back();
+    return window.waiters.back().get_future();
+}
 
-    for (auto& server : servers) {
-        fs.push_back(connect(server.first, server.second, request_timeout).discard_result());
+void connection_manager::leave_window(broker_handle broker, size_t lane, bool congested, lowres_clock::duration rtt) {
+    auto& entry = entry_of(broker);
+    auto& window = entry.windows[lane];
+    --window.in_flight;
+    if (congested) {
+        window.controller.on_congestion();
+    } else {
+        window.controller.on_success(std::chrono::duration<double, std::milli>(rtt).count());
+    }
+    // Admitted in order, so that the requests of a partition stay ordered.
+    while (!window.waiters.empty() && window_open(entry, lane, window)) {
+        ++window.in_flight;
+        window.waiters.front().set_value();
+        window.waiters.pop_front();
     }
+}
 
-    return when_all(fs.begin(), fs.end()).then([] (auto&& results) {
-        int failures = 0;
-        for (auto& f : results) {
-            try {
-                f.get();
-            } catch (...) {
-                ++failures;
+bool connection_manager::is_healthy(broker_handle broker) const {
+    return broker >= _brokers.size() || _brokers[broker]->health.healthy();
+}
+
+size_t connection_manager::outstanding_bytes(broker_handle broker) const {
+    if (broker >= _brokers.size()) {
+        return 0;
+    }
+    size_t bytes = 0;
+    for (const auto& connection : _brokers[broker]->connections) {
+        if (connection) {
+            bytes += connection->outstanding_bytes();
+        }
+    }
+    return bytes;
+}
+
+double connection_manager::latency_ms(broker_handle broker) const {
+    return broker >= _brokers.size() ? 0 : _brokers[broker]->health.latency_ms();
+}
+
+size_t connection_manager::lane_count() const noexcept {
+    return std::max<size_t>(_properties.connections_per_broker, 1) + (_properties.dedicated_control_connection ? 1 : 0);
+}
+
+size_t connection_manager::resolve_lane(broker_entry& entry, size_t lane) {
+    if (lane == CONTROL_LANE && _properties.dedicated_control_connection) {
+        return lane_count() - 1;
+    }
+    if (lane != CONTROL_LANE && lane != ANY_LANE) {
+        return lane;
+    }
+
+    auto data_lanes = std::max<size_t>(_properties.connections_per_broker, 1);
+    auto& connections = entry.connections;
+    size_t least_loaded = 0;
+    for (size_t i = 1; i < data_lanes; i++) {
+        auto outstanding = connections[i] ? connections[i]->outstanding_bytes() : 0;
+        auto least_outstanding = connections[least_loaded] ? connections[least_loaded]->outstanding_bytes() : 0;
+        if (outstanding < least_outstanding) {
+            least_loaded = i;
+        }
+    }
+    return least_loaded;
+}
+
+size_t connection_manager::lane_for(broker_handle broker, const topic_partition& partition) {
+    auto& entry = entry_of(broker);
+    auto lane = entry.partition_lanes.find(partition);
+    if (lane != entry.partition_lanes.end()) {
+        return lane->second;
+    }
+    return entry.partition_lanes.emplace(partition, resolve_lane(entry, ANY_LANE)).first->second;
+}
+
+std::optional<api_versions_response> connection_manager::cached_api_versions(const broker_entry& entry) const {
+    if (!entry.api_versions || entry.api_versions->api_keys.is_null()) {
+        return std::nullopt;
+    }
+    return entry.api_versions;
+}
+
+future<kafka_connection*> connection_manager::connect(broker_handle broker, size_t lane, uint32_t timeout) {
+    auto conn = get_connection(broker, lane);
+    if (conn) {
+        return make_ready_future<kafka_connection*>(conn);
+    }
+    auto& entry = entry_of(broker);
+    if (entry.connecting[lane]) {
+        return entry.connecting[lane]->get_future();
+    }
+
+    const auto& [host, port] = entry.address;
+    tls_parameters tls{_tls_credentials, _properties.tls_session_resumption ? entry.tls_session : tls::session_data()};
+    auto f = kafka_connection::connect(host, port, _client_id, timeout, _properties, cached_api_versions(entry), std::move(tls))
+    .then([this, broker, lane] (std::unique_ptr<kafka_connection> conn) {
+        auto& entry = entry_of(broker);
+        entry.api_versions = conn->api_versions();
+        entry.connections[lane] = std::move(conn);
+        return make_ready_future<kafka_connection*>(entry.connections[lane].get());
+    }).finally([this, broker, lane] {
+        entry_of(broker).connecting[lane].reset();
+    });
+    if (f.available()) {
+        return f;
+    }
+    entry.connecting[lane].emplace(std::move(f));
+    return entry.connecting[lane]->get_future();
+}
+
+void connection_manager::warm_up(const std::set<broker_handle>& brokers) {
+    if (!_properties.warm_up_connections || _warm_ups.is_closed()) {
+        return;
+    }
+    for (auto broker : brokers) {
+        for (size_t lane = 0; lane < lane_count(); lane++) {
+            if (get_connection(broker, lane)) {
+                continue;
             }
+            (void) with_gate(_warm_ups, [this, broker, lane] {
+                return connect(broker, lane, _connect_timeout).discard_result().handle_exception([] (std::exception_ptr ep) {
+                    // The broker will be connected to again by the first request sent to it.
+                });
+            });
         }
-        if (failures == results.size()) {
-            throw connection_exception("Couldn't connect to any initial brokers");
+    }
+}
+
+future<> connection_manager::init(const std::set<connection_id>& servers, uint32_t request_timeout) {
+    _connect_timeout = request_timeout;
+
+    namespace sm = seastar::metrics;
+    _metrics.add_group("kafka4seastar", {
+        sm::make_derive("throttle_time_ms", _throttle_time_ms,
+                sm::description("Total time the brokers asked the client to hold off sending"),
+                {sm::label_instance("client_id", _client_id)}),
+        sm::make_derive("throttled_responses", _throttled_responses,
+                sm::description("Number of responses with a non-zero throttle time"),
+                {sm::label_instance("client_id", _client_id)})
+    });
+
+    return tcp_connection::make_tls_credentials(_properties).then([this, servers, request_timeout]
+            (shared_ptr<tls::certificate_credentials> credentials) {
+        _tls_credentials = std::move(credentials);
+
+        std::vector<future<>> fs;
+
+        fs.reserve(servers.size());
+
+        for (auto& server : servers) {
+            auto broker = handle_of(server);
+            fs.push_back(connect(broker, resolve_lane(entry_of(broker), CONTROL_LANE), request_timeout).discard_result());
         }
+
+        return when_all(fs.begin(), fs.end()).then([] (auto&& results) {
+            int failures = 0;
+            for (auto& f : results) {
+                try {
+                    f.get();
+                } catch (...) {
+                    ++failures;
+                }
+            }
+            if (failures == results.size()) {
+                throw connection_exception("Couldn't connect to any initial brokers");
+            }
+        });
     });
 }
 
-connection_manager::connection_iterator connection_manager::get_connection(const connection_id& connection) {
-    return _connections.find(connection);
+kafka_connection* connection_manager::get_connection(broker_handle broker, size_t lane) {
+    return entry_of(broker).connections[lane].get();
 }
 
-future<> connection_manager::disconnect(const connection_id& connection) {
-    auto conn = _connections.find(connection);
-    if (conn != _connections.end()) {
-        auto conn_ptr = std::move(conn->second);
-        _connections.erase(conn);
-        auto f = conn_ptr->close();
+future<> connection_manager::disconnect(broker_handle broker, size_t lane) {
+    auto& entry = entry_of(broker);
+    if (entry.connections[lane]) {
+        auto conn_ptr = std::move(entry.connections[lane]);
+        // Refreshed in the background since it was connected.
+        entry.api_versions = conn_ptr->api_versions();
+        auto session = _tls_credentials && _properties.tls_session_resumption
+                       ? conn_ptr->tls_session()
+                       : make_ready_future<tls::session_data>();
+        // Session tickets may arrive after the handshake, so the session
+        // is taken only when the connection is no longer used.
+        auto f = session.then([this, broker] (tls::session_data session) {
+            if (!session.empty()) {
+                entry_of(broker).tls_session = std::move(session);
+            }
+        }).handle_exception([] (std::exception_ptr ep) {
+            // The handshake failed, the previous session is kept.
+        }).then([conn = conn_ptr.get()] {
+            return conn->close();
+        });
         return f.finally([conn_ptr = std::move(conn_ptr)]{});
     }
     return make_ready_future();
 }
 
 future<metadata_response> connection_manager::ask_for_metadata(metadata_request&& request) {
-    auto conn_id = std::optional<connection_id>();
-    return seastar::do_with(metadata_response(), [this, request = std::move(request), conn_id = std::move(conn_id)] (metadata_response& metadata) mutable {
-        return seastar::repeat([this, request = std::move(request), conn_id = std::move(conn_id), &metadata] () mutable {
-            auto it = !conn_id ? _connections.begin() : _connections.upper_bound(*conn_id);
-            if (it == _connections.end()) {
-                throw metadata_refresh_exception("No brokers responded.");
+    auto next = broker_handle(0);
+    return seastar::do_with(metadata_response(), [this, request = std::move(request), next] (metadata_response& metadata) mutable {
+        return seastar::repeat([this, request = std::move(request), next, &metadata] () mutable {
+            // Brokers which have no lane connected are skipped.
+            auto broker = NO_BROKER;
+            auto lane = CONTROL_LANE;
+            for (; next < _brokers.size() && broker == NO_BROKER; next++) {
+                auto& entry = entry_of(next);
+                auto control_lane = resolve_lane(entry, CONTROL_LANE);
+                for (size_t candidate = 0; candidate < entry.connections.size(); candidate++) {
+                    if (entry.connections[candidate] && (broker == NO_BROKER || candidate == control_lane)) {
+                        broker = next;
+                        lane = candidate;
+                    }
+                }
+            }
+            if (broker == NO_BROKER) {
+                return make_exception_future<stop_iteration>(metadata_refresh_exception("No brokers responded."));
             }
-            conn_id = it->first;
-            return it->second->send(request).then([this, &metadata](metadata_response res) mutable {
+            // Paced like any other request, so that the broker's throttling is honored.
+            return send_paced<metadata_request>(metadata_request(request), broker, _connect_timeout, true, lane)
+            .then([&metadata] (metadata_response res) mutable {
                 if (res.error_code == error::kafka_error_code::NONE) {
                     metadata = std::move(res);
                     return seastar::stop_iteration::yes;
@@ -105,12 +327,21 @@ future<metadata_response> connection_manager::ask_for_metadata(metadata_request&
 }
 
 future<> connection_manager::disconnect_all() {
-    while (_connections.begin() != _connections.end()) {
-        auto it = _connections.begin();
-        auto f = disconnect({it->first.first, it->first.second});
-        _pending_queue = _pending_queue.then([this, f = std::move(f)] () mutable {
-            return std::move(f);
-        });
+    return _warm_ups.close().then([this] {
+        return disconnect_lanes();
+    });
+}
+
+future<> connection_manager::disconnect_lanes() {
+    for (broker_handle broker = 0; broker < _brokers.size(); broker++) {
+        auto& entry = entry_of(broker);
+        for (size_t lane = 0; lane < entry.connections.size(); lane++) {
+            auto f = disconnect(broker, lane);
+            _pending_queue = _pending_queue.then([this, f = std::move(f)] () mutable {
+                return std::move(f);
+            });
+        }
+        entry.partition_lanes.clear();
     }
 
     return _pending_queue.discard_result();
@@ -0,0 +1,91 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (C) 2019 ScyllaDB Ltd.
+ */
+
+#include <algorithm>
+
+#include <seastar/net/dns.hh>
+
+#include <kafka4seastar/connection/dns_cache.hh>
+#include <kafka4seastar/connection/tcp_connection.hh>
+
+using namespace seastar;
+
+namespace kafka4seastar {
+
+dns_cache::dns_cache()
+    : dns_cache([] (const sstring& host) {
+        return net::dns::get_host_by_name(host).then([] (hostent host) {
+            return std::move(host.addr_list);
+        });
+    }) {}
+
+dns_cache::dns_cache(resolver resolve_host)
+    : _resolver(std::move(resolve_host)) {}
+
+dns_cache& dns_cache::local() {
+    static thread_local dns_cache cache;
+    return cache;
+}
+
+future<std::vector<net::inet_address>> dns_cache::resolve(const sstring& host,
+        std::chrono::milliseconds ttl, std::chrono::milliseconds negative_ttl) {
+    auto cached = _entries.find(host);
+    if (cached != _entries.end() && cached->second.expires > clock::now()) {
+        return cached->second.error
+               ? make_exception_future<std::vector<net::inet_address>>(cached->second.error)
+               : make_ready_future<std::vector<net::inet_address>>(cached->second.addresses);
+    }
+
+    auto resolving = _resolving.find(host);
+    if (resolving != _resolving.end()) {
+        return resolving->second.get_future();
+    }
+
+    auto f = _resolver(host).then_wrapped([this, host, ttl, negative_ttl] (future<std::vector<net::inet_address>> f) {
+        _resolving.erase(host);
+        auto& cached = _entries[host];
+        auto ep = f.failed() ? f.get_exception() : nullptr;
+        auto addresses = ep ? std::vector<net::inet_address>() : f.get0();
+        if (!ep && addresses.empty()) {
+            ep = std::make_exception_ptr(tcp_connection_exception(sstring("No addresses found for ") + host));
+        }
+        if (ep) {
+            cached = entry{{}, ep, clock::now() + negative_ttl};
+            return make_exception_future<std::vector<net::inet_address>>(ep);
+        }
+        cached = entry{addresses, nullptr, clock::now() + ttl};
+        return make_ready_future<std::vector<net::inet_address>>(std::move(addresses));
+    });
+    if (f.available()) {
+        return f;
+    }
+    return _resolving.emplace(host, shared_future<std::vector<net::inet_address>>(std::move(f))).first->second.get_future();
+}
+
+void dns_cache::expire_within(const sstring& host, std::chrono::milliseconds ttl) {
+    auto cached = _entries.find(host);
+    if (cached != _entries.end()) {
+        cached->second.expires = std::min(cached->second.expires, clock::now() + ttl);
+    }
+}
+
+}
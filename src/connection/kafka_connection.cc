@@ -22,16 +22,26 @@
 
 #include <kafka4seastar/connection/kafka_connection.hh>
 
+#include <algorithm>
+
 using namespace seastar;
 
 namespace kafka4seastar {
 
 future<std::unique_ptr<kafka_connection>> kafka_connection::connect(const seastar::sstring& host, uint16_t port,
-        const seastar::sstring& client_id, uint32_t timeout_ms) {
-    return tcp_connection::connect(host, port, timeout_ms)
-    .then([client_id] (tcp_connection connection) {
-        return std::make_unique<kafka_connection>(std::move(connection), client_id);
-    }).then([] (std::unique_ptr<kafka_connection> connection) {
+        const seastar::sstring& client_id, uint32_t timeout_ms, const connection_properties& properties,
+        std::optional<api_versions_response> cached_api_versions, tls_parameters tls) {
+    return tcp_connection::connect(host, port, timeout_ms, properties, std::move(tls))
+    .then([client_id, limits = decode_limits{properties.max_string_length, properties.max_array_length}]
+            (tcp_connection connection) {
+        return std::make_unique<kafka_connection>(std::move(connection), client_id, limits);
+    }).then([cached_api_versions = std::move(cached_api_versions)] (std::unique_ptr<kafka_connection> connection) mutable {
+        if (cached_api_versions) {
+            // Requests sent meanwhile are queued behind ApiVersions on the same connection.
+            connection->_api_versions = std::move(*cached_api_versions);
+            connection->_api_versions_refresh = connection->init();
+            return make_ready_future<std::unique_ptr<kafka_connection>>(std::move(connection));
+        }
         auto f = connection->init();
         return f.then([connection = std::move(connection)] () mutable {
             return std::move(connection);
@@ -40,15 +50,33 @@ future<std::unique_ptr<kafka_connection>> kafka_connection::connect(const seasta
 }
 
 future<> kafka_connection::init() {
+    return negotiate_api_versions(api_versions_request::MAX_SUPPORTED_VERSION);
+}
+
+future<> kafka_connection::negotiate_api_versions(int16_t api_version) {
     api_versions_request request;
-    return send(request, api_versions_request::MAX_SUPPORTED_VERSION)
-            .then([this](api_versions_response response) {
-                _api_versions = response;
+    return send(request, api_version)
+            .then([this, api_version](api_versions_response response) {
+                if (response.error_code == error::kafka_error_code::UNSUPPORTED_VERSION && api_version > 0) {
+                    // Brokers older than the client list the versions of ApiVersions they support.
+                    auto broker_versions = response.api_keys.is_null()
+                            ? api_versions_response_key() : response[api_versions_request::API_KEY];
+                    auto retry_version = *broker_versions.api_key == api_versions_request::API_KEY
+                            ? std::min<int16_t>(*broker_versions.max_version, api_version - 1) : 0;
+                    return negotiate_api_versions(retry_version);
+                }
+                // A failed refresh keeps the versions negotiated before.
+                if (response.error_code == error::kafka_error_code::NONE || _api_versions.api_keys.is_null()) {
+                    _api_versions = response;
+                }
+                return make_ready_future<>();
             });
 }
 
 future<> kafka_connection::close() {
-    return _connection.close();
+    return _connection.close().finally([this] {
+        return std::move(_api_versions_refresh);
+    });
 }
 
 }
@@ -20,8 +20,15 @@
  * Copyright (C) 2019 ScyllaDB Ltd.
  */
 
+#include <algorithm>
+#include <cstring>
+
+#include <seastar/core/future-util.hh>
 #include <seastar/core/reactor.hh>
-#include <seastar/net/dns.hh>
+#include <seastar/core/sleep.hh>
+#include <seastar/core/shared_ptr.hh>
+#include <seastar/net/tls.hh>
+#include <kafka4seastar/connection/dns_cache.hh>
 #include <kafka4seastar/connection/tcp_connection.hh>
 
 using namespace seastar;
@@ -32,44 +39,286 @@ static auto timeout_end(uint32_t timeout_ms) {
     return std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
 }
 
+static future<connected_socket> connect_to(const net::inet_address& target_host, uint16_t port) {
+    sa_family_t family = target_host.is_ipv4() ? sa_family_t(AF_INET) : sa_family_t(AF_INET6);
+    socket_address socket = socket_address(::sockaddr_in{family, INADDR_ANY, {0}});
+    return target_host.is_ipv4()
+           ? engine().net().connect(ipv4_addr{target_host, port}, socket, transport::TCP)
+           : engine().net().connect(ipv6_addr{target_host, port}, socket, transport::TCP);
+}
+
+namespace {
+
+// Connection attempts to the addresses of a host (happy eyeballs, RFC 8305):
+// the next address is tried as soon as the previous attempt fails, or after
+// the stagger delay if it's still pending. The first established connection
+// wins, the ones established later are dropped.
+struct connect_race {
+    std::vector<net::inet_address> addresses;
+    uint16_t port;
+    std::chrono::milliseconds stagger;
+    size_t next = 0;
+    size_t failed = 0;
+    bool done = false;
+    promise<std::pair<net::inet_address, connected_socket>> result;
+
+    void try_next(lw_shared_ptr<connect_race> self, size_t attempt) {
+        if (done || attempt != next || next == addresses.size()) {
+            return;
+        }
+        ++next;
+        auto address = addresses[attempt];
+        (void) connect_to(address, port).then_wrapped([self, address] (future<connected_socket> f) {
+            if (f.failed()) {
+                auto ep = f.get_exception();
+                if (++self->failed == self->addresses.size() && !self->done) {
+                    self->done = true;
+                    self->result.set_exception(ep);
+                } else {
+                    self->try_next(self, self->next);
+                }
+                return;
+            }
+            if (!self->done) {
+                self->done = true;
+                self->result.set_value(std::make_pair(address, f.get0()));
+            }
+        });
+        if (next < addresses.size()) {
+            (void) seastar::sleep(stagger).then([self, attempt] {
+                self->try_next(self, attempt + 1);
+            });
+        }
+    }
+};
+
+}
+
 future<tcp_connection> tcp_connection::connect(const seastar::sstring& host, uint16_t port,
-        uint32_t timeout_ms) {
-    return seastar::net::dns::resolve_name(host).then([port, timeout_ms] (net::inet_address target_host) {
-        sa_family_t family = target_host.is_ipv4() ? sa_family_t(AF_INET) : sa_family_t(AF_INET6);
-        socket_address socket = socket_address(::sockaddr_in{family, INADDR_ANY, {0}});
-        auto f = target_host.is_ipv4()
-                 ? engine().net().connect(ipv4_addr{target_host, port}, socket, transport::TCP)
-                 : engine().net().connect(ipv6_addr{target_host, port}, socket, transport::TCP);
+        uint32_t timeout_ms, const connection_properties& properties, tls_parameters tls) {
+    auto& cache = dns_cache::local();
+    return cache.resolve(host, std::chrono::milliseconds(properties.dns_ttl),
+            std::chrono::milliseconds(properties.dns_negative_ttl))
+    .then([&cache, host, port, timeout_ms, properties, tls = std::move(tls)] (std::vector<net::inet_address> addresses) mutable {
+        auto race = make_lw_shared<connect_race>();
+        race->addresses = std::move(addresses);
+        race->port = port;
+        race->stagger = std::chrono::milliseconds(properties.connect_stagger);
+        auto f = race->result.get_future();
+        race->try_next(race, 0);
+
         auto f_timeout = seastar::with_timeout(timeout_end(timeout_ms), std::move(f));
-        return f_timeout.then([target_host = std::move(target_host), timeout_ms, port] (connected_socket fd) {
-                                  return tcp_connection(target_host, port, timeout_ms, std::move(fd));
-                              }
-        );
+        return f_timeout.then_wrapped([&cache, host, timeout_ms, port, properties, tls = std::move(tls)]
+                (future<std::pair<net::inet_address, connected_socket>> f) mutable {
+            if (f.failed()) {
+                cache.expire_within(host, std::chrono::milliseconds(properties.dns_negative_ttl));
+                return make_exception_future<tcp_connection>(f.get_exception());
+            }
+            auto [target_host, fd] = f.get0();
+            if (!tls.credentials) {
+                return make_ready_future<tcp_connection>(tcp_connection(target_host, port, timeout_ms, properties, std::move(fd)));
+            }
+
+            tls::tls_options options;
+            options.server_name = properties.tls_server_name.empty() ? host : properties.tls_server_name;
+            options.session_resume_data = std::move(tls.session);
+            return tls::wrap_client(tls.credentials, std::move(fd), std::move(options))
+            .then([target_host = target_host, port, timeout_ms, properties] (connected_socket fd) {
+                return tcp_connection(target_host, port, timeout_ms, properties, std::move(fd), true);
+            });
+        });
+    });
+}
+
+future<shared_ptr<tls::certificate_credentials>> tcp_connection::make_tls_credentials(
+        const connection_properties& properties) {
+    if (!properties.tls) {
+        return make_ready_future<shared_ptr<tls::certificate_credentials>>();
+    }
+
+    auto credentials = make_shared<tls::certificate_credentials>();
+    auto trust = properties.tls_ca_file.empty()
+                 ? credentials->set_system_trust()
+                 : credentials->set_x509_trust_file(properties.tls_ca_file, tls::x509_crt_format::PEM);
+    return trust.then([credentials, properties] {
+        if (properties.tls_certificate_file.empty() || properties.tls_key_file.empty()) {
+            return make_ready_future<>();
+        }
+        return credentials->set_x509_key_file(properties.tls_certificate_file, properties.tls_key_file,
+                tls::x509_crt_format::PEM);
+    }).then([credentials] {
+        return credentials;
+    });
+}
+
+future<tls::session_data> tcp_connection::tls_session() {
+    if (!_tls) {
+        return make_ready_future<tls::session_data>();
+    }
+    return tls::get_session_resume_data(_fd);
+}
+
+future<bool> tcp_connection::tls_session_resumed() {
+    if (!_tls) {
+        return make_ready_future<bool>(false);
+    }
+    return tls::check_session_is_resumed(_fd);
+}
+
+future<temporary_buffer<char>> tcp_connection::premature_end() {
+    _fd.shutdown_input();
+    _fd.shutdown_output();
+    return make_exception_future<temporary_buffer<char>>(tcp_connection_exception("Connection ended prematurely"));
+}
+
+future<temporary_buffer<char>> tcp_connection::read_buffered(size_t bytes_to_read) {
+    if (_read_ahead.size() >= bytes_to_read) {
+        auto data = _read_ahead.share(0, bytes_to_read);
+        _read_ahead.trim_front(bytes_to_read);
+        return make_ready_future<temporary_buffer<char>>(std::move(data));
+    }
+
+    if (_read_ahead.empty()) {
+        return _read_buf.read().then([this, bytes_to_read] (temporary_buffer<char> data) {
+            if (data.empty()) {
+                return premature_end();
+            }
+            _read_ahead = std::move(data);
+            return read_buffered(bytes_to_read);
+        });
+    }
+
+    // The data straddles the buffers, so it has to be copied.
+    temporary_buffer<char> data(bytes_to_read);
+    auto buffered = _read_ahead.size();
+    std::copy(_read_ahead.begin(), _read_ahead.end(), data.get_write());
+    _read_ahead = temporary_buffer<char>();
+    return _read_buf.read_exactly(bytes_to_read - buffered)
+    .then([this, data = std::move(data), buffered] (temporary_buffer<char> rest) mutable {
+        if (rest.size() != data.size() - buffered) {
+            return premature_end();
+        }
+        std::copy(rest.begin(), rest.end(), data.get_write() + buffered);
+        return make_ready_future<temporary_buffer<char>>(std::move(data));
+    });
+}
+
+future<temporary_buffer<char>> tcp_connection::with_read_deadline(future<temporary_buffer<char>> read_future) {
+    _read_timed_out = false;
+    _read_timer.set_callback([this] {
+        _read_timed_out = true;
+        _fd.shutdown_input();
+    });
+    _read_timer.arm(lowres_clock::now() + std::chrono::milliseconds(_timeout_ms));
+    return read_future.then_wrapped([this] (future<temporary_buffer<char>> f) {
+        _read_timer.cancel();
+        if (_read_timed_out) {
+            f.ignore_ready_future();
+            return make_exception_future<temporary_buffer<char>>(timed_out_error());
+        }
+        return f;
     });
 }
 
 future<temporary_buffer<char>> tcp_connection::read(size_t bytes_to_read) {
-    auto f = _read_buf.read_exactly(bytes_to_read)
-        .then([this, bytes_to_read](temporary_buffer<char> data) {
-            if (data.size() != bytes_to_read) {
+    return with_read_deadline(read_buffered(bytes_to_read));
+}
+
+future<tcp_connection::frame> tcp_connection::read_frame() {
+    return with_read_deadline(read_buffered(4)).then([this] (temporary_buffer<char> frame_size) {
+        int32_t size;
+        std::memcpy(&size, frame_size.get(), sizeof(size));
+        size = net::ntoh(size);
+        if (size < 0) {
+            _fd.shutdown_input();
+            _fd.shutdown_output();
+            return make_exception_future<frame>(tcp_connection_exception("Received frame of negative size"));
+        }
+        if (static_cast<uint32_t>(size) > _properties.max_response_size) {
+            _fd.shutdown_input();
+            _fd.shutdown_output();
+            return make_exception_future<frame>(tcp_connection_exception("Received frame larger than max_response_size"));
+        }
+        // A frame larger than the whole budget takes all of it, so that it can be read at all.
+        // The wait is not a part of the read, so the read deadline doesn't run meanwhile.
+        auto units = std::min<size_t>(size, _properties.max_response_memory);
+        return _response_memory->wait(timeout_end(_timeout_ms), units).then_wrapped([this, size, units] (future<> f) {
+            if (f.failed()) {
+                // The size of the frame is read already, the rest can't be skipped.
                 _fd.shutdown_input();
                 _fd.shutdown_output();
-                throw tcp_connection_exception("Connection ended prematurely");
+                return make_exception_future<frame>(f.get_exception());
             }
-            return data;
+            auto memory = make_deleter([memory = _response_memory, units] {
+                memory->signal(units);
+            });
+            return with_read_deadline(read_buffered(size)).then([memory = std::move(memory)] (temporary_buffer<char> data) mutable {
+                return frame{std::move(data), std::move(memory)};
+            });
         });
-    return seastar::with_timeout(timeout_end(_timeout_ms), std::move(f));
+    });
 }
 
 future<> tcp_connection::write(temporary_buffer<char> buff) {
-    auto f = _write_buf.write(std::move(buff)).then([this] {
-        return _write_buf.flush();
-    });
+    _batch_bytes += buff.size();
+    _batch.emplace_back(std::move(buff));
+    if (!_batch_flushed) {
+        _batch_flushed = std::make_unique<shared_promise<>>();
+        schedule_flush();
+    }
+    auto f = _batch_flushed->get_shared_future();
+    if (_batch_bytes >= _properties.max_flush_bytes) {
+        flush_batch();
+    }
     return seastar::with_timeout(timeout_end(_timeout_ms), std::move(f));
 }
 
+void tcp_connection::schedule_flush() {
+    auto wait = _properties.flush_window == 0
+            ? seastar::later()
+            : seastar::sleep(std::chrono::microseconds(_properties.flush_window));
+    auto trigger = wait.then([this, batch_id = _batch_id] {
+        // The batch might have been flushed already after reaching max_flush_bytes.
+        if (batch_id == _batch_id) {
+            flush_batch();
+        }
+    });
+    _flush_trigger = when_all_succeed(std::move(_flush_trigger), std::move(trigger)).discard_result();
+}
+
+void tcp_connection::flush_batch() {
+    if (!_batch_flushed) {
+        return;
+    }
+    ++_batch_id;
+    _batch_bytes = 0;
+    _flushing = _flushing.then([this, batch = std::exchange(_batch, {})] () mutable {
+        return do_with(std::move(batch), [this] (std::vector<temporary_buffer<char>>& batch) {
+            return do_for_each(batch, [this] (temporary_buffer<char>& buff) {
+                return _write_buf.write(std::move(buff));
+            });
+        }).then([this] {
+            return _write_buf.flush();
+        });
+    }).then_wrapped([batch_flushed = std::move(_batch_flushed)] (future<> f) {
+        if (f.failed()) {
+            batch_flushed->set_exception(f.get_exception());
+        } else {
+            batch_flushed->set_value();
+        }
+    });
+}
+
 future<> tcp_connection::close() {
-    return when_all_succeed(_read_buf.close(), _write_buf.close())
+    flush_batch();
+    auto pending = when_all_succeed(std::move(_flush_trigger), std::move(_flushing)).discard_result();
+    _flush_trigger = make_ready_future<>();
+    _flushing = make_ready_future<>();
+    return pending.handle_exception([] (std::exception_ptr ep) {
+        // Reported to the writers already.
+    }).then([this] {
+        return when_all_succeed(_read_buf.close(), _write_buf.close());
+    })
     .discard_result().handle_exception([](std::exception_ptr ep) {
         // Ignore close exceptions.
     });
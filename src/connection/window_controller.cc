@@ -0,0 +1,67 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (C) 2019 ScyllaDB Ltd.
+ */
+
+#include <algorithm>
+
+#include <kafka4seastar/connection/window_controller.hh>
+
+namespace kafka4seastar {
+
+window_controller::window_controller(uint32_t initial_window, uint32_t max_window)
+        : _window(std::clamp<double>(initial_window, 1, std::max<uint32_t>(max_window, 1))),
+        _max_window(std::max<uint32_t>(max_window, 1)) {}
+
+void window_controller::on_success(double rtt_ms) {
+    _rtt_ms = _samples == 0 ? rtt_ms : EWMA_WEIGHT * rtt_ms + (1 - EWMA_WEIGHT) * _rtt_ms;
+    if (_samples == 0 || rtt_ms < _base_rtt_ms) {
+        _base_rtt_ms = rtt_ms;
+    }
+    if (++_samples == BASE_RTT_SAMPLES) {
+        _samples = 1;
+        _base_rtt_ms = _rtt_ms;
+    }
+
+    if (_rtt_ms <= 0) {
+        _window = std::min(_window + 1 / _window, _max_window);
+        return;
+    }
+    auto queued = _window * (1 - _base_rtt_ms / _rtt_ms);
+    if (queued < ALPHA) {
+        _window = std::min(_window + 1 / _window, _max_window);
+    } else if (queued > BETA) {
+        _window = std::max(_window - 1 / _window, 1.0);
+    }
+}
+
+void window_controller::on_congestion() {
+    _window = std::max(_window / 2, 1.0);
+}
+
+uint32_t window_controller::window() const noexcept {
+    return static_cast<uint32_t>(_window);
+}
+
+double window_controller::rtt_ms() const noexcept {
+    return _rtt_ms;
+}
+
+}
@@ -0,0 +1,143 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (C) 2019 ScyllaDB Ltd.
+ */
+
+
+#include <limits>
+
+#include <kafka4seastar/consumer/fetch_session.hh>
+
+using namespace seastar;
+
+namespace kafka4seastar {
+
+static void add_partition(std::map<sstring, std::vector<fetch_request_partition>>& topics,
+        const topic_partition& partition, const fetch_session::partition_data& data) {
+    fetch_request_partition request_partition;
+    request_partition.partition_index = partition.second;
+    request_partition.current_leader_epoch = -1;
+    request_partition.fetch_offset = data.fetch_offset;
+    request_partition.last_fetched_epoch = -1;
+    request_partition.log_start_offset = -1;
+    request_partition.partition_max_bytes = data.max_bytes;
+    topics[partition.first].emplace_back(std::move(request_partition));
+}
+
+fetch_request fetch_session::build_request(const partitions& wanted) {
+    std::map<sstring, std::vector<fetch_request_partition>> topics;
+    std::map<sstring, std::vector<kafka_int32_t>> forgotten_topics;
+
+    if (is_incremental()) {
+        for (const auto& [partition, data] : wanted) {
+            auto known = _session_partitions.find(partition);
+            if (known == _session_partitions.end() || !(known->second == data)) {
+                add_partition(topics, partition, data);
+            }
+        }
+        for (const auto& [partition, data] : _session_partitions) {
+            if (!wanted.count(partition)) {
+                forgotten_topics[partition.first].emplace_back(partition.second);
+            }
+        }
+    } else {
+        for (const auto& [partition, data] : wanted) {
+            add_partition(topics, partition, data);
+        }
+    }
+    _pending_partitions = wanted;
+
+    fetch_request request;
+    request.session_id = _session_id;
+    request.session_epoch = _epoch;
+
+    std::vector<fetch_request_topic> request_topics;
+    for (auto& [name, topic_partitions] : topics) {
+        fetch_request_topic topic;
+        topic.name = name;
+        topic.partitions = std::move(topic_partitions);
+        request_topics.emplace_back(std::move(topic));
+    }
+    request.topics = std::move(request_topics);
+
+    std::vector<fetch_request_forgotten_topic> request_forgotten_topics;
+    for (auto& [name, topic_partitions] : forgotten_topics) {
+        fetch_request_forgotten_topic topic;
+        topic.name = name;
+        topic.partitions = std::move(topic_partitions);
+        request_forgotten_topics.emplace_back(std::move(topic));
+    }
+    request.forgotten_topics = std::move(request_forgotten_topics);
+
+    return request;
+}
+
+bool fetch_session::handle_response(const fetch_response& response) {
+    if (response.error_code != error::kafka_error_code::NONE) {
+        // FETCH_SESSION_ID_NOT_FOUND and INVALID_FETCH_SESSION_EPOCH mean the
+        // broker evicted the session or we got out of sync with it, after
+        // a network error the state of the session is unknown too.
+        reset();
+        return false;
+    }
+
+    if (*response.session_id == INVALID_SESSION_ID) {
+        // The broker didn't create a session (e.g. its cache is full).
+        reset();
+        return true;
+    }
+
+    _session_id = *response.session_id;
+    _epoch = _epoch == std::numeric_limits<int32_t>::max() ? 1 : _epoch + 1;
+    _session_partitions = std::move(_pending_partitions);
+    _pending_partitions.clear();
+    return true;
+}
+
+fetch_request fetch_session::close_request() {
+    fetch_request request;
+    request.session_id = _session_id;
+    request.session_epoch = FINAL_EPOCH;
+    request.topics = std::vector<fetch_request_topic>();
+    request.forgotten_topics = std::vector<fetch_request_forgotten_topic>();
+    reset();
+    return request;
+}
+
+void fetch_session::reset() {
+    _session_id = INVALID_SESSION_ID;
+    _epoch = INITIAL_EPOCH;
+    _session_partitions.clear();
+    _pending_partitions.clear();
+}
+
+bool fetch_session::is_incremental() const {
+    return _session_id != INVALID_SESSION_ID && _epoch != INITIAL_EPOCH;
+}
+
+int32_t fetch_session::session_id() const {
+    return _session_id;
+}
+
+int32_t fetch_session::epoch() const {
+    return _epoch;
+}
+
+}
@@ -0,0 +1,452 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (C) 2019 ScyllaDB Ltd.
+ */
+
+
+#include <algorithm>
+#include <utility>
+
+#include <seastar/core/future-util.hh>
+#include <seastar/core/sleep.hh>
+
+#include <kafka4seastar/consumer/fetcher.hh>
+#include <kafka4seastar/protocol/list_offsets_request.hh>
+
+using namespace seastar;
+
+namespace kafka4seastar {
+
+fetcher::fetcher(connection_manager& connection_manager, metadata_manager& metadata_manager,
+        offset_manager& offset_manager, consumer_properties& properties)
+        : _connection_manager(connection_manager),
+        _metadata_manager(metadata_manager),
+        _offset_manager(offset_manager),
+        _properties(properties) {}
+
+std::optional<fetcher::broker_handle> fetcher::leader_for(const topic_partition& partition) {
+    const auto& metadata = _metadata_manager.get_metadata();
+    if (metadata.topics.is_null()) {
+        return std::nullopt;
+    }
+
+    auto topic_candidate = std::lower_bound(metadata.topics->begin(), metadata.topics->end(), partition.first,
+            [] (auto& a, auto& b) {
+        return *a.name < b;
+    });
+
+    if (topic_candidate != metadata.topics->end() && *topic_candidate->name == partition.first
+            && topic_candidate->error_code == error::kafka_error_code::NONE) {
+        auto it = std::lower_bound(topic_candidate->partitions->begin(), topic_candidate->partitions->end(),
+                partition.second, [] (auto& a, auto& b) {
+            return *a.partition_index < b;
+        });
+
+        if (it != topic_candidate->partitions->end() && *it->partition_index == partition.second
+                && it->error_code == error::kafka_error_code::NONE) {
+            auto leader = _metadata_manager.broker_handle_for(*it->leader_id);
+            if (leader != connection_manager::NO_BROKER) {
+                return leader;
+            }
+        }
+    }
+
+    return std::nullopt;
+}
+
+void fetcher::assign(const std::set<topic_partition>& assignment) {
+    for (auto it = _positions.begin(); it != _positions.end();) {
+        if (assignment.count(it->first)) {
+            ++it;
+        } else {
+            _consumed_positions.erase(it->first);
+            drop_buffered(it->first);
+            it = _positions.erase(it);
+        }
+    }
+    for (auto it = _paused.begin(); it != _paused.end();) {
+        it = assignment.count(*it) ? std::next(it) : _paused.erase(it);
+    }
+    _assignment = assignment;
+    maybe_fetch();
+}
+
+void fetcher::seek(const topic_partition& partition, int64_t offset) {
+    if (_assignment.count(partition)) {
+        drop_buffered(partition);
+        _positions[partition] = offset;
+        _consumed_positions[partition] = offset;
+        maybe_fetch();
+    }
+}
+
+std::optional<int64_t> fetcher::position(const topic_partition& partition) const {
+    auto it = _consumed_positions.find(partition);
+    if (it == _consumed_positions.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+void fetcher::pause(const topic_partition& partition) {
+    if (_assignment.count(partition)) {
+        _paused.insert(partition);
+    }
+}
+
+void fetcher::resume(const topic_partition& partition) {
+    if (_paused.erase(partition)) {
+        maybe_fetch();
+        // Its buffered records can be returned to a poll() waiting already.
+        _fetch_completed.broadcast();
+    }
+}
+
+void fetcher::drop_buffered(const topic_partition& partition) {
+    auto buffered = _buffered_bytes_per_partition.find(partition);
+    if (buffered == _buffered_bytes_per_partition.end()) {
+        return;
+    }
+    _buffered_bytes -= buffered->second;
+    _buffered_bytes_per_partition.erase(buffered);
+    _completed.erase(std::remove_if(_completed.begin(), _completed.end(), [&partition] (auto& completed) {
+        return completed.partition == partition;
+    }), _completed.end());
+}
+
+void fetcher::maybe_fetch() {
+    if (_stopped) {
+        return;
+    }
+
+    if (!_resetting_positions && _positions.size() < _assignment.size()) {
+        _resetting_positions = true;
+        (void) with_gate(_pending_fetches, [this] {
+            return reset_positions().handle_exception([] (std::exception_ptr ep) {
+                // Positions are looked up again after the backoff.
+            }).then([this] {
+                // Some partitions might have no leader at the moment.
+                return _positions.size() < _assignment.size()
+                        ? seastar::sleep(std::chrono::milliseconds(_properties.retry_backoff))
+                        : make_ready_future<>();
+            }).finally([this] {
+                _resetting_positions = false;
+                maybe_fetch();
+            });
+        });
+    }
+
+    if (_buffered_bytes >= _properties.max_buffered_bytes) {
+        return;
+    }
+
+    // Paused partitions and the ones over their cap are requested with
+    // no bytes, so that they aren't forgotten by the session and added
+    // back once they can be fetched again.
+    std::map<broker_handle, fetch_session::partitions> partitions_by_leader;
+    std::set<broker_handle> leaders;
+    std::set<broker_handle> fetchable;
+    for (const auto& [partition, offset] : _positions) {
+        auto leader = leader_for(partition);
+        if (!leader) {
+            continue;
+        }
+        leaders.insert(*leader);
+        if (_in_flight.count(*leader)) {
+            continue;
+        }
+        auto buffered = _buffered_bytes_per_partition.find(partition);
+        auto held = _paused.count(partition) || (buffered != _buffered_bytes_per_partition.end()
+                && buffered->second >= _properties.max_partition_buffered_bytes);
+        auto max_bytes = held ? 0 : static_cast<int32_t>(_properties.max_partition_fetch_bytes);
+        partitions_by_leader[*leader][partition] = {offset, max_bytes};
+        if (!held) {
+            fetchable.insert(*leader);
+        }
+    }
+
+    for (auto& [broker, session] : _sessions) {
+        if (leaders.count(broker) || _in_flight.count(broker)
+                || session.session_id() == fetch_session::INVALID_SESSION_ID) {
+            continue;
+        }
+        _in_flight.insert(broker);
+        (void) with_gate(_pending_fetches, [this, broker = broker] {
+            return close_session(broker).finally([this, broker] {
+                _in_flight.erase(broker);
+                maybe_fetch();
+            });
+        });
+    }
+
+    for (auto& [leader, partitions] : partitions_by_leader) {
+        if (!fetchable.count(leader)) {
+            continue;
+        }
+        _in_flight.insert(leader);
+        (void) with_gate(_pending_fetches, [this, leader = leader, partitions = std::move(partitions)] () mutable {
+            return do_with(std::move(partitions), [this, leader] (fetch_session::partitions& partitions) {
+                return fetch_from(leader, partitions);
+            }).handle_exception([this] (std::exception_ptr ep) {
+                // E.g. a corrupted batch, reported by the next poll().
+                _fetch_error = ep;
+                _fetch_completed.broadcast();
+                return seastar::sleep(std::chrono::milliseconds(_properties.retry_backoff));
+            }).finally([this, leader] {
+                _in_flight.erase(leader);
+                maybe_fetch();
+            });
+        });
+    }
+}
+
+future<> fetcher::reset_positions() {
+    std::vector<topic_partition> unpositioned;
+    for (const auto& partition : _assignment) {
+        if (!_positions.count(partition)) {
+            unpositioned.push_back(partition);
+        }
+    }
+    if (unpositioned.empty()) {
+        return make_ready_future<>();
+    }
+
+    // Committed offsets take precedence, auto_offset_reset
+    // applies only to partitions with nothing committed.
+    return _offset_manager.fetch_committed(unpositioned).then([this] (std::map<topic_partition, int64_t> committed) {
+        for (const auto& [partition, offset] : committed) {
+            if (_assignment.count(partition) && !_positions.count(partition)) {
+                _positions[partition] = offset;
+                _consumed_positions[partition] = offset;
+            }
+        }
+        return reset_to_policy();
+    });
+}
+
+future<> fetcher::reset_to_policy() {
+    std::map<broker_handle, std::map<sstring, std::vector<list_offsets_request_partition>>> requests;
+    auto timestamp = _properties.auto_offset_reset == offset_reset_policy::EARLIEST
+            ? list_offsets_request_partition::EARLIEST_TIMESTAMP
+            : list_offsets_request_partition::LATEST_TIMESTAMP;
+
+    for (const auto& partition : _assignment) {
+        if (_positions.count(partition)) {
+            continue;
+        }
+        auto leader = leader_for(partition);
+        if (!leader) {
+            continue;
+        }
+        list_offsets_request_partition request_partition;
+        request_partition.partition_index = partition.second;
+        request_partition.current_leader_epoch = -1;
+        request_partition.timestamp = timestamp;
+        requests[*leader][partition.first].emplace_back(std::move(request_partition));
+    }
+
+    return parallel_for_each(requests, [this] (auto& broker_request) {
+        list_offsets_request request;
+        request.replica_id = -1;
+        request.isolation_level = 0;
+
+        std::vector<list_offsets_request_topic> topics;
+        for (auto& [name, partitions] : broker_request.second) {
+            list_offsets_request_topic topic;
+            topic.name = name;
+            topic.partitions = std::move(partitions);
+            topics.emplace_back(std::move(topic));
+        }
+        request.topics = std::move(topics);
+
+        const auto& broker = broker_request.first;
+        return _connection_manager.send(std::move(request), broker, _properties.request_timeout)
+        .then([this] (list_offsets_response response) {
+            if (response.error_code != error::kafka_error_code::NONE) {
+                return;
+            }
+            for (const auto& topic : *response.topics) {
+                for (const auto& partition : *topic.partitions) {
+                    topic_partition reset_partition(*topic.name, *partition.partition_index);
+                    if (partition.error_code == error::kafka_error_code::NONE
+                            && _assignment.count(reset_partition) && !_positions.count(reset_partition)) {
+                        _positions[reset_partition] = *partition.offset;
+                        _consumed_positions[reset_partition] = *partition.offset;
+                    }
+                }
+            }
+        });
+    });
+}
+
+void fetcher::handle_partition(const sstring& topic, const fetch_response_partition& partition,
+        const fetch_session::partitions& requested) {
+    topic_partition response_partition(topic, *partition.partition_index);
+    auto position = _positions.find(response_partition);
+    auto request = requested.find(response_partition);
+    if (position == _positions.end() || request == requested.end()
+            || request->second.fetch_offset != position->second) {
+        // Not assigned anymore, or the position changed while the request was in flight.
+        return;
+    }
+    if (request->second.max_bytes == 0) {
+        // Held in the session only, a broker can still return
+        // a single batch to make progress, it's fetched again later.
+        return;
+    }
+
+    if (partition.error_code == error::kafka_error_code::OFFSET_OUT_OF_RANGE) {
+        drop_buffered(response_partition);
+        _consumed_positions.erase(response_partition);
+        _positions.erase(position);
+        return;
+    }
+    if (partition.error_code != error::kafka_error_code::NONE || partition.records.is_null()) {
+        return;
+    }
+
+    fetched_partition result;
+    result.partition = response_partition;
+    result.first_offset = position->second;
+    for (auto& batch : partition.records.batches()) {
+        if (batch.last_offset() < position->second) {
+            continue;
+        }
+        position->second = batch.last_offset() + 1;
+        if (!batch.is_control_batch()) {
+            result.size_bytes += batch.buffer().size();
+            result.batches.emplace_back(std::move(batch));
+        }
+    }
+    result.next_offset = position->second;
+
+    if (!result.batches.empty()) {
+        _buffered_bytes += result.size_bytes;
+        _buffered_bytes_per_partition[response_partition] += result.size_bytes;
+        _completed.emplace_back(std::move(result));
+    } else if (!_buffered_bytes_per_partition.count(response_partition)) {
+        // Only control batches, nothing to be returned by poll().
+        _consumed_positions[response_partition] = result.next_offset;
+    }
+}
+
+future<> fetcher::fetch_from(broker_handle broker, const fetch_session::partitions& partitions) {
+    auto request = _sessions[broker].build_request(partitions);
+    request.replica_id = -1;
+    request.max_wait_ms = _properties.fetch_max_wait;
+    request.min_bytes = _properties.fetch_min_bytes;
+    request.max_bytes = _properties.fetch_max_bytes;
+    request.isolation_level = 0;
+    request.rack_id = "";
+
+    // Only one fetch is in flight per broker, so it can take any of its connections.
+    return _connection_manager.send(std::move(request), broker, _properties.request_timeout,
+            true, connection_manager::ANY_LANE)
+    .then([this, broker, &partitions] (fetch_response response) {
+        if (!_sessions[broker].handle_response(response)) {
+            // Don't hammer a broker which keeps failing.
+            return seastar::sleep(std::chrono::milliseconds(_properties.retry_backoff));
+        }
+        for (const auto& topic : *response.topics) {
+            for (const auto& partition : *topic.partitions) {
+                handle_partition(*topic.name, partition, partitions);
+            }
+        }
+        _fetch_completed.broadcast();
+        return make_ready_future<>();
+    });
+}
+
+future<> fetcher::close_session(broker_handle broker) {
+    auto request = _sessions[broker].close_request();
+    request.replica_id = -1;
+    request.max_wait_ms = 0;
+    request.min_bytes = 0;
+    request.max_bytes = _properties.fetch_max_bytes;
+    request.isolation_level = 0;
+    request.rack_id = "";
+
+    return _connection_manager.send(std::move(request), broker, _properties.request_timeout,
+            true, connection_manager::ANY_LANE).discard_result().handle_exception([] (std::exception_ptr ep) {
+        // The broker evicts the session after a while anyway.
+    });
+}
+
+bool fetcher::ready_to_poll() const {
+    if (_fetch_error || _stopped) {
+        return true;
+    }
+    return std::any_of(_completed.begin(), _completed.end(), [this] (const fetched_partition& completed) {
+        return !_paused.count(completed.partition);
+    });
+}
+
+future<std::vector<fetched_partition>> fetcher::poll(std::chrono::milliseconds timeout) {
+    maybe_fetch();
+
+    auto wait_future = ready_to_poll()
+            ? make_ready_future<>()
+            : _fetch_completed.wait(timeout, [this] {
+                return ready_to_poll();
+            }).handle_exception_type([] (condition_variable_timed_out&) {});
+
+    return wait_future.then([this] {
+        if (_fetch_error) {
+            std::rethrow_exception(std::exchange(_fetch_error, nullptr));
+        }
+
+        std::vector<fetched_partition> fetched;
+        std::deque<fetched_partition> held_back;
+        for (auto& completed : _completed) {
+            if (_paused.count(completed.partition)) {
+                held_back.emplace_back(std::move(completed));
+                continue;
+            }
+            auto& buffered = _buffered_bytes_per_partition[completed.partition];
+            buffered -= completed.size_bytes;
+            if (buffered == 0) {
+                _buffered_bytes_per_partition.erase(completed.partition);
+            }
+            _buffered_bytes -= completed.size_bytes;
+            _consumed_positions[completed.partition] = completed.next_offset;
+            fetched.emplace_back(std::move(completed));
+        }
+        _completed = std::move(held_back);
+
+        // Space was freed, so the partitions over their limits can be fetched again.
+        maybe_fetch();
+        return fetched;
+    });
+}
+
+future<> fetcher::stop() {
+    _stopped = true;
+    _fetch_completed.broadcast();
+    return _pending_fetches.close().then([this] {
+        return parallel_for_each(_sessions, [this] (auto& broker_session) {
+            if (broker_session.second.session_id() == fetch_session::INVALID_SESSION_ID) {
+                return make_ready_future<>();
+            }
+            return close_session(broker_session.first);
+        });
+    });
+}
+
+}
@@ -0,0 +1,458 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (C) 2019 ScyllaDB Ltd.
+ */
+
+
+#include <algorithm>
+#include <iterator>
+
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/stream.hpp>
+
+#include <seastar/core/sleep.hh>
+
+#include <kafka4seastar/consumer/group_manager.hh>
+#include <kafka4seastar/protocol/consumer_protocol.hh>
+#include <kafka4seastar/protocol/find_coordinator_request.hh>
+#include <kafka4seastar/protocol/heartbeat_request.hh>
+#include <kafka4seastar/protocol/join_group_request.hh>
+#include <kafka4seastar/protocol/leave_group_request.hh>
+
+using namespace seastar;
+
+namespace kafka4seastar {
+
+template<typename MessageType>
+static sstring serialize_to_bytes(const MessageType& message, int16_t version) {
+    std::vector<char> data;
+    boost::iostreams::back_insert_device<std::vector<char>> data_sink{data};
+    boost::iostreams::stream<boost::iostreams::back_insert_device<std::vector<char>>> data_stream{data_sink};
+    message.serialize(data_stream, version);
+    data_stream.flush();
+    return sstring(data.data(), data.size());
+}
+
+static std::vector<consumer_protocol_topic_partitions> group_by_topic(const std::vector<topic_partition>& partitions) {
+    std::map<sstring, std::vector<kafka_int32_t>> partitions_by_topic;
+    for (const auto& [topic, partition] : partitions) {
+        partitions_by_topic[topic].emplace_back(partition);
+    }
+
+    std::vector<consumer_protocol_topic_partitions> result;
+    result.reserve(partitions_by_topic.size());
+    for (auto& [topic, topic_partitions] : partitions_by_topic) {
+        consumer_protocol_topic_partitions entry;
+        entry.topic = topic;
+        entry.partitions = std::move(topic_partitions);
+        result.emplace_back(std::move(entry));
+    }
+    return result;
+}
+
+group_manager::group_manager(connection_manager& connection_manager, metadata_manager& metadata_manager,
+        consumer_properties& properties)
+        : _connection_manager(connection_manager),
+        _metadata_manager(metadata_manager),
+        _properties(properties),
+        _retry_helper(properties.retries, std::move(properties.retry_backoff_strategy)) {}
+
+future<> group_manager::ensure_coordinator() {
+    if (_coordinator) {
+        return make_ready_future<>();
+    }
+
+    std::vector<connection_id> brokers;
+    const auto& metadata = _metadata_manager.get_metadata();
+    if (!metadata.brokers.is_null()) {
+        for (const auto& broker : *metadata.brokers) {
+            brokers.emplace_back(*broker.host, *broker.port);
+        }
+    }
+
+    return do_with(std::move(brokers), size_t(0), [this] (std::vector<connection_id>& brokers, size_t& next_broker) {
+        return repeat([this, &brokers, &next_broker] {
+            if (_coordinator || next_broker >= brokers.size()) {
+                return make_ready_future<stop_iteration>(stop_iteration::yes);
+            }
+            auto& broker = brokers[next_broker++];
+
+            find_coordinator_request request;
+            request.key = _properties.group_id;
+            request.key_type = static_cast<int8_t>(coordinator_type::GROUP);
+
+            return _connection_manager.send(std::move(request), broker.first, broker.second, _properties.request_timeout)
+            .then([this] (find_coordinator_response response) {
+                if (response.error_code != error::kafka_error_code::NONE) {
+                    return stop_iteration::no;
+                }
+                _coordinator = _connection_manager.handle_of({*response.host, *response.port});
+                return stop_iteration::yes;
+            });
+        });
+    });
+}
+
+future<> group_manager::handle_group_error(const kafka_error_code_t& error_code) {
+    if (error_code == error::kafka_error_code::NOT_COORDINATOR
+            || error_code == error::kafka_error_code::COORDINATOR_NOT_AVAILABLE
+            || error_code == error::kafka_error_code::REQUEST_TIMED_OUT
+            || error_code == error::kafka_error_code::NETWORK_EXCEPTION) {
+        _coordinator.reset();
+        return make_ready_future<>();
+    }
+    if (error_code == error::kafka_error_code::REBALANCE_IN_PROGRESS
+            || error_code == error::kafka_error_code::COORDINATOR_LOAD_IN_PROGRESS) {
+        // Owned partitions are kept while rejoining, the assignment
+        // received afterwards tells which of them have to be revoked.
+        _rejoin_needed = true;
+        return make_ready_future<>();
+    }
+    if (error_code == error::kafka_error_code::UNKNOWN_MEMBER_ID
+            || error_code == error::kafka_error_code::ILLEGAL_GENERATION) {
+        if (error_code == error::kafka_error_code::UNKNOWN_MEMBER_ID) {
+            _member_id = "";
+        }
+        _generation_id = -1;
+        _rejoin_needed = true;
+        return lose_partitions();
+    }
+    return make_exception_future<>(group_exception(error_code->error_message));
+}
+
+sstring group_manager::serialize_subscription() const {
+    consumer_protocol_subscription subscription;
+
+    std::vector<kafka_string_t> topics;
+    topics.reserve(_subscription.size());
+    for (const auto& topic : _subscription) {
+        topics.emplace_back(topic);
+    }
+    subscription.topics = std::move(topics);
+    subscription.owned_partitions = group_by_topic({_assignment.begin(), _assignment.end()});
+
+    return serialize_to_bytes(subscription, consumer_protocol_subscription::MAX_SUPPORTED_VERSION);
+}
+
+future<do_retry> group_manager::rebalance_round() {
+    return ensure_coordinator().then([this] {
+        if (!_coordinator) {
+            return make_ready_future<do_retry>(do_retry::yes);
+        }
+
+        join_group_request request;
+        request.group_id = _properties.group_id;
+        request.session_timeout_ms = _properties.session_timeout;
+        request.rebalance_timeout_ms = _properties.rebalance_timeout;
+        request.member_id = _member_id;
+        if (_properties.group_instance_id) {
+            request.group_instance_id = *_properties.group_instance_id;
+        }
+        request.protocol_type = consumer_protocol_subscription::PROTOCOL_TYPE;
+
+        join_group_request_protocol protocol;
+        protocol.name = _properties.assignment_strategy->name();
+        protocol.metadata = serialize_subscription();
+        request.protocols = std::vector<join_group_request_protocol>{std::move(protocol)};
+
+        return _connection_manager.send(std::move(request), *_coordinator,
+                _properties.request_timeout).then([this] (join_group_response response) {
+            if (response.error_code == error::kafka_error_code::MEMBER_ID_REQUIRED) {
+                // The coordinator assigned us a member id, which has to be used to join.
+                _member_id = *response.member_id;
+                return make_ready_future<do_retry>(do_retry::yes);
+            }
+            if (response.error_code != error::kafka_error_code::NONE) {
+                return handle_group_error(response.error_code).then([] {
+                    return do_retry::yes;
+                });
+            }
+            _member_id = *response.member_id;
+            _generation_id = *response.generation_id;
+            return sync_group(std::move(response));
+        });
+    });
+}
+
+std::vector<sync_group_request_assignment> group_manager::perform_assignment(const join_group_response& response) {
+    std::map<partition_assignor::member_id, member_subscription> subscriptions;
+    for (const auto& member : *response.members) {
+        boost::iostreams::stream<boost::iostreams::array_source> metadata_stream
+                (member.metadata->data(), member.metadata->size());
+        consumer_protocol_subscription subscription;
+        subscription.deserialize(metadata_stream, consumer_protocol_subscription::MAX_SUPPORTED_VERSION);
+
+        auto& member_subscription = subscriptions[*member.member_id];
+        for (const auto& topic : *subscription.topics) {
+            member_subscription.topics.push_back(*topic);
+        }
+        for (const auto& owned : *subscription.owned_partitions) {
+            for (const auto& partition : *owned.partitions) {
+                member_subscription.owned_partitions.emplace_back(*owned.topic, *partition);
+            }
+        }
+    }
+
+    std::map<sstring, int32_t> partitions_per_topic;
+    const auto& metadata = _metadata_manager.get_metadata();
+    if (!metadata.topics.is_null()) {
+        for (const auto& topic : *metadata.topics) {
+            if (topic.error_code == error::kafka_error_code::NONE) {
+                partitions_per_topic[*topic.name] = topic.partitions->size();
+            }
+        }
+    }
+
+    auto assignment = _properties.assignment_strategy->assign(subscriptions, partitions_per_topic);
+
+    std::vector<sync_group_request_assignment> assignments;
+    assignments.reserve(assignment.size());
+    for (const auto& [member, partitions] : assignment) {
+        consumer_protocol_assignment member_assignment;
+        member_assignment.assigned_partitions = group_by_topic(partitions);
+
+        sync_group_request_assignment entry;
+        entry.member_id = member;
+        entry.assignment = serialize_to_bytes(member_assignment, consumer_protocol_assignment::MAX_SUPPORTED_VERSION);
+        assignments.emplace_back(std::move(entry));
+    }
+    return assignments;
+}
+
+future<do_retry> group_manager::sync_group(join_group_response response) {
+    auto coordinator = *_coordinator;
+    auto is_leader = *response.leader == _member_id;
+
+    sync_group_request request;
+    request.group_id = _properties.group_id;
+    request.generation_id = _generation_id;
+    request.member_id = _member_id;
+    if (_properties.group_instance_id) {
+        request.group_instance_id = *_properties.group_instance_id;
+    }
+
+    // Only the leader computes the assignment, using fresh metadata
+    // so that newly created partitions get assigned too.
+    auto assignments_future = is_leader
+            ? _metadata_manager.refresh_metadata().then([this, response = std::move(response)] {
+                return perform_assignment(response);
+            })
+            : make_ready_future<std::vector<sync_group_request_assignment>>();
+
+    return assignments_future.then([this, request = std::move(request), coordinator]
+            (std::vector<sync_group_request_assignment> assignments) mutable {
+        request.assignments = std::move(assignments);
+        return _connection_manager.send(std::move(request), coordinator,
+                _properties.request_timeout);
+    }).then([this] (sync_group_response response) {
+        if (response.error_code != error::kafka_error_code::NONE) {
+            return handle_group_error(response.error_code).then([] {
+                return do_retry::yes;
+            });
+        }
+
+        std::set<topic_partition> assigned;
+        if (!response.assignment->empty()) {
+            boost::iostreams::stream<boost::iostreams::array_source> assignment_stream
+                    (response.assignment->data(), response.assignment->size());
+            consumer_protocol_assignment assignment;
+            assignment.deserialize(assignment_stream, consumer_protocol_assignment::MAX_SUPPORTED_VERSION);
+            for (const auto& topic : *assignment.assigned_partitions) {
+                for (const auto& partition : *topic.partitions) {
+                    assigned.emplace(*topic.topic, *partition);
+                }
+            }
+        }
+
+        return update_assignment(std::move(assigned)).then([this] {
+            return _rejoin_needed ? do_retry::yes : do_retry::no;
+        });
+    });
+}
+
+future<> group_manager::update_assignment(std::set<topic_partition> assignment) {
+    std::vector<topic_partition> revoked;
+    std::vector<topic_partition> added;
+    std::set_difference(_assignment.begin(), _assignment.end(), assignment.begin(), assignment.end(),
+            std::back_inserter(revoked));
+    std::set_difference(assignment.begin(), assignment.end(), _assignment.begin(), _assignment.end(),
+            std::back_inserter(added));
+    _assignment = std::move(assignment);
+
+    // Revoked partitions are handed over to their new owners
+    // only in the follow-up rebalance, so rejoin right away.
+    _rejoin_needed = !revoked.empty();
+
+    return do_with(std::move(revoked), std::move(added),
+            [this] (std::vector<topic_partition>& revoked, std::vector<topic_partition>& added) {
+        auto revoke_future = revoked.empty()
+                ? make_ready_future<>()
+                : _properties.on_partitions_revoked(revoked);
+        return revoke_future.then([this, &added] {
+            return added.empty()
+                    ? make_ready_future<>()
+                    : _properties.on_partitions_assigned(added);
+        });
+    });
+}
+
+future<> group_manager::lose_partitions() {
+    if (_assignment.empty()) {
+        return make_ready_future<>();
+    }
+    std::vector<topic_partition> lost(_assignment.begin(), _assignment.end());
+    _assignment.clear();
+    return do_with(std::move(lost), [this] (std::vector<topic_partition>& lost) {
+        return _properties.on_partitions_lost(lost);
+    });
+}
+
+future<> group_manager::subscribe(std::vector<sstring> topics) {
+    std::sort(topics.begin(), topics.end());
+    topics.erase(std::unique(topics.begin(), topics.end()), topics.end());
+    _subscription = std::move(topics);
+    _rejoin_needed = true;
+    return ensure_active_group();
+}
+
+future<> group_manager::ensure_active_group() {
+    return with_semaphore(_rebalance_semaphore, 1, [this] {
+        if (!_rejoin_needed) {
+            return make_ready_future<>();
+        }
+        return _retry_helper.with_retry([this] {
+            return rebalance_round();
+        }).then([this] {
+            if (_rejoin_needed) {
+                return make_exception_future<>(group_exception("Couldn't join the consumer group"));
+            }
+            return make_ready_future<>();
+        });
+    });
+}
+
+future<> group_manager::heartbeat() {
+    if (_rejoin_needed) {
+        return ensure_active_group();
+    }
+    return ensure_coordinator().then([this] {
+        if (!_coordinator) {
+            return make_ready_future<>();
+        }
+
+        heartbeat_request request;
+        request.group_id = _properties.group_id;
+        request.generation_id = _generation_id;
+        request.member_id = _member_id;
+        if (_properties.group_instance_id) {
+            request.group_instance_id = *_properties.group_instance_id;
+        }
+
+        return _connection_manager.send(std::move(request), *_coordinator,
+                _properties.request_timeout).then([this] (heartbeat_response response) {
+            if (response.error_code == error::kafka_error_code::NONE) {
+                return make_ready_future<>();
+            }
+            return handle_group_error(response.error_code).then([this] {
+                return _rejoin_needed ? ensure_active_group() : make_ready_future<>();
+            });
+        });
+    });
+}
+
+future<> group_manager::heartbeat_coroutine(std::chrono::milliseconds dur) {
+    return seastar::do_until([this] { return !_keep_heartbeating; }, [this, dur] {
+        return seastar::sleep_abortable(dur, _stop_heartbeat).then([this] {
+            return heartbeat();
+        }).handle_exception([] (std::exception_ptr ep) {
+            // Failures are retried with the next heartbeat.
+            return make_ready_future<>();
+        });
+    }).finally([this] {
+        _heartbeat_finished.signal();
+    });
+}
+
+void group_manager::start_heartbeat() {
+    if (_keep_heartbeating) {
+        return;
+    }
+    _keep_heartbeating = true;
+    // The previous stop left the old one aborted, e.g. before a rejoin.
+    _stop_heartbeat = seastar::abort_source();
+    (void) heartbeat_coroutine(std::chrono::milliseconds(_properties.heartbeat_interval));
+}
+
+future<> group_manager::stop_heartbeat() {
+    if (!_keep_heartbeating) {
+        return make_ready_future<>();
+    }
+    _keep_heartbeating = false;
+    _stop_heartbeat.request_abort();
+    return _heartbeat_finished.wait(1);
+}
+
+future<> group_manager::leave() {
+    std::vector<topic_partition> revoked(_assignment.begin(), _assignment.end());
+    _assignment.clear();
+
+    return do_with(std::move(revoked), [this] (std::vector<topic_partition>& revoked) {
+        return revoked.empty() ? make_ready_future<>() : _properties.on_partitions_revoked(revoked);
+    }).then([this] {
+        // Static members don't leave the group, so that they can
+        // come back within session_timeout without a rebalance.
+        if (!_coordinator || _member_id.empty() || _properties.group_instance_id) {
+            return make_ready_future<>();
+        }
+
+        leave_group_request request;
+        request.group_id = _properties.group_id;
+        request.member_id = _member_id;
+        return _connection_manager.send(std::move(request), *_coordinator,
+                _properties.request_timeout).discard_result();
+    }).finally([this] {
+        _member_id = "";
+        _generation_id = -1;
+        _rejoin_needed = true;
+    });
+}
+
+const std::optional<connection_manager::broker_handle>& group_manager::coordinator() const {
+    return _coordinator;
+}
+
+void group_manager::reset_coordinator() {
+    _coordinator.reset();
+}
+
+const std::set<topic_partition>& group_manager::assignment() const {
+    return _assignment;
+}
+
+const sstring& group_manager::member_id() const {
+    return _member_id;
+}
+
+int32_t group_manager::generation_id() const {
+    return _generation_id;
+}
+
+}
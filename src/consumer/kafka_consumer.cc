@@ -0,0 +1,103 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (C) 2019 ScyllaDB Ltd.
+ */
+
+
+#include <seastar/core/future-util.hh>
+
+#include <kafka4seastar/consumer/kafka_consumer.hh>
+
+using namespace seastar;
+
+namespace kafka4seastar {
+
+kafka_consumer::kafka_consumer(consumer_properties&& properties)
+    : _properties(std::move(properties)),
+      _connection_manager(_properties.client_id, _properties.connection),
+      _metadata_manager(_connection_manager, _properties.metadata_refresh),
+      _group_manager(_connection_manager, _metadata_manager, _properties),
+      _offset_manager(_connection_manager, _group_manager, _properties),
+      _fetcher(_connection_manager, _metadata_manager, _offset_manager, _properties) {}
+
+seastar::future<> kafka_consumer::init() {
+    return _connection_manager.init(_properties.servers, _properties.request_timeout).then([this] {
+        _metadata_manager.start_refresh();
+        return _metadata_manager.refresh_metadata();
+    });
+}
+
+seastar::future<> kafka_consumer::subscribe(std::vector<seastar::sstring> topics) {
+    _metadata_manager.set_topics_of_interest({topics.begin(), topics.end()});
+    return _group_manager.subscribe(std::move(topics)).then([this] {
+        _group_manager.start_heartbeat();
+        _offset_manager.start_flush();
+    });
+}
+
+const std::set<topic_partition>& kafka_consumer::assignment() const {
+    return _group_manager.assignment();
+}
+
+seastar::future<std::vector<fetched_partition>> kafka_consumer::poll(std::chrono::milliseconds timeout) {
+    _fetcher.assign(_group_manager.assignment());
+    return _fetcher.poll(timeout);
+}
+
+void kafka_consumer::pause(const topic_partition& partition) {
+    _fetcher.pause(partition);
+}
+
+void kafka_consumer::resume(const topic_partition& partition) {
+    _fetcher.resume(partition);
+}
+
+seastar::future<> kafka_consumer::commit(const topic_partition& partition, int64_t offset) {
+    return _offset_manager.commit(partition, offset);
+}
+
+seastar::future<> kafka_consumer::commit() {
+    std::vector<future<>> commits;
+    for (const auto& partition : _group_manager.assignment()) {
+        auto position = _fetcher.position(partition);
+        if (position) {
+            commits.emplace_back(_offset_manager.commit(partition, *position));
+        }
+    }
+    return when_all_succeed(commits.begin(), commits.end());
+}
+
+seastar::future<> kafka_consumer::close() {
+    return _fetcher.stop().then([this] {
+        // Commits have to reach the coordinator before leaving
+        // the group, as afterwards they would be rejected.
+        return _offset_manager.stop_flush();
+    }).then([this] {
+        return _group_manager.stop_heartbeat();
+    }).then([this] {
+        return _group_manager.leave();
+    }).then([this] {
+        return _metadata_manager.stop_refresh();
+    }).then([this] {
+        return _connection_manager.disconnect_all();
+    });
+}
+
+}
@@ -0,0 +1,259 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (C) 2019 ScyllaDB Ltd.
+ */
+
+
+#include <seastar/core/sleep.hh>
+
+#include <kafka4seastar/consumer/offset_manager.hh>
+#include <kafka4seastar/protocol/offset_commit_request.hh>
+#include <kafka4seastar/protocol/offset_fetch_request.hh>
+
+using namespace seastar;
+
+namespace kafka4seastar {
+
+offset_manager::offset_manager(connection_manager& connection_manager, group_manager& group_manager,
+        consumer_properties& properties)
+        : _connection_manager(connection_manager),
+        _group_manager(group_manager),
+        _properties(properties) {}
+
+future<> offset_manager::commit(const topic_partition& partition, int64_t offset) {
+    auto& pending = _pending[partition];
+    pending.offset = offset;
+    pending.attempts = 0;
+    pending.waiters.emplace_back();
+    auto commit_future = pending.waiters.back().get_future();
+
+    if (_properties.commit_window == 0) {
+        (void) flush();
+    }
+    return commit_future;
+}
+
+void offset_manager::commit_failed(const topic_partition& partition, pending_commit&& commit,
+        const kafka_error_code_t& error_code) {
+    if (error_code == error::kafka_error_code::NOT_COORDINATOR
+            || error_code == error::kafka_error_code::COORDINATOR_NOT_AVAILABLE
+            || error_code == error::kafka_error_code::REQUEST_TIMED_OUT
+            || error_code == error::kafka_error_code::NETWORK_EXCEPTION) {
+        _group_manager.reset_coordinator();
+    }
+
+    auto newer = _pending.find(partition);
+    if (newer != _pending.end()) {
+        // Superseded by a later commit, which acknowledges this one too.
+        for (auto& waiter : commit.waiters) {
+            newer->second.waiters.emplace_back(std::move(waiter));
+        }
+        return;
+    }
+
+    if (!error_code.retriable() || ++commit.attempts >= _properties.retries) {
+        for (auto& waiter : commit.waiters) {
+            waiter.set_exception(commit_exception(error_code->error_message));
+        }
+        return;
+    }
+    _pending.emplace(partition, std::move(commit));
+}
+
+future<> offset_manager::send_commits(commits& to_send) {
+    return _group_manager.ensure_coordinator().then([this, &to_send] {
+        const auto& coordinator = _group_manager.coordinator();
+        if (!coordinator) {
+            for (auto& [partition, commit] : to_send) {
+                commit_failed(partition, std::move(commit), error::kafka_error_code::COORDINATOR_NOT_AVAILABLE);
+            }
+            return make_ready_future<>();
+        }
+
+        offset_commit_request request;
+        request.group_id = _properties.group_id;
+        request.generation_id = _group_manager.generation_id();
+        request.member_id = _group_manager.member_id();
+        if (_properties.group_instance_id) {
+            request.group_instance_id = *_properties.group_instance_id;
+        }
+        request.retention_time_ms = -1;
+
+        std::map<sstring, std::vector<offset_commit_request_partition>> partitions_by_topic;
+        for (const auto& [partition, commit] : to_send) {
+            offset_commit_request_partition request_partition;
+            request_partition.partition_index = partition.second;
+            request_partition.committed_offset = commit.offset;
+            request_partition.committed_leader_epoch = -1;
+            partitions_by_topic[partition.first].emplace_back(std::move(request_partition));
+        }
+        std::vector<offset_commit_request_topic> topics;
+        for (auto& [name, partitions] : partitions_by_topic) {
+            offset_commit_request_topic topic;
+            topic.name = name;
+            topic.partitions = std::move(partitions);
+            topics.emplace_back(std::move(topic));
+        }
+        request.topics = std::move(topics);
+
+        return _connection_manager.send(std::move(request), *coordinator,
+                _properties.request_timeout).then([this, &to_send] (offset_commit_response response) {
+            if (response.error_code == error::kafka_error_code::NONE) {
+                for (const auto& topic : *response.topics) {
+                    for (const auto& partition : *topic.partitions) {
+                        auto commit = to_send.find({*topic.name, *partition.partition_index});
+                        if (commit == to_send.end()) {
+                            continue;
+                        }
+                        if (partition.error_code == error::kafka_error_code::NONE) {
+                            for (auto& waiter : commit->second.waiters) {
+                                waiter.set_value();
+                            }
+                        } else {
+                            commit_failed(commit->first, std::move(commit->second), partition.error_code);
+                        }
+                        to_send.erase(commit);
+                    }
+                }
+            }
+
+            // Partitions missing from the response, or all of them if it wasn't received.
+            kafka_error_code_t missing_error = response.error_code == error::kafka_error_code::NONE
+                    ? error::kafka_error_code::UNKNOWN_SERVER_ERROR
+                    : *response.error_code;
+            for (auto& [partition, commit] : to_send) {
+                commit_failed(partition, std::move(commit), missing_error);
+            }
+        });
+    });
+}
+
+future<> offset_manager::flush() {
+    return with_semaphore(_commit_semaphore, 1, [this] {
+        // Taken only after the previous request completed,
+        // so that it includes every commit made meanwhile.
+        if (_pending.empty()) {
+            return make_ready_future<>();
+        }
+        return do_with(std::exchange(_pending, {}), [this] (commits& to_send) {
+            return send_commits(to_send).handle_exception([this, &to_send] (std::exception_ptr ep) {
+                for (auto& [partition, commit] : to_send) {
+                    commit_failed(partition, std::move(commit), error::kafka_error_code::UNKNOWN_SERVER_ERROR);
+                }
+            });
+        });
+    });
+}
+
+future<std::map<topic_partition, int64_t>> offset_manager::fetch_committed(
+        const std::vector<topic_partition>& partitions) {
+    return _group_manager.ensure_coordinator().then([this, partitions] {
+        const auto& coordinator = _group_manager.coordinator();
+        if (!coordinator) {
+            return make_exception_future<std::map<topic_partition, int64_t>>(
+                    commit_exception("Group coordinator is not available"));
+        }
+
+        std::map<sstring, std::vector<kafka_int32_t>> partitions_by_topic;
+        for (const auto& [topic, partition] : partitions) {
+            partitions_by_topic[topic].emplace_back(partition);
+        }
+
+        offset_fetch_request request;
+        request.group_id = _properties.group_id;
+        std::vector<offset_fetch_request_topic> topics;
+        for (auto& [name, topic_partitions] : partitions_by_topic) {
+            offset_fetch_request_topic topic;
+            topic.name = name;
+            topic.partition_indexes = std::move(topic_partitions);
+            topics.emplace_back(std::move(topic));
+        }
+        request.topics = std::move(topics);
+
+        return _connection_manager.send(std::move(request), *coordinator,
+                _properties.request_timeout).then([this] (offset_fetch_response response) {
+            if (response.error_code != error::kafka_error_code::NONE) {
+                if (response.error_code.retriable()) {
+                    _group_manager.reset_coordinator();
+                }
+                return make_exception_future<std::map<topic_partition, int64_t>>(
+                        commit_exception(response.error_code->error_message));
+            }
+
+            std::map<topic_partition, int64_t> committed;
+            for (const auto& topic : *response.topics) {
+                for (const auto& partition : *topic.partitions) {
+                    // Offset -1 means that nothing was committed yet.
+                    if (partition.error_code == error::kafka_error_code::NONE && *partition.committed_offset >= 0) {
+                        committed.emplace(topic_partition(*topic.name, *partition.partition_index),
+                                *partition.committed_offset);
+                    }
+                }
+            }
+            return make_ready_future<std::map<topic_partition, int64_t>>(std::move(committed));
+        });
+    });
+}
+
+future<> offset_manager::flush_coroutine(std::chrono::milliseconds dur) {
+    return seastar::do_until([this] { return !_keep_flushing; }, [this, dur] {
+        return seastar::sleep_abortable(dur, _stop_flush).then([this] {
+            return flush();
+        }).handle_exception([] (std::exception_ptr ep) {
+            // Failed commits are reported to their waiters.
+            return make_ready_future();
+        });
+    }).finally([this] {
+        _flush_finished.signal();
+    });
+}
+
+void offset_manager::start_flush() {
+    if (_keep_flushing) {
+        return;
+    }
+    _keep_flushing = true;
+    // The previous stop left the old one aborted.
+    _stop_flush = seastar::abort_source();
+    // Without a window commits are sent right away,
+    // and only the retries are left to the coroutine.
+    auto interval = _properties.commit_window > 0 ? _properties.commit_window : _properties.retry_backoff;
+    (void) flush_coroutine(std::chrono::milliseconds(interval));
+}
+
+future<> offset_manager::stop_flush() {
+    if (!_keep_flushing) {
+        return flush();
+    }
+    _keep_flushing = false;
+    _stop_flush.request_abort();
+    return _flush_finished.wait(1).then([this] {
+        return flush();
+    }).then([this] {
+        // Retries left after the last attempt won't be sent anymore.
+        for (auto& [partition, commit] : std::exchange(_pending, {})) {
+            for (auto& waiter : commit.waiters) {
+                waiter.set_exception(commit_exception("Offset manager was stopped before the commit succeeded"));
+            }
+        }
+    });
+}
+
+}
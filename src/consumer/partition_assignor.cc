@@ -0,0 +1,122 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (C) 2019 ScyllaDB Ltd.
+ */
+
+
+#include <kafka4seastar/consumer/partition_assignor.hh>
+
+#include <algorithm>
+#include <set>
+
+using namespace seastar;
+
+namespace kafka4seastar {
+
+sstring cooperative_sticky_assignor::name() const {
+    return "cooperative-sticky";
+}
+
+partition_assignor::assignment cooperative_sticky_assignor::assign(
+        const std::map<member_id, member_subscription>& subscriptions,
+        const std::map<sstring, int32_t>& partitions_per_topic) {
+    std::map<member_id, std::set<topic_partition>> current;
+    std::map<sstring, std::vector<member_id>> members_per_topic;
+    std::set<topic_partition> all_partitions;
+
+    for (const auto& [member, subscription] : subscriptions) {
+        current[member];
+        for (const auto& topic : subscription.topics) {
+            auto partition_count = partitions_per_topic.find(topic);
+            if (partition_count == partitions_per_topic.end()) {
+                continue;
+            }
+            members_per_topic[topic].push_back(member);
+            for (int32_t partition = 0; partition < partition_count->second; partition++) {
+                all_partitions.emplace(topic, partition);
+            }
+        }
+    }
+
+    // Keep the partitions with the members which owned them, as long as they
+    // still exist and are subscribed to. If two members claim the same partition
+    // (one of them is lagging behind with a stale generation) only the first keeps it.
+    std::map<topic_partition, member_id> previous_owner;
+    for (const auto& [member, subscription] : subscriptions) {
+        std::set<sstring> subscribed(subscription.topics.begin(), subscription.topics.end());
+        for (const auto& partition : subscription.owned_partitions) {
+            if (!all_partitions.count(partition) || !subscribed.count(partition.first)
+                    || previous_owner.count(partition)) {
+                continue;
+            }
+            previous_owner.emplace(partition, member);
+            current[member].insert(partition);
+        }
+    }
+
+    // Take the excess partitions away from members above their quota.
+    if (!current.empty()) {
+        auto min_quota = all_partitions.size() / current.size();
+        auto members_with_extra_partition = all_partitions.size() % current.size();
+        for (auto& [member, partitions] : current) {
+            auto quota = min_quota;
+            if (partitions.size() > min_quota && members_with_extra_partition > 0) {
+                quota++;
+                members_with_extra_partition--;
+            }
+            while (partitions.size() > quota) {
+                partitions.erase(std::prev(partitions.end()));
+            }
+        }
+    }
+
+    std::set<topic_partition> unassigned = all_partitions;
+    for (const auto& [member, partitions] : current) {
+        for (const auto& partition : partitions) {
+            unassigned.erase(partition);
+        }
+    }
+
+    for (const auto& partition : unassigned) {
+        const auto& candidates = members_per_topic[partition.first];
+        auto least_loaded = std::min_element(candidates.begin(), candidates.end(),
+                [&current] (const member_id& a, const member_id& b) {
+            return current[a].size() < current[b].size();
+        });
+        current[*least_loaded].insert(partition);
+    }
+
+    assignment result;
+    for (auto& [member, partitions] : current) {
+        auto& member_assignment = result[member];
+        for (const auto& partition : partitions) {
+            auto owner = previous_owner.find(partition);
+            if (owner != previous_owner.end() && owner->second != member) {
+                // Still owned by another member, which has to revoke it first.
+                continue;
+            }
+            member_assignment.push_back(partition);
+        }
+    }
+
+    return result;
+}
+
+}
@@ -68,11 +68,8 @@ future<> batcher::flush_coroutine(std::chrono::milliseconds dur) {
         return seastar::sleep_abortable(dur, _stop_refresh).then([this] {
             return flush();
         }).handle_exception([] (std::exception_ptr ep) {
-            try {
-                std::rethrow_exception(ep);
-            } catch (...) {
-                return make_ready_future();
-            }
+            // Failed messages are reported to their producers, keep flushing.
+            return make_ready_future();
         });
     }).finally([this]{
         _refresh_finished.signal();
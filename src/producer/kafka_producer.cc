@@ -20,6 +20,7 @@
  * Copyright (C) 2019 ScyllaDB Ltd.
  */
 
+#include <algorithm>
 #include <sstream>
 #include <vector>
 #include <iostream>
@@ -48,11 +49,15 @@ namespace kafka4seastar {
 
 kafka_producer::kafka_producer(producer_properties&& properties)
     : _properties(std::move(properties)),
-      _connection_manager(_properties.client_id),
+      _connection_manager(_properties.client_id, _properties.connection),
       _metadata_manager(_connection_manager, _properties.metadata_refresh),
       _batcher(_metadata_manager, _connection_manager, _properties.retries,
               _properties.acks, _properties.request_timeout, _properties.linger,
-              _properties.buffer_memory, std::move(_properties.retry_backoff_strategy)) {}
+              _properties.buffer_memory, std::move(_properties.retry_backoff_strategy)) {
+    if (!_properties.partitioning_strategy) {
+        _properties.partitioning_strategy = defaults::sticky_partitioner(_properties.batch_size);
+    }
+}
 
 seastar::future<> kafka_producer::init() {
     return _connection_manager.init(_properties.servers, _properties.request_timeout).then([this] {
@@ -63,6 +68,19 @@ seastar::future<> kafka_producer::init() {
     });
 }
 
+partition_state kafka_producer::partition_state_of(const metadata_response_partition& partition) const {
+    partition_state state;
+    state.leader_id = *partition.leader_id;
+    auto broker = _metadata_manager.broker_handle_for(state.leader_id);
+    if (broker == connection_manager::NO_BROKER) {
+        return state;
+    }
+    state.available = partition.error_code == error::kafka_error_code::NONE && _connection_manager.is_healthy(broker);
+    state.queue_depth = _connection_manager.outstanding_bytes(broker);
+    state.latency_ms = _connection_manager.latency_ms(broker);
+    return state;
+}
+
 seastar::future<> kafka_producer::produce(seastar::sstring topic_name,
                                           seastar::sstring key, seastar::sstring value) {
     return produce(std::move(topic_name), std::optional(std::move(key)), std::optional(std::move(value)));
@@ -74,8 +92,14 @@ seastar::future<> kafka_producer::produce(seastar::sstring topic_name,
     auto partition_index = 0;
     for (const auto& topic : *metadata.topics) {
         if (*topic.name == topic_name) {
-            partition_index = *_properties.partitioning_strategy->get_partition(
-                    key.value_or(""), topic.partitions).partition_index;
+            // The partitioner keeps the records without a key away
+            // from the partitions which are not available.
+            partitioner_context context{topic_name, (key ? key->size() : 0) + (value ? value->size() : 0),
+                    [this] (const metadata_response_partition& partition) { return partition_state_of(partition); }};
+            auto key_view = key ? std::optional<std::string_view>(*key) : std::nullopt;
+            const auto& partition = _properties.partitioning_strategy->get_partition(context,
+                    key_view, topic.partitions);
+            partition_index = *partition.partition_index;
             break;
         }
     }
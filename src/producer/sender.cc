@@ -38,7 +38,7 @@ sender::sender(connection_manager& connection_manager,
             _connection_timeout(connection_timeout),
             _acks(acks) {}
 
-std::optional<sender::connection_id> sender::broker_for_topic_partition(const seastar::sstring& topic, int32_t partition_index) {
+connection_manager::broker_handle sender::broker_for_topic_partition(const seastar::sstring& topic, int32_t partition_index) {
     const auto& metadata = _metadata_manager.get_metadata();
 
     auto topic_candidate = std::lower_bound(metadata.topics->begin(), metadata.topics->end(), topic, [](auto& a, auto& b) {
@@ -51,24 +51,11 @@ std::optional<sender::connection_id> sender::broker_for_topic_partition(const se
         });
 
         if (it != topic_candidate->partitions->end() && *it->partition_index == partition_index && it->error_code == error::kafka_error_code::NONE) {
-            return broker_for_id(*it->leader_id);
+            return _metadata_manager.broker_handle_for(*it->leader_id);
         }
     }
 
-    return std::nullopt;
-}
-
-sender::connection_id sender::broker_for_id(int32_t id) {
-    const auto& metadata = _metadata_manager.get_metadata();
-    auto it = std::lower_bound(metadata.brokers->begin(), metadata.brokers->end(), id, [] (auto& a, auto& b) {
-        return *a.node_id < b;
-    });
-
-    if (*it->node_id == id) {
-        return {*it->host, *it->port};
-    }
-
-    return {};
+    return connection_manager::NO_BROKER;
 }
 
 void sender::split_messages() {
@@ -77,8 +64,10 @@ void sender::split_messages() {
 
     for (auto& message : _messages) {
         auto broker = broker_for_topic_partition(message.topic, message.partition_index);
-        if (broker) {
-            _messages_split_by_broker_topic_partition[*broker][message.topic][message.partition_index].push_back(&message);
+        if (broker != connection_manager::NO_BROKER) {
+            // Messages of a partition always go through the same connection, so that they stay ordered.
+            auto lane = _connection_manager.lane_for(broker, {message.topic, message.partition_index});
+            _messages_split_by_broker_topic_partition[{broker, lane}][message.topic][message.partition_index].push_back(&message);
             _messages_split_by_topic_partition[{message.topic, message.partition_index}].push_back(&message);
         } else {
             // TODO: Differentiate between unknown topic, leader not available etc.
@@ -91,7 +80,7 @@ void sender::queue_requests() {
     _responses.clear();
     _responses.reserve(_messages_split_by_broker_topic_partition.size());
 
-    for (auto& [broker, messages_by_topic_partition] : _messages_split_by_broker_topic_partition) {
+    for (auto& [destination, messages_by_topic_partition] : _messages_split_by_broker_topic_partition) {
         produce_request req;
         req.acks = static_cast<int16_t>(_acks);
         req.timeout_ms = _connection_timeout;
@@ -149,14 +138,15 @@ void sender::queue_requests() {
         }
 
         auto with_response = _acks != ack_policy::NONE;
-        _responses.emplace_back(_connection_manager.send(std::move(req), broker.first, broker.second, _connection_timeout, with_response)
-            .then([broker] (auto response) {
-                return std::make_pair(broker, response);
+        _responses.emplace_back(_connection_manager.send(std::move(req), destination.first, _connection_timeout,
+                with_response, destination.second)
+            .then([destination = destination] (auto response) {
+                return std::make_pair(destination, response);
         }));
     }
 }
 
-void sender::set_error_code_for_broker(const sender::connection_id& broker, const error::kafka_error_code& error_code) {
+void sender::set_error_code_for_broker(const sender::destination& broker, const error::kafka_error_code& error_code) {
     for (auto& [topic, messages_by_partition] : _messages_split_by_broker_topic_partition[broker]) {
         for (auto& [partition, messages] : messages_by_partition) {
             for (auto& message : messages) {
@@ -167,7 +157,7 @@ void sender::set_error_code_for_broker(const sender::connection_id& broker, cons
     }
 }
 
-void sender::set_success_for_broker(const sender::connection_id& broker) {
+void sender::set_success_for_broker(const sender::destination& broker) {
     for (auto& [topic, messages_by_partition] : _messages_split_by_broker_topic_partition[broker]) {
         for (auto& [partition, messages] : messages_by_partition) {
             for (auto& message : messages) {
@@ -215,7 +205,7 @@ void sender::send_requests() {
 
 future<> sender::receive_responses() {
     return when_all(_responses.begin(), _responses.end()).then(
-            [this](std::vector<future<std::pair<connection_id, produce_response>>> responses) {
+            [this](std::vector<future<std::pair<destination, produce_response>>> responses) {
         set_error_codes_for_responses(responses);
         filter_messages();
         return process_messages_errors();
@@ -224,7 +214,7 @@ future<> sender::receive_responses() {
 
 future<> sender::process_messages_errors() {
     for (auto& message : _messages) {
-        if (message.error_code->invalidates_metadata) {
+        if (message.error_code.invalidates_metadata()) {
             return _metadata_manager.refresh_metadata();
         }
     }
@@ -237,7 +227,7 @@ void sender::filter_messages() {
         if (message.error_code == error::kafka_error_code::NONE) {
             return true;
         }
-        if (!message.error_code->retriable) {
+        if (!message.error_code.retriable()) {
             message.promise.set_exception(send_exception(message.error_code->error_message));
             return true;
         }
@@ -245,7 +235,7 @@ void sender::filter_messages() {
     }), _messages.end());
 }
 
-void sender::set_error_codes_for_responses(std::vector<future<std::pair<connection_id, produce_response>>>& responses) {
+void sender::set_error_codes_for_responses(std::vector<future<std::pair<destination, produce_response>>>& responses) {
     for (auto& response : responses) {
         auto [broker, response_message] = response.get0();
         if (response_message.error_code != error::kafka_error_code::NONE) {
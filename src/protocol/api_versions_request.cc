@@ -22,6 +22,18 @@
 
 #include <kafka4seastar/protocol/api_versions_request.hh>
 
-void kafka4seastar::api_versions_request::serialize(std::ostream& os, int16_t api_version) const {}
+void kafka4seastar::api_versions_request::serialize(std::ostream& os, int16_t api_version) const {
+    if (api_version >= FIRST_FLEXIBLE_VERSION) {
+        client_software_name.serialize(os, api_version, true);
+        client_software_version.serialize(os, api_version, true);
+        tagged_fields.serialize(os, api_version);
+    }
+}
 
-void kafka4seastar::api_versions_request::deserialize(std::istream& is, int16_t api_version) {}
+void kafka4seastar::api_versions_request::deserialize(std::istream& is, int16_t api_version) {
+    if (api_version >= FIRST_FLEXIBLE_VERSION) {
+        client_software_name.deserialize(is, api_version, true);
+        client_software_version.deserialize(is, api_version, true);
+        tagged_fields.deserialize(is, api_version);
+    }
+}
@@ -32,12 +32,18 @@ void api_versions_response_key::serialize(std::ostream& os, int16_t api_version)
     api_key.serialize(os, api_version);
     min_version.serialize(os, api_version);
     max_version.serialize(os, api_version);
+    if (api_version >= api_versions_response::FIRST_FLEXIBLE_VERSION) {
+        tagged_fields.serialize(os, api_version);
+    }
 }
 
 void api_versions_response_key::deserialize(std::istream& is, int16_t api_version) {
     api_key.deserialize(is, api_version);
     min_version.deserialize(is, api_version);
     max_version.deserialize(is, api_version);
+    if (api_version >= api_versions_response::FIRST_FLEXIBLE_VERSION) {
+        tagged_fields.deserialize(is, api_version);
+    }
 }
 
 bool api_versions_response_key::operator<(const api_versions_response_key& other) const noexcept {
@@ -64,20 +70,35 @@ bool api_versions_response::contains(int16_t api_key) const {
 }
 
 void api_versions_response::serialize(std::ostream& os, int16_t api_version) const {
+    auto flexible = api_version >= FIRST_FLEXIBLE_VERSION;
     error_code.serialize(os, api_version);
-    api_keys.serialize(os, api_version);
+    api_keys.serialize(os, api_version, flexible);
     if (api_version >= 1) {
         throttle_time_ms.serialize(os, api_version);
     }
+    if (flexible) {
+        tagged_fields.serialize(os, api_version);
+    }
 }
 
 void api_versions_response::deserialize(std::istream& is, int16_t api_version) {
     error_code.deserialize(is, api_version);
-    api_keys.deserialize(is, api_version);
-    std::sort(api_keys->begin(), api_keys->end());
+    if (error_code == error::kafka_error_code::UNSUPPORTED_VERSION) {
+        // Brokers answer versions they don't support in version 0,
+        // with the versions of ApiVersions they do support.
+        api_version = 0;
+    }
+    auto flexible = api_version >= FIRST_FLEXIBLE_VERSION;
+    api_keys.deserialize(is, api_version, flexible);
+    if (!api_keys.is_null()) {
+        std::sort(api_keys->begin(), api_keys->end());
+    }
     if (api_version >= 1) {
         throttle_time_ms.deserialize(is, api_version);
     }
+    if (flexible) {
+        tagged_fields.deserialize(is, api_version);
+    }
 }
 
 }
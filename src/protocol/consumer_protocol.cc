@@ -0,0 +1,80 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (C) 2019 ScyllaDB Ltd.
+ */
+
+
+#include <kafka4seastar/protocol/consumer_protocol.hh>
+
+using namespace seastar;
+
+namespace kafka4seastar {
+
+void consumer_protocol_topic_partitions::serialize(std::ostream& os, int16_t api_version) const {
+    topic.serialize(os, api_version);
+    partitions.serialize(os, api_version);
+}
+
+void consumer_protocol_topic_partitions::deserialize(std::istream& is, int16_t api_version) {
+    topic.deserialize(is, api_version);
+    partitions.deserialize(is, api_version);
+}
+
+void consumer_protocol_subscription::serialize(std::ostream& os, int16_t api_version) const {
+    kafka_int16_t written_version(api_version);
+    written_version.serialize(os, api_version);
+    topics.serialize(os, api_version);
+    user_data.serialize(os, api_version);
+    if (api_version >= 1) {
+        owned_partitions.serialize(os, api_version);
+    }
+}
+
+void consumer_protocol_subscription::deserialize(std::istream& is, int16_t api_version) {
+    version.deserialize(is, api_version);
+    if (*version < 0) {
+        throw parsing_exception("Consumer subscription version is invalid");
+    }
+    topics.deserialize(is, *version);
+    user_data.deserialize(is, *version);
+    if (*version >= 1) {
+        owned_partitions.deserialize(is, *version);
+    } else {
+        owned_partitions = std::vector<consumer_protocol_topic_partitions>();
+    }
+}
+
+void consumer_protocol_assignment::serialize(std::ostream& os, int16_t api_version) const {
+    kafka_int16_t written_version(api_version);
+    written_version.serialize(os, api_version);
+    assigned_partitions.serialize(os, api_version);
+    user_data.serialize(os, api_version);
+}
+
+void consumer_protocol_assignment::deserialize(std::istream& is, int16_t api_version) {
+    version.deserialize(is, api_version);
+    if (*version < 0) {
+        throw parsing_exception("Consumer assignment version is invalid");
+    }
+    assigned_partitions.deserialize(is, *version);
+    user_data.deserialize(is, *version);
+}
+
+}
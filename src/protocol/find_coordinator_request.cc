@@ -0,0 +1,44 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (C) 2019 ScyllaDB Ltd.
+ */
+
+
+#include <kafka4seastar/protocol/find_coordinator_request.hh>
+
+using namespace seastar;
+
+namespace kafka4seastar {
+
+void find_coordinator_request::serialize(std::ostream& os, int16_t api_version) const {
+    key.serialize(os, api_version);
+    if (api_version >= 1) {
+        key_type.serialize(os, api_version);
+    }
+}
+
+void find_coordinator_request::deserialize(std::istream& is, int16_t api_version) {
+    key.deserialize(is, api_version);
+    if (api_version >= 1) {
+        key_type.deserialize(is, api_version);
+    }
+}
+
+}
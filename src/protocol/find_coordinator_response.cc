@@ -0,0 +1,56 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (C) 2019 ScyllaDB Ltd.
+ */
+
+
+#include <kafka4seastar/protocol/find_coordinator_response.hh>
+
+using namespace seastar;
+
+namespace kafka4seastar {
+
+void find_coordinator_response::serialize(std::ostream& os, int16_t api_version) const {
+    if (api_version >= 1) {
+        throttle_time_ms.serialize(os, api_version);
+    }
+    error_code.serialize(os, api_version);
+    if (api_version >= 1) {
+        error_message.serialize(os, api_version);
+    }
+    node_id.serialize(os, api_version);
+    host.serialize(os, api_version);
+    port.serialize(os, api_version);
+}
+
+void find_coordinator_response::deserialize(std::istream& is, int16_t api_version) {
+    if (api_version >= 1) {
+        throttle_time_ms.deserialize(is, api_version);
+    }
+    error_code.deserialize(is, api_version);
+    if (api_version >= 1) {
+        error_message.deserialize(is, api_version);
+    }
+    node_id.deserialize(is, api_version);
+    host.deserialize(is, api_version);
+    port.deserialize(is, api_version);
+}
+
+}
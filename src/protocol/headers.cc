@@ -26,26 +26,38 @@ using namespace seastar;
 
 namespace kafka4seastar {
 
-void request_header::serialize(std::ostream& os, int16_t api_version) const {
-    api_key.serialize(os, api_version);
-    this->api_version.serialize(os, api_version);
-    correlation_id.serialize(os, api_version);
-    client_id.serialize(os, api_version);
+void request_header::serialize(std::ostream& os, int16_t header_version) const {
+    api_key.serialize(os, header_version);
+    api_version.serialize(os, header_version);
+    correlation_id.serialize(os, header_version);
+    client_id.serialize(os, header_version);
+    if (header_version >= 2) {
+        tagged_fields.serialize(os, header_version);
+    }
 }
 
-void request_header::deserialize(std::istream& is, int16_t api_version) {
-    api_key.deserialize(is, api_version);
-    this->api_version.deserialize(is, api_version);
-    correlation_id.deserialize(is, api_version);
-    client_id.deserialize(is, api_version);
+void request_header::deserialize(std::istream& is, int16_t header_version) {
+    api_key.deserialize(is, header_version);
+    api_version.deserialize(is, header_version);
+    correlation_id.deserialize(is, header_version);
+    client_id.deserialize(is, header_version);
+    if (header_version >= 2) {
+        tagged_fields.deserialize(is, header_version);
+    }
 }
 
-void response_header::serialize(std::ostream& os, int16_t api_version) const {
-    correlation_id.serialize(os, api_version);
+void response_header::serialize(std::ostream& os, int16_t header_version) const {
+    correlation_id.serialize(os, header_version);
+    if (header_version >= 1) {
+        tagged_fields.serialize(os, header_version);
+    }
 }
 
-void response_header::deserialize(std::istream& is, int16_t api_version) {
-    correlation_id.deserialize(is, api_version);
+void response_header::deserialize(std::istream& is, int16_t header_version) {
+    correlation_id.deserialize(is, header_version);
+    if (header_version >= 1) {
+        tagged_fields.deserialize(is, header_version);
+    }
 }
 
 }
@@ -20,7 +20,7 @@
  * Copyright (C) 2019 ScyllaDB Ltd.
  */
 
-#include <unordered_map>
+#include <array>
 #include <kafka4seastar/protocol/kafka_error_code.hh>
 
 using namespace seastar;
@@ -29,372 +29,260 @@ namespace kafka4seastar {
 
 namespace error {
 
-static std::unordered_map<int16_t, const kafka_error_code&> errors;
+// Constant initialized, so it is filled in by the constructors below
+// regardless of the order the static objects are initialized in.
+static std::array<const kafka_error_code*, ERROR_CODE_COUNT> errors;
 
 kafka_error_code::kafka_error_code (
     int16_t error_code,
-    seastar::sstring error_message,
-    is_retriable retriable,
-    should_invalidate_metadata invalidates_metadata)
+    seastar::sstring error_message)
     : error_code(error_code),
     error_message(error_message),
-    retriable(retriable),
-    invalidates_metadata(invalidates_metadata) {
-    errors.insert(std::pair<int16_t, const kafka_error_code&>(error_code, *this));
+    retriable(traits_of(error_code).retriable),
+    invalidates_metadata(traits_of(error_code).invalidates_metadata) {
+    errors[error_code - MIN_ERROR_CODE] = this;
 }
 
-const kafka_error_code& kafka_error_code::get_error(int16_t value) {
-    return errors.at(value);
+const kafka_error_code& kafka_error_code::get_error(int16_t value) noexcept {
+    return is_known_error(value) ? *errors[value - MIN_ERROR_CODE] : UNKNOWN_SERVER_ERROR;
 }
 
 const kafka_error_code kafka_error_code::kafka_error_code::UNKNOWN_SERVER_ERROR(
     -1,
-    "The server experienced an unexpected error when processing the request.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "The server experienced an unexpected error when processing the request."
 );
 const kafka_error_code kafka_error_code::kafka_error_code::NONE(
     0,
-    "",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    ""
 );
 const kafka_error_code kafka_error_code::OFFSET_OUT_OF_RANGE (
     1,
-    "The requested offset is not within the range of offsets maintained by the server.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "The requested offset is not within the range of offsets maintained by the server."
 );
 const kafka_error_code kafka_error_code::CORRUPT_MESSAGE (
     2,
     "This message failed its CRC checksum, exceeds the valid size, "
-    "has a null key for a compacted topic, or is otherwise corrupt.",
-    is_retriable::yes,
-	should_invalidate_metadata::no
+    "has a null key for a compacted topic, or is otherwise corrupt."
 );
 const kafka_error_code kafka_error_code::UNKNOWN_TOPIC_OR_PARTITION (
     3,
-    "This server does not host this topic-partition.",
-    is_retriable::yes,
-	should_invalidate_metadata::yes
+    "This server does not host this topic-partition."
 );
 const kafka_error_code kafka_error_code::INVALID_FETCH_SIZE (
     4,
-    "The requested fetch size is invalid.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "The requested fetch size is invalid."
 );
 const kafka_error_code kafka_error_code::LEADER_NOT_AVAILABLE (
     5,
     "There is no leader for this topic-partition "
-    "as we are in the middle of leadership election.",
-    is_retriable::yes,
-	should_invalidate_metadata::yes
+    "as we are in the middle of leadership election."
 );
 const kafka_error_code kafka_error_code::NOT_LEADER_FOR_PARTITION (
     6,
-    "This server is not the leader for that topic-partition.",
-    is_retriable::yes,
-	should_invalidate_metadata::yes
+    "This server is not the leader for that topic-partition."
 );
 const kafka_error_code kafka_error_code::REQUEST_TIMED_OUT (
     7,
-    "The request timed out.",
-    is_retriable::yes,
-	should_invalidate_metadata::no
+    "The request timed out."
 );
 const kafka_error_code kafka_error_code::BROKER_NOT_AVAILABLE (
     8,
-    "The broker is not available.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "The broker is not available."
 );
 const kafka_error_code kafka_error_code::REPLICA_NOT_AVAILABLE (
     9,
-    "The replica is not available for the requested topic partition.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "The replica is not available for the requested topic partition."
 );
 const kafka_error_code kafka_error_code::MESSAGE_TOO_LARGE (
     10,
     "The request included a message larger than "
-    "the max message size the server will accept.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "the max message size the server will accept."
 );
 const kafka_error_code kafka_error_code::STALE_CONTROLLER_EPOCH (
     11,
-    "The controller moved to another broker.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "The controller moved to another broker."
 );
 const kafka_error_code kafka_error_code::OFFSET_METADATA_TOO_LARGE (
     12,
-    "The metadata field of the offset request was too large.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "The metadata field of the offset request was too large."
 );
 const kafka_error_code kafka_error_code::NETWORK_EXCEPTION (
     13,
-    "The server disconnected before a response was retrieved.",
-    is_retriable::yes,
-	should_invalidate_metadata::yes
+    "The server disconnected before a response was retrieved."
 );
 const kafka_error_code kafka_error_code::COORDINATOR_LOAD_IN_PROGRESS (
     14,
-    "The coordinator is loading and hence can't process requests.",
-    is_retriable::yes,
-	should_invalidate_metadata::no
+    "The coordinator is loading and hence can't process requests."
 );
 const kafka_error_code kafka_error_code::COORDINATOR_NOT_AVAILABLE (
     15,
-    "The coordinator is not available.",
-    is_retriable::yes,
-	should_invalidate_metadata::no
+    "The coordinator is not available."
 );
 const kafka_error_code kafka_error_code::NOT_COORDINATOR (
     16,
-    "This is not the correct coordinator.",
-    is_retriable::yes,
-	should_invalidate_metadata::no
+    "This is not the correct coordinator."
 );
 const kafka_error_code kafka_error_code::INVALID_TOPIC_EXCEPTION (
     17,
-    "The request attempted to perform an operation on an invalid topic.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "The request attempted to perform an operation on an invalid topic."
 );
 const kafka_error_code kafka_error_code::RECORD_LIST_TOO_LARGE (
     18,
-    "The request included message batch larger than the configured segment size on the server.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "The request included message batch larger than the configured segment size on the server."
 );
 const kafka_error_code kafka_error_code::NOT_ENOUGH_REPLICAS (
     19,
-    "Messages are rejected since there are fewer in-sync replicas than required.",
-    is_retriable::yes,
-	should_invalidate_metadata::no
+    "Messages are rejected since there are fewer in-sync replicas than required."
 );
 const kafka_error_code kafka_error_code::NOT_ENOUGH_REPLICAS_AFTER_APPEND (
     20,
-    "Messages are written to the log, but to fewer in-sync replicas than required.",
-    is_retriable::yes,
-	should_invalidate_metadata::no
+    "Messages are written to the log, but to fewer in-sync replicas than required."
 );
 const kafka_error_code kafka_error_code::INVALID_REQUIRED_ACKS (
     21,
-    "Produce request specified an invalid value for required acks.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "Produce request specified an invalid value for required acks."
 );
 const kafka_error_code kafka_error_code::ILLEGAL_GENERATION (
     22,
-    "Specified group generation id is not valid.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "Specified group generation id is not valid."
 );
 const kafka_error_code kafka_error_code::INCONSISTENT_PROTOCOL (
     23,
     "The group member's supported protocols are incompatible with those of existing members "
-    "or first group member tried to join with empty protocol type or empty protocol list.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "or first group member tried to join with empty protocol type or empty protocol list."
 );
 const kafka_error_code kafka_error_code::INVALID_GROUP_ID (
     24,
-    "The configured groupId is invalid.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "The configured groupId is invalid."
 );
 const kafka_error_code kafka_error_code::UNKNOWN_MEMBER_ID (
     25,
-    "The coordinator is not aware of this member.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "The coordinator is not aware of this member."
 );
 const kafka_error_code kafka_error_code::INVALID_SESSION_TIMEOUT (
     26,
     "The session timeout is not within the range allowed by the broker "
-    "(as configured by group.min.session.timeout.ms and group.max.session.timeout.ms).",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "(as configured by group.min.session.timeout.ms and group.max.session.timeout.ms)."
 );
 const kafka_error_code kafka_error_code::REBALANCE_IN_PROGRESS (
     27,
-    "The group is rebalancing, so a rejoin is needed.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "The group is rebalancing, so a rejoin is needed."
 );
 const kafka_error_code kafka_error_code::INVALID_COMMIT_OFFSET_SIZE (
     28,
-    "The committing offset data size is not valid.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "The committing offset data size is not valid."
 );
 const kafka_error_code kafka_error_code::TOPIC_AUTHORIZATION_FAILED (
     29,
-    "Topic authorization failed.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "Topic authorization failed."
 );
 const kafka_error_code kafka_error_code::GROUP_AUTHORIZATION_FAILED (
     30,
-    "Group authorization failed.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "Group authorization failed."
 );
 const kafka_error_code kafka_error_code::CLUSTER_AUTHORIZATION_FAILED (
     31,
-    "Cluster authorization failed.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "Cluster authorization failed."
 );
 const kafka_error_code kafka_error_code::INVALID_TIMESTAMP (
     32,
-    "The timestamp of the message is out of acceptable range.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "The timestamp of the message is out of acceptable range."
 );
 const kafka_error_code kafka_error_code::UNSUPPORTED_SASL_MECHANISM (
     33,
-    "The broker does not support the requested SASL mechanism.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "The broker does not support the requested SASL mechanism."
 );
 const kafka_error_code kafka_error_code::ILLEGAL_SASL_STATE (
     34,
-    "Request is not valid given the current SASL state.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "Request is not valid given the current SASL state."
 );
 const kafka_error_code kafka_error_code::UNSUPPORTED_VERSION (
     35,
-    "The version of API is not supported.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "The version of API is not supported."
 );
 const kafka_error_code kafka_error_code::TOPIC_ALREADY_EXISTS (
     36,
-    "Topic with this name already exists.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "Topic with this name already exists."
 );
 const kafka_error_code kafka_error_code::INVALID_PARTITIONS (
     37,
-    "Number of partitions is below 1.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "Number of partitions is below 1."
 );
 const kafka_error_code kafka_error_code::INVALID_REPLICATION_FACTOR (
     38,
     "Replication factor is below 1 "
-    "or larger than the number of available brokers.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "or larger than the number of available brokers."
 );
 const kafka_error_code kafka_error_code::INVALID_REPLICA_ASSIGNMENT (
     39,
-    "Replica assignment is invalid.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "Replica assignment is invalid."
 );
 const kafka_error_code kafka_error_code::INVALID_CONFIG (
     40,
-    "Configuration is invalid.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "Configuration is invalid."
 );
 const kafka_error_code kafka_error_code::NOT_CONTROLLER (
     41,
-    "This is not the correct controller for this cluster.",
-    is_retriable::yes,
-	should_invalidate_metadata::no
+    "This is not the correct controller for this cluster."
 );
 const kafka_error_code kafka_error_code::INVALID_REQUEST (
     42,
     "This most likely occurs because of a request being malformed by the "
     "client library or the message was sent to an incompatible broker. "
-    "See the broker logs for more details.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "See the broker logs for more details."
 );
 const kafka_error_code kafka_error_code::UNSUPPORTED_FOR_MESSAGE_FORMAT (
     43,
-    "The message format version on the broker does not support the request.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "The message format version on the broker does not support the request."
 );
 const kafka_error_code kafka_error_code::POLICY_VIOLATION (
     44,
-    "Request parameters do not satisfy the configured policy.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "Request parameters do not satisfy the configured policy."
 );
 const kafka_error_code kafka_error_code::OUT_OF_ORDER_SEQUENCE_NUMBER (
     45,
-    "The broker received an out of order sequence number.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "The broker received an out of order sequence number."
 );
 const kafka_error_code kafka_error_code::DUPLICATE_SEQUENCE_NUMBER (
     46,
-    "The broker received a duplicate sequence number.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "The broker received a duplicate sequence number."
 );
 const kafka_error_code kafka_error_code::INVALID_PRODUCER_EPOCH (
     47,
     "Producer attempted an operation with an old epoch. Either there is a newer producer "
-    "with the same transactionalId, or the producer's transaction has been expired by the broker.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "with the same transactionalId, or the producer's transaction has been expired by the broker."
 );
 const kafka_error_code kafka_error_code::INVALID_TXN_STATE (
     48,
-    "The producer attempted a transactional operation in an invalid state.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "The producer attempted a transactional operation in an invalid state."
 );
 const kafka_error_code kafka_error_code::INVALID_PRODUCER_ID_MAPPING (
     49,
     "The producer attempted to use a producer id "
-    "which is not currently assigned to its transactional id.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "which is not currently assigned to its transactional id."
 );
 const kafka_error_code kafka_error_code::INVALID_TRANSACTION_TIMEOUT (
     50,
     "The transaction timeout is larger than the maximum value allowed by "
-    "the broker (as configured by transaction.max.timeout.ms).",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "the broker (as configured by transaction.max.timeout.ms)."
 );
 const kafka_error_code kafka_error_code::CONCURRENT_TRANSACTIONS (
     51,
     "The producer attempted to update a transaction "
-    "while another concurrent operation on the same transaction was ongoing.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "while another concurrent operation on the same transaction was ongoing."
 );
 const kafka_error_code kafka_error_code::TRANSACTION_COORDINATOR_FENCED (
     52,
     "Indicates that the transaction coordinator sending a WriteTxnMarker "
-    "is no longer the current coordinator for a given producer.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "is no longer the current coordinator for a given producer."
 );
 const kafka_error_code kafka_error_code::TRANSACTIONAL_ID_AUTHORIZATION_FAILED (
     53,
-    "Transactional Id authorization failed.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "Transactional Id authorization failed."
 );
 const kafka_error_code kafka_error_code::SECURITY_DISABLED (
     54,
-    "Security features are disabled.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "Security features are disabled."
 );
 const kafka_error_code kafka_error_code::OPERATION_NOT_ATTEMPTED (
     55,
@@ -402,27 +290,19 @@ const kafka_error_code kafka_error_code::OPERATION_NOT_ATTEMPTED (
     "This may happen for batched RPCs "
     "where some operations in the batch failed, "
     "causing the broker to respond without "
-    "trying the rest.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "trying the rest."
 );
 const kafka_error_code kafka_error_code::KAFKA_STORAGE_ERROR (
     56,
-    "Disk error when trying to access log file on the disk.",
-    is_retriable::yes,
-	should_invalidate_metadata::yes
+    "Disk error when trying to access log file on the disk."
 );
 const kafka_error_code kafka_error_code::LOG_DIR_NOT_FOUND (
     57,
-    "The user-specified log directory is not found in the broker config.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "The user-specified log directory is not found in the broker config."
 );
 const kafka_error_code kafka_error_code::SASL_AUTHENTICATION_FAILED (
     58,
-    "SASL Authentication failed.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "SASL Authentication failed."
 );
 const kafka_error_code kafka_error_code::UNKNOWN_PRODUCER_ID (
     59,
@@ -432,184 +312,126 @@ const kafka_error_code kafka_error_code::UNKNOWN_PRODUCER_ID (
     "were deleted because their retention time had elapsed. "
     "Once the last records of the producerId are removed, "
     "the producer's metadata is removed from the broker, "
-    "and future appends by the producer will return this exception.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "and future appends by the producer will return this exception."
 );
 const kafka_error_code kafka_error_code::REASSIGNMENT_IN_PROGRESS (
     60,
-    "A partition reassignment is in progress.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "A partition reassignment is in progress."
 );
 const kafka_error_code kafka_error_code::DELEGATION_TOKEN_AUTH_DISABLED (
     61,
-    "Delegation Token feature is not enabled.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "Delegation Token feature is not enabled."
 );
 const kafka_error_code kafka_error_code::DELEGATION_TOKEN_NOT_FOUND (
     62,
-    "Delegation Token is not found on server.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "Delegation Token is not found on server."
 );
 const kafka_error_code kafka_error_code::DELEGATION_TOKEN_OWNER_MISMATCH (
     63,
-    "Specified Principal is not valid Owner/Renewer.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "Specified Principal is not valid Owner/Renewer."
 );
 const kafka_error_code kafka_error_code::DELEGATION_TOKEN_REQUEST_NOT_ALLOWED (
     64,
     "Delegation Token requests are not allowed on PLAINTEXT/1-way SSL "
-    "channels and on delegation token authenticated channels.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "channels and on delegation token authenticated channels."
 );
 const kafka_error_code kafka_error_code::DELEGATION_TOKEN_AUTHORIZATION_FAILED (
     65,
-    "Delegation Token authorization failed.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "Delegation Token authorization failed."
 );
 const kafka_error_code kafka_error_code::DELEGATION_TOKEN_EXPIRED (
     66,
-    "Delegation Token is expired.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "Delegation Token is expired."
 );
 const kafka_error_code kafka_error_code::INVALID_PRINCIPAL_TYPE (
     67,
-    "Supplied principalType is not supported.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "Supplied principalType is not supported."
 );
 const kafka_error_code kafka_error_code::NON_EMPTY_GROUP (
     68,
-    "The group is not empty.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "The group is not empty."
 );
 const kafka_error_code kafka_error_code::GROUP_ID_NOT_FOUND (
     69,
-    "The group id does not exist.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "The group id does not exist."
 );
 const kafka_error_code kafka_error_code::FETCH_SESSION_ID_NOT_FOUND (
     70,
-    "The fetch session ID was not found.",
-    is_retriable::yes,
-	should_invalidate_metadata::no
+    "The fetch session ID was not found."
 );
 const kafka_error_code kafka_error_code::INVALID_FETCH_SESSION_EPOCH (
     71,
-    "The fetch session epoch is invalid.",
-    is_retriable::yes,
-	should_invalidate_metadata::no
+    "The fetch session epoch is invalid."
 );
 const kafka_error_code kafka_error_code::LISTENER_NOT_FOUND (
     72,
     "There is no listener on the leader broker that matches the listener "
-    "on which metadata request was processed.",
-    is_retriable::yes,
-	should_invalidate_metadata::yes
+    "on which metadata request was processed."
 );
 const kafka_error_code kafka_error_code::TOPIC_DELETION_DISABLED (
     73,
-    "Topic deletion is disabled.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "Topic deletion is disabled."
 );
 const kafka_error_code kafka_error_code::FENCED_LEADER_EPOCH (
     74,
-    "The leader epoch in the request is older than the epoch on the broker.",
-    is_retriable::yes,
-	should_invalidate_metadata::yes
+    "The leader epoch in the request is older than the epoch on the broker."
 );
 const kafka_error_code kafka_error_code::UNKNOWN_LEADER_EPOCH (
     75,
-    "The leader epoch in the request is newer than the epoch on the broker.",
-    is_retriable::yes,
-	should_invalidate_metadata::no
+    "The leader epoch in the request is newer than the epoch on the broker."
 );
 const kafka_error_code kafka_error_code::UNSUPPORTED_COMPRESSION_TYPE (
     76,
-    "The requesting client does not support the compression type of given partition.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "The requesting client does not support the compression type of given partition."
 );
 const kafka_error_code kafka_error_code::STALE_BROKER_EPOCH (
     77,
-    "Broker epoch has changed.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "Broker epoch has changed."
 );
 const kafka_error_code kafka_error_code::OFFSET_NOT_AVAILABLE (
     78,
     "The leader high watermark has not caught up from a recent leader election "
-    "so the offsets cannot be guaranteed to be monotonically increasing.",
-    is_retriable::yes,
-	should_invalidate_metadata::no
+    "so the offsets cannot be guaranteed to be monotonically increasing."
 );
 const kafka_error_code kafka_error_code::MEMBER_ID_REQUIRED (
     79,
     "The group member needs to have a valid member id "
-    "before actually entering a consumer group.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "before actually entering a consumer group."
 );
 const kafka_error_code kafka_error_code::PREFERRED_LEADER_NOT_AVAILABLE (
     80,
-    "The preferred leader was not available.",
-    is_retriable::yes,
-	should_invalidate_metadata::yes
+    "The preferred leader was not available."
 );
 const kafka_error_code kafka_error_code::GROUP_MAX_SIZE_REACHED (
     81,
-    "The consumer group has reached its max size.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "The consumer group has reached its max size."
 );
 const kafka_error_code kafka_error_code::FENCED_INSTANCE_ID (
     82,
     "The broker rejected this consumer since "
     "another consumer with the same group.instance.id has registered "
-    "with a different member.id.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "with a different member.id."
 );
 const kafka_error_code kafka_error_code::ELIGIBLE_LEADERS_NOT_AVAILABLE (
     83,
-    "Eligible topic partition leaders are not available.",
-    is_retriable::yes,
-	should_invalidate_metadata::yes
+    "Eligible topic partition leaders are not available."
 );
 const kafka_error_code kafka_error_code::ELECTION_NOT_NEEDED (
     84,
-    "Leader election not needed for topic partition.",
-    is_retriable::yes,
-	should_invalidate_metadata::yes
+    "Leader election not needed for topic partition."
 );
 const kafka_error_code kafka_error_code::NO_REASSIGNMENT_IN_PROGRESS (
     85,
-    "No partition reassignment is in progress.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "No partition reassignment is in progress."
 );
 const kafka_error_code kafka_error_code::GROUP_SUBSCRIBED_TO_TOPIC (
     86,
     "Deleting offsets of a topic is forbidden "
-    "while the consumer group is actively subscribed to it.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "while the consumer group is actively subscribed to it."
 );
 const kafka_error_code kafka_error_code::INVALID_RECORD (
     87,
-    "This record has failed the validation on broker and hence be rejected.",
-    is_retriable::no,
-	should_invalidate_metadata::no
+    "This record has failed the validation on broker and hence be rejected."
 );
 }
 
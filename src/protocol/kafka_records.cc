@@ -26,8 +26,12 @@
 #include <boost/iostreams/device/back_inserter.hpp>
 #include <boost/iostreams/stream.hpp>
 #include <cstdint>
+#include <cstring>
+#include <limits>
 #include <smmintrin.h>
 
+#include <seastar/core/temporary_buffer.hh>
+
 // https://bidetly.io/2017/02/08/crc-part-1
 std::uint32_t crc32c(const char* first, const char* last) {
     std::uint32_t code = ~0U;
@@ -58,14 +62,41 @@ using namespace seastar;
 
 namespace kafka4seastar {
 
-void kafka_record_header::serialize(std::ostream& os, int16_t api_version) const {
-    kafka_varint_t header_key_length(header_key.size());
-    header_key_length.serialize(os, api_version);
-    os.write(header_key.data(), header_key.size());
+namespace {
+
+size_t varint_bytes_size(size_t size) noexcept {
+    return varint_size(static_cast<int32_t>(size)) + size;
+}
+
+char* encode_varint_bytes(const sstring& bytes, char* out) noexcept {
+    out = encode_varint(static_cast<int32_t>(bytes.size()), out);
+    std::memcpy(out, bytes.data(), bytes.size());
+    return out + bytes.size();
+}
+
+size_t nullable_varint_bytes_size(const std::optional<sstring>& bytes) noexcept {
+    return bytes ? varint_bytes_size(bytes->size()) : varint_size(-1);
+}
+
+char* encode_nullable_varint_bytes(const std::optional<sstring>& bytes, char* out) noexcept {
+    return bytes ? encode_varint_bytes(*bytes, out) : encode_varint(-1, out);
+}
+
+size_t header_size(const kafka_record_header& header) noexcept {
+    return varint_bytes_size(header.header_key.size()) + varint_bytes_size(header.value.size());
+}
+
+char* encode_header(const kafka_record_header& header, char* out) noexcept {
+    out = encode_varint_bytes(header.header_key, out);
+    return encode_varint_bytes(header.value, out);
+}
 
-    kafka_varint_t header_value_length(value.size());
-    header_value_length.serialize(os, api_version);
-    os.write(value.data(), value.size());
+}
+
+void kafka_record_header::serialize(std::ostream& os, int16_t api_version) const {
+    temporary_buffer<char> buffer(header_size(*this));
+    encode_header(*this, buffer.get_write());
+    os.write(buffer.get(), buffer.size());
 }
 
 void kafka_record_header::deserialize(std::istream& is, int16_t api_version) {
@@ -79,46 +110,32 @@ void kafka_record_header::deserialize(std::istream& is, int16_t api_version) {
 }
 
 void kafka_record::serialize(std::ostream& os, int16_t api_version) const {
-    std::vector<char> record_data;
-    boost::iostreams::back_insert_device<std::vector<char>> record_data_sink{record_data};
-    boost::iostreams::stream<boost::iostreams::back_insert_device<std::vector<char>>> record_data_stream{record_data_sink};
-
-    kafka_int8_t attributes(0);
-    attributes.serialize(record_data_stream, api_version);
-
-    timestamp_delta.serialize(record_data_stream, api_version);
-    offset_delta.serialize(record_data_stream, api_version);
-
-    if (key) {
-        kafka_varint_t key_length(key->size());
-        key_length.serialize(record_data_stream, api_version);
-        record_data_stream.write(key->data(), key->size());
-    } else {
-        kafka_varint_t null_indicator(-1);
-        null_indicator.serialize(record_data_stream, api_version);
-    }
-
-    if (value) {
-        kafka_varint_t value_length(value->size());
-        value_length.serialize(record_data_stream, api_version);
-        record_data_stream.write(value->data(), value->size());
-    } else {
-        kafka_varint_t null_indicator(-1);
-        null_indicator.serialize(record_data_stream, api_version);
+    // Attributes of a record are unused, they take up a single zero byte.
+    size_t length = 1;
+    length += varlong_size(*timestamp_delta);
+    length += varint_size(*offset_delta);
+    length += nullable_varint_bytes_size(key);
+    length += nullable_varint_bytes_size(value);
+    length += varint_size(static_cast<int32_t>(headers.size()));
+    for (const auto& header : headers) {
+        length += header_size(header);
     }
 
-    kafka_varint_t header_count(headers.size());
-    header_count.serialize(record_data_stream, api_version);
-
+    // With the length known upfront, the whole record is encoded
+    // into a single buffer and written out at once.
+    temporary_buffer<char> buffer(varint_size(static_cast<int32_t>(length)) + length);
+    auto out = encode_varint(static_cast<int32_t>(length), buffer.get_write());
+    *out++ = 0;
+    out = encode_varlong(*timestamp_delta, out);
+    out = encode_varint(*offset_delta, out);
+    out = encode_nullable_varint_bytes(key, out);
+    out = encode_nullable_varint_bytes(value, out);
+    out = encode_varint(static_cast<int32_t>(headers.size()), out);
     for (const auto& header : headers) {
-        header.serialize(record_data_stream, api_version);
+        out = encode_header(header, out);
     }
-    record_data_stream.flush();
-
-    kafka_varint_t length(record_data.size());
-    length.serialize(os, api_version);
 
-    os.write(record_data.data(), record_data.size());
+    os.write(buffer.get(), buffer.size());
 }
 
 void kafka_record::deserialize(std::istream& is, int16_t api_version) {
@@ -186,7 +203,7 @@ void kafka_record_batch::serialize(std::ostream& os, int16_t api_version) const
 
     first_timestamp.serialize(payload_stream, api_version);
 
-    int32_t max_timestamp_delta = 0;
+    int64_t max_timestamp_delta = 0;
     for (const auto& record : records) {
         max_timestamp_delta = std::max(max_timestamp_delta, *record.timestamp_delta);
     }
@@ -255,6 +272,10 @@ void kafka_record_batch::deserialize(std::istream& is, int16_t api_version) {
 
     kafka_int32_t batch_length;
     batch_length.deserialize(is, api_version);
+    if (*batch_length < 0) {
+        throw parsing_exception("Record batch length is invalid");
+    }
+    details::check_length(is, *batch_length, std::numeric_limits<size_t>::max(), "record batch");
 
     auto expected_end_of_batch = is.tellg();
     expected_end_of_batch += *batch_length;
@@ -302,12 +323,13 @@ void kafka_record_batch::deserialize(std::istream& is, int16_t api_version) {
     kafka_int32_t records_count;
     records_count.deserialize(is, api_version);
 
-    if (*records_count < 0) {
+    // Every record takes up at least a few bytes.
+    auto remaining_bytes = expected_end_of_batch - is.tellg();
+    if (*records_count < 0 || *records_count > remaining_bytes) {
         throw parsing_exception("Record count in batch is invalid");
     }
     records.resize(*records_count);
 
-    auto remaining_bytes = expected_end_of_batch - is.tellg();
     std::vector<char> records_payload(remaining_bytes);
 
     is.read(records_payload.data(), remaining_bytes);
@@ -325,7 +347,16 @@ void kafka_record_batch::deserialize(std::istream& is, int16_t api_version) {
     }
 }
 
-void kafka_records::serialize(std::ostream& os, int16_t api_version) const {
+size_t kafka_records::serialized_size(int16_t api_version, bool compact) const {
+    std::vector<char> serialized;
+    boost::iostreams::back_insert_device<std::vector<char>> serialized_sink{serialized};
+    boost::iostreams::stream<boost::iostreams::back_insert_device<std::vector<char>>> serialized_stream{serialized_sink};
+    serialize(serialized_stream, api_version, compact);
+    serialized_stream.flush();
+    return serialized.size();
+}
+
+void kafka_records::serialize(std::ostream& os, int16_t api_version, bool compact) const {
     std::vector<char> serialized_batches;
     boost::iostreams::back_insert_device<std::vector<char>> serialized_batches_sink{serialized_batches};
     boost::iostreams::stream<boost::iostreams::back_insert_device<std::vector<char>>> serialized_batches_stream{serialized_batches_sink};
@@ -336,21 +367,32 @@ void kafka_records::serialize(std::ostream& os, int16_t api_version) const {
 
     serialized_batches_stream.flush();
 
-    kafka_int32_t records_length(serialized_batches.size());
-    records_length.serialize(os, api_version);
+    if (compact) {
+        kafka_compact_length_t(serialized_batches.size()).serialize(os, api_version);
+    } else {
+        kafka_int32_t(serialized_batches.size()).serialize(os, api_version);
+    }
 
     os.write(serialized_batches.data(), serialized_batches.size());
 }
 
-void kafka_records::deserialize(std::istream& is, int16_t api_version) {
-    kafka_int32_t records_length;
-    records_length.deserialize(is, api_version);
-    if (*records_length < 0) {
+void kafka_records::deserialize(std::istream& is, int16_t api_version, bool compact) {
+    int32_t records_length;
+    if (compact) {
+        kafka_compact_length_t length;
+        length.deserialize(is, api_version);
+        records_length = *length;
+    } else {
+        kafka_int32_t length;
+        length.deserialize(is, api_version);
+        records_length = *length;
+    }
+    if (records_length < 0) {
         throw parsing_exception("Records length is invalid");
     }
 
     auto expected_end_of_records = is.tellg();
-    expected_end_of_records += *records_length;
+    expected_end_of_records += records_length;
 
     record_batches.clear();
     while (is.tellg() < expected_end_of_records) {
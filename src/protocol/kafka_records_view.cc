@@ -0,0 +1,312 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (C) 2019 ScyllaDB Ltd.
+ */
+
+
+#include <array>
+#include <cstring>
+#include <limits>
+
+#include <kafka4seastar/protocol/kafka_records_view.hh>
+
+using namespace seastar;
+
+namespace kafka4seastar {
+
+namespace {
+
+constexpr size_t BASE_OFFSET_OFFSET = 0;
+constexpr size_t BATCH_LENGTH_OFFSET = 8;
+constexpr size_t PARTITION_LEADER_EPOCH_OFFSET = 12;
+constexpr size_t MAGIC_OFFSET = 16;
+constexpr size_t CRC_OFFSET = 17;
+constexpr size_t ATTRIBUTES_OFFSET = 21;
+constexpr size_t LAST_OFFSET_DELTA_OFFSET = 23;
+constexpr size_t FIRST_TIMESTAMP_OFFSET = 27;
+constexpr size_t MAX_TIMESTAMP_OFFSET = 35;
+constexpr size_t PRODUCER_ID_OFFSET = 43;
+constexpr size_t PRODUCER_EPOCH_OFFSET = 51;
+constexpr size_t BASE_SEQUENCE_OFFSET = 53;
+constexpr size_t RECORDS_COUNT_OFFSET = 57;
+
+// Base offset and batch length are not included in the batch length.
+constexpr size_t LOG_OVERHEAD = 12;
+
+template<typename NumberType>
+NumberType read_be(const char* data) {
+    NumberType value;
+    std::memcpy(&value, data, sizeof(value));
+    return net::ntoh(value);
+}
+
+}
+
+namespace details {
+
+std::optional<std::string_view> decode_varint_bytes(const char*& pos, const char* end) {
+    int32_t length;
+    if (!decode_varint(pos, end, length)) {
+        throw parsing_exception("Record ended prematurely when reading varint");
+    }
+    if (length < 0) {
+        return std::nullopt;
+    }
+    if (length > end - pos) {
+        throw parsing_exception("Record ended prematurely when reading bytes");
+    }
+    std::string_view bytes(pos, length);
+    pos += length;
+    return bytes;
+}
+
+}
+
+kafka_record_batch_view::kafka_record_batch_view(temporary_buffer<char> buffer)
+        : _buffer(std::move(buffer)) {
+    if (_buffer.size() < HEADER_SIZE) {
+        throw parsing_exception("Record batch is too short");
+    }
+    if (LOG_OVERHEAD + read_be<int32_t>(_buffer.get() + BATCH_LENGTH_OFFSET) != _buffer.size()) {
+        throw parsing_exception("Record batch length is invalid");
+    }
+    if (magic() != 2) {
+        throw parsing_exception("Unsupported record batch version");
+    }
+
+    auto crc = read_be<uint32_t>(_buffer.get() + CRC_OFFSET);
+    if (crc32c(_buffer.get() + ATTRIBUTES_OFFSET, _buffer.get() + _buffer.size()) != crc) {
+        throw parsing_exception("Record batch CRC mismatch");
+    }
+    if (records_count() < 0) {
+        throw parsing_exception("Record count in batch is invalid");
+    }
+}
+
+int64_t kafka_record_batch_view::base_offset() const noexcept {
+    return read_be<int64_t>(_buffer.get() + BASE_OFFSET_OFFSET);
+}
+
+int32_t kafka_record_batch_view::partition_leader_epoch() const noexcept {
+    return read_be<int32_t>(_buffer.get() + PARTITION_LEADER_EPOCH_OFFSET);
+}
+
+int8_t kafka_record_batch_view::magic() const noexcept {
+    return static_cast<int8_t>(_buffer[MAGIC_OFFSET]);
+}
+
+kafka_record_compression_type kafka_record_batch_view::compression_type() const noexcept {
+    return static_cast<kafka_record_compression_type>(read_be<int16_t>(_buffer.get() + ATTRIBUTES_OFFSET) & 0x7);
+}
+
+kafka_record_timestamp_type kafka_record_batch_view::timestamp_type() const noexcept {
+    return (read_be<int16_t>(_buffer.get() + ATTRIBUTES_OFFSET) & 0x8)
+            ? kafka_record_timestamp_type::LOG_APPEND_TIME
+            : kafka_record_timestamp_type::CREATE_TIME;
+}
+
+bool kafka_record_batch_view::is_transactional() const noexcept {
+    return read_be<int16_t>(_buffer.get() + ATTRIBUTES_OFFSET) & 0x10;
+}
+
+bool kafka_record_batch_view::is_control_batch() const noexcept {
+    return read_be<int16_t>(_buffer.get() + ATTRIBUTES_OFFSET) & 0x20;
+}
+
+int32_t kafka_record_batch_view::last_offset_delta() const noexcept {
+    return read_be<int32_t>(_buffer.get() + LAST_OFFSET_DELTA_OFFSET);
+}
+
+int64_t kafka_record_batch_view::last_offset() const noexcept {
+    return base_offset() + last_offset_delta();
+}
+
+int64_t kafka_record_batch_view::first_timestamp() const noexcept {
+    return read_be<int64_t>(_buffer.get() + FIRST_TIMESTAMP_OFFSET);
+}
+
+int64_t kafka_record_batch_view::max_timestamp() const noexcept {
+    return read_be<int64_t>(_buffer.get() + MAX_TIMESTAMP_OFFSET);
+}
+
+int64_t kafka_record_batch_view::producer_id() const noexcept {
+    return read_be<int64_t>(_buffer.get() + PRODUCER_ID_OFFSET);
+}
+
+int16_t kafka_record_batch_view::producer_epoch() const noexcept {
+    return read_be<int16_t>(_buffer.get() + PRODUCER_EPOCH_OFFSET);
+}
+
+int32_t kafka_record_batch_view::base_sequence() const noexcept {
+    return read_be<int32_t>(_buffer.get() + BASE_SEQUENCE_OFFSET);
+}
+
+int32_t kafka_record_batch_view::records_count() const noexcept {
+    return read_be<int32_t>(_buffer.get() + RECORDS_COUNT_OFFSET);
+}
+
+kafka_record_batch_view::iterator kafka_record_batch_view::begin() const {
+    if (compression_type() != kafka_record_compression_type::NO_COMPRESSION) {
+        throw unsupported_compression_exception("Reading records of compressed batches is not supported");
+    }
+    return iterator(this, _buffer.get() + HEADER_SIZE, _buffer.get() + _buffer.size(), records_count());
+}
+
+kafka_record_batch_view::iterator kafka_record_batch_view::end() const {
+    return iterator();
+}
+
+kafka_record_batch_view::iterator::iterator(const kafka_record_batch_view* batch,
+        const char* position, const char* end, int32_t remaining)
+        : _batch(batch), _position(position), _end(end), _remaining(remaining) {
+    if (_remaining > 0) {
+        decode();
+    }
+}
+
+void kafka_record_batch_view::iterator::decode() {
+    int32_t length;
+    if (!decode_varint(_position, _end, length)) {
+        throw parsing_exception("Record ended prematurely when reading varint");
+    }
+    if (length < 1 || length > _end - _position) {
+        throw parsing_exception("Length of record is invalid");
+    }
+    auto record_end = _position + length;
+
+    // Attributes of a record are unused. Timestamp delta (a varlong)
+    // and offset delta (a varint) follow, decoded together.
+    _position++;
+    std::array<int64_t, 2> deltas;
+    if (!decode_varlongs(_position, record_end, deltas.data(), deltas.size())) {
+        throw parsing_exception("Record ended prematurely when reading varint");
+    }
+    auto [timestamp_delta, offset_delta] = deltas;
+    if (offset_delta < std::numeric_limits<int32_t>::min() || offset_delta > std::numeric_limits<int32_t>::max()) {
+        throw parsing_exception("Offset delta of record is invalid");
+    }
+
+    _current._offset = _batch->base_offset() + offset_delta;
+    _current._timestamp = _batch->timestamp_type() == kafka_record_timestamp_type::LOG_APPEND_TIME
+            ? _batch->max_timestamp()
+            : _batch->first_timestamp() + timestamp_delta;
+    _current._key = details::decode_varint_bytes(_position, record_end);
+    _current._value = details::decode_varint_bytes(_position, record_end);
+
+    int32_t header_count;
+    if (!decode_varint(_position, record_end, header_count)) {
+        throw parsing_exception("Record ended prematurely when reading varint");
+    }
+    if (header_count < 0) {
+        throw parsing_exception("Record header count is invalid");
+    }
+    _current._header_count = header_count;
+    _current._headers = std::string_view(_position, record_end - _position);
+
+    _position = record_end;
+}
+
+kafka_record_batch_view::iterator& kafka_record_batch_view::iterator::operator++() {
+    if (--_remaining > 0) {
+        decode();
+    }
+    return *this;
+}
+
+kafka_record_batch_view::iterator kafka_record_batch_view::iterator::operator++(int) {
+    auto previous = *this;
+    ++*this;
+    return previous;
+}
+
+kafka_records_view::kafka_records_view(temporary_buffer<char> buffer)
+        : _size(buffer.size()), _buffer(std::move(buffer)) {}
+
+void kafka_records_view::share_buffer(const temporary_buffer<char>& response_buffer) {
+    if (!is_null()) {
+        _buffer = response_buffer.share(_offset, _size);
+    }
+}
+
+std::vector<kafka_record_batch_view> kafka_records_view::batches() const {
+    std::vector<kafka_record_batch_view> batches;
+    size_t position = 0;
+    while (_buffer.size() - position >= LOG_OVERHEAD) {
+        auto batch_length = read_be<int32_t>(_buffer.get() + position + BATCH_LENGTH_OFFSET);
+        if (batch_length < 0) {
+            throw parsing_exception("Record batch length is invalid");
+        }
+        auto batch_size = LOG_OVERHEAD + batch_length;
+        if (batch_size > _buffer.size() - position) {
+            break;
+        }
+        batches.emplace_back(_buffer.share(position, batch_size));
+        position += batch_size;
+    }
+    return batches;
+}
+
+size_t kafka_records_view::serialized_size(int16_t api_version, bool compact) const {
+    auto length_size = compact ? kafka_compact_length_t(_size).serialized_size(api_version) : sizeof(int32_t);
+    return length_size + (is_null() ? 0 : _size);
+}
+
+void kafka_records_view::serialize(std::ostream& os, int16_t api_version, bool compact) const {
+    if (compact) {
+        kafka_compact_length_t(_size).serialize(os, api_version);
+    } else {
+        kafka_int32_t(_size).serialize(os, api_version);
+    }
+    if (!is_null()) {
+        if (_buffer.size() != static_cast<size_t>(_size)) {
+            throw parsing_exception("Records are not attached to a buffer");
+        }
+        os.write(_buffer.get(), _buffer.size());
+    }
+}
+
+void kafka_records_view::deserialize(std::istream& is, int16_t api_version, bool compact) {
+    int32_t length;
+    if (compact) {
+        kafka_compact_length_t compact_length;
+        compact_length.deserialize(is, api_version);
+        length = *compact_length;
+    } else {
+        kafka_int32_t records_length;
+        records_length.deserialize(is, api_version);
+        length = *records_length;
+    }
+    if (length < -1) {
+        throw parsing_exception("Records length is invalid");
+    }
+    _size = length;
+    _buffer = temporary_buffer<char>();
+    if (is_null()) {
+        return;
+    }
+
+    _offset = is.tellg();
+    is.seekg(_size, std::ios_base::cur);
+    if (!is || is.tellg() != _offset + _size) {
+        throw parsing_exception("Stream ended prematurely when reading records");
+    }
+}
+
+}
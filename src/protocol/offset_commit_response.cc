@@ -20,47 +20,44 @@
  * Copyright (C) 2019 ScyllaDB Ltd.
  */
 
-#include <kafka4seastar/protocol/produce_request.hh>
+
+#include <kafka4seastar/protocol/offset_commit_response.hh>
 
 using namespace seastar;
 
 namespace kafka4seastar {
 
-void produce_request_partition_produce_data::serialize(std::ostream& os, int16_t api_version) const {
+void offset_commit_response_partition::serialize(std::ostream& os, int16_t api_version) const {
     partition_index.serialize(os, api_version);
-    records.serialize(os, api_version);
+    error_code.serialize(os, api_version);
 }
 
-void produce_request_partition_produce_data::deserialize(std::istream& is, int16_t api_version) {
+void offset_commit_response_partition::deserialize(std::istream& is, int16_t api_version) {
     partition_index.deserialize(is, api_version);
-    records.deserialize(is, api_version);
+    error_code.deserialize(is, api_version);
 }
 
-void produce_request_topic_produce_data::serialize(std::ostream& os, int16_t api_version) const {
+void offset_commit_response_topic::serialize(std::ostream& os, int16_t api_version) const {
     name.serialize(os, api_version);
     partitions.serialize(os, api_version);
 }
 
-void produce_request_topic_produce_data::deserialize(std::istream& is, int16_t api_version) {
+void offset_commit_response_topic::deserialize(std::istream& is, int16_t api_version) {
     name.deserialize(is, api_version);
     partitions.deserialize(is, api_version);
 }
 
-void produce_request::serialize(std::ostream& os, int16_t api_version) const {
+void offset_commit_response::serialize(std::ostream& os, int16_t api_version) const {
     if (api_version >= 3) {
-        transactional_id.serialize(os, api_version);
+        throttle_time_ms.serialize(os, api_version);
     }
-    acks.serialize(os, api_version);
-    timeout_ms.serialize(os, api_version);
     topics.serialize(os, api_version);
 }
 
-void produce_request::deserialize(std::istream& is, int16_t api_version) {
+void offset_commit_response::deserialize(std::istream& is, int16_t api_version) {
     if (api_version >= 3) {
-        transactional_id.deserialize(is, api_version);
+        throttle_time_ms.deserialize(is, api_version);
     }
-    acks.deserialize(is, api_version);
-    timeout_ms.deserialize(is, api_version);
     topics.deserialize(is, api_version);
 }
 
@@ -20,40 +20,31 @@
  * Copyright (C) 2019 ScyllaDB Ltd.
  */
 
-#include <kafka4seastar/protocol/metadata_request.hh>
+
+#include <kafka4seastar/protocol/offset_fetch_request.hh>
 
 using namespace seastar;
 
 namespace kafka4seastar {
 
-void metadata_request_topic::serialize(std::ostream& os, int16_t api_version) const {
+void offset_fetch_request_topic::serialize(std::ostream& os, int16_t api_version) const {
     name.serialize(os, api_version);
+    partition_indexes.serialize(os, api_version);
 }
 
-void metadata_request_topic::deserialize(std::istream& is, int16_t api_version) {
+void offset_fetch_request_topic::deserialize(std::istream& is, int16_t api_version) {
     name.deserialize(is, api_version);
+    partition_indexes.deserialize(is, api_version);
 }
 
-void metadata_request::serialize(std::ostream& os, int16_t api_version) const {
+void offset_fetch_request::serialize(std::ostream& os, int16_t api_version) const {
+    group_id.serialize(os, api_version);
     topics.serialize(os, api_version);
-    if (api_version >= 4) {
-        allow_auto_topic_creation.serialize(os, api_version);
-    }
-    if (api_version >= 8) {
-        include_cluster_authorized_operations.serialize(os, api_version);
-        include_topic_authorized_operations.serialize(os, api_version);
-    }
 }
 
-void metadata_request::deserialize(std::istream& is, int16_t api_version) {
+void offset_fetch_request::deserialize(std::istream& is, int16_t api_version) {
+    group_id.deserialize(is, api_version);
     topics.deserialize(is, api_version);
-    if (api_version >= 4) {
-        allow_auto_topic_creation.deserialize(is, api_version);
-    }
-    if (api_version >= 8) {
-        include_cluster_authorized_operations.deserialize(is, api_version);
-        include_topic_authorized_operations.deserialize(is, api_version);
-    }
 }
 
 }
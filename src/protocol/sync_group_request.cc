@@ -0,0 +1,60 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (C) 2019 ScyllaDB Ltd.
+ */
+
+
+#include <kafka4seastar/protocol/sync_group_request.hh>
+
+using namespace seastar;
+
+namespace kafka4seastar {
+
+void sync_group_request_assignment::serialize(std::ostream& os, int16_t api_version) const {
+    member_id.serialize(os, api_version);
+    assignment.serialize(os, api_version);
+}
+
+void sync_group_request_assignment::deserialize(std::istream& is, int16_t api_version) {
+    member_id.deserialize(is, api_version);
+    assignment.deserialize(is, api_version);
+}
+
+void sync_group_request::serialize(std::ostream& os, int16_t api_version) const {
+    group_id.serialize(os, api_version);
+    generation_id.serialize(os, api_version);
+    member_id.serialize(os, api_version);
+    if (api_version >= 3) {
+        group_instance_id.serialize(os, api_version);
+    }
+    assignments.serialize(os, api_version);
+}
+
+void sync_group_request::deserialize(std::istream& is, int16_t api_version) {
+    group_id.deserialize(is, api_version);
+    generation_id.deserialize(is, api_version);
+    member_id.deserialize(is, api_version);
+    if (api_version >= 3) {
+        group_instance_id.deserialize(is, api_version);
+    }
+    assignments.deserialize(is, api_version);
+}
+
+}
@@ -61,6 +61,14 @@ std::unique_ptr<partitioner> random_partitioner() {
     return std::make_unique<basic_partitioner>();
 }
 
+std::unique_ptr<partitioner> sticky_partitioner(uint32_t batch_size) {
+    return std::make_unique<kafka4seastar::sticky_partitioner>(batch_size);
+}
+
+std::unique_ptr<partition_assignor> cooperative_sticky_assignor() {
+    return std::make_unique<kafka4seastar::cooperative_sticky_assignor>();
+}
+
 }
 
 }
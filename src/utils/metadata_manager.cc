@@ -20,6 +20,7 @@
  * Copyright (C) 2019 ScyllaDB Ltd.
  */
 
+#include <kafka4seastar/utils/exceptions.hh>
 #include <kafka4seastar/utils/metadata_manager.hh>
 #include <seastar/core/sleep.hh>
 #include <seastar/core/thread.hh>
@@ -58,13 +59,14 @@ namespace kafka4seastar {
                 });
             }
             _metadata = std::move(metadata);
+            index_brokers();
+            warm_up_leaders();
         }).handle_exception([] (std::exception_ptr ep) {
-            try {
-                std::rethrow_exception(ep);
-            } catch (metadata_refresh_exception& e) {
+            if (try_catch<metadata_refresh_exception>(ep)) {
                 // Ignore metadata_refresh_exception and preserve the old metadata.
-                return;
+                return make_ready_future<>();
             }
+            return make_exception_future<>(ep);
         });
     }
 
@@ -73,11 +75,7 @@ namespace kafka4seastar {
             return seastar::sleep_abortable(dur, _stop_refresh).then([this] {
                 return refresh_metadata();
             }).handle_exception([this] (std::exception_ptr ep) {
-                try {
-                    std::rethrow_exception(ep);
-                } catch (...) {
-                    return make_ready_future();
-                }
+                return make_ready_future();
             });
         }).finally([this]{
             _refresh_finished.signal();
@@ -85,6 +83,65 @@ namespace kafka4seastar {
         });
     }
 
+    void metadata_manager::index_brokers() {
+        const auto& brokers = *_metadata.brokers;
+        _broker_handles.clear();
+        if (brokers.empty()) {
+            return;
+        }
+
+        // Brokers are sorted by node id.
+        _first_node_id = *brokers.front().node_id;
+        auto span = int64_t(*brokers.back().node_id) - _first_node_id + 1;
+        _dense_node_ids = span <= MAX_NODE_ID_SPAN;
+        _broker_handles.resize(_dense_node_ids ? span : brokers.size(), connection_manager::NO_BROKER);
+        for (size_t i = 0; i < brokers.size(); i++) {
+            auto index = _dense_node_ids ? size_t(*brokers[i].node_id - _first_node_id) : i;
+            _broker_handles[index] = _connection_manager.handle_of({*brokers[i].host, *brokers[i].port});
+        }
+    }
+
+    connection_manager::broker_handle metadata_manager::broker_handle_for(int32_t node_id) const {
+        if (_dense_node_ids) {
+            auto index = int64_t(node_id) - _first_node_id;
+            if (index < 0 || index >= int64_t(_broker_handles.size())) {
+                return connection_manager::NO_BROKER;
+            }
+            return _broker_handles[index];
+        }
+
+        const auto& brokers = *_metadata.brokers;
+        auto it = std::lower_bound(brokers.begin(), brokers.end(), node_id, [] (auto& a, auto& b) {
+            return *a.node_id < b;
+        });
+        if (it == brokers.end() || *it->node_id != node_id) {
+            return connection_manager::NO_BROKER;
+        }
+        return _broker_handles[it - brokers.begin()];
+    }
+
+    void metadata_manager::warm_up_leaders() {
+        std::set<connection_manager::broker_handle> leaders;
+        for (const auto& topic : *_metadata.topics) {
+            if (!_topics_of_interest.empty() && !_topics_of_interest.count(*topic.name)) {
+                continue;
+            }
+            for (const auto& partition : *topic.partitions) {
+                auto leader = partition.error_code == error::kafka_error_code::NONE
+                              ? broker_handle_for(*partition.leader_id)
+                              : connection_manager::NO_BROKER;
+                if (leader != connection_manager::NO_BROKER) {
+                    leaders.insert(leader);
+                }
+            }
+        }
+        _connection_manager.warm_up(leaders);
+    }
+
+    void metadata_manager::set_topics_of_interest(std::set<seastar::sstring> topics) {
+        _topics_of_interest = std::move(topics);
+    }
+
     const metadata_response& metadata_manager::get_metadata() {
         return _metadata;
     }
@@ -20,6 +20,9 @@
  * Copyright (C) 2019 ScyllaDB Ltd.
  */
 
+#include <algorithm>
+#include <limits>
+
 #include <boost/functional/hash.hpp>
 #include <kafka4seastar/utils/partitioner.hh>
 
@@ -27,19 +30,160 @@ using namespace seastar;
 
 namespace kafka4seastar {
 
-const metadata_response_partition& basic_partitioner::get_partition(const seastar::sstring& key, const kafka_array_t<metadata_response_partition>& partitions) {
+int32_t murmur2(std::string_view key) noexcept {
+    constexpr uint32_t seed = 0x9747b28c;
+    constexpr uint32_t m = 0x5bd1e995;
+    constexpr int r = 24;
+
+    auto data = reinterpret_cast<const uint8_t*>(key.data());
+    auto length = key.size();
+    uint32_t h = seed ^ static_cast<uint32_t>(length);
+
+    for (size_t i = 0; i + 4 <= length; i += 4) {
+        uint32_t k = data[i] | (data[i + 1] << 8) | (data[i + 2] << 16) | (static_cast<uint32_t>(data[i + 3]) << 24);
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h *= m;
+        h ^= k;
+    }
+
+    auto tail = data + (length & ~size_t(3));
+    switch (length % 4) {
+    case 3:
+        h ^= tail[2] << 16;
+        [[fallthrough]];
+    case 2:
+        h ^= tail[1] << 8;
+        [[fallthrough]];
+    case 1:
+        h ^= tail[0];
+        h *= m;
+    }
+
+    h ^= h >> 13;
+    h *= m;
+    h ^= h >> 15;
+    return static_cast<int32_t>(h);
+}
+
+int32_t jump_consistent_hash(uint64_t key, int32_t buckets) noexcept {
+    int64_t bucket = -1;
+    int64_t next = 0;
+    while (next < buckets) {
+        bucket = next;
+        key = key * 2862933555777941757ULL + 1;
+        next = static_cast<int64_t>((bucket + 1) * (double(1LL << 31) / double((key >> 33) + 1)));
+    }
+    return static_cast<int32_t>(bucket);
+}
+
+namespace {
+
+// The partition at position, or the first available one after it.
+const metadata_response_partition& available_from(const partitioner_context& context,
+        const kafka_array_t<metadata_response_partition>& partitions, size_t position) {
+    auto size = partitions->size();
+    for (size_t i = 0; i < size; i++) {
+        const auto& candidate = partitions[(position + i) % size];
+        if (context.state_of(candidate).available) {
+            return candidate;
+        }
+    }
+    return partitions[position % size];
+}
+
+}
+
+const metadata_response_partition& basic_partitioner::get_partition(const partitioner_context& context,
+        std::optional<std::string_view> key, const kafka_array_t<metadata_response_partition>& partitions) {
     size_t index = std::rand() % partitions->size();
-    return partitions[index];
+    if (key) {
+        return partitions[index];
+    }
+    return available_from(context, partitions, index);
 }
 
-const metadata_response_partition& rr_partitioner::get_partition(const seastar::sstring& key, const kafka_array_t<metadata_response_partition>& partitions) {
-    if (!key.empty()) {
-        auto hash_value = std::hash<sstring>()(key);
+const metadata_response_partition& rr_partitioner::get_partition(const partitioner_context& context,
+        std::optional<std::string_view> key, const kafka_array_t<metadata_response_partition>& partitions) {
+    if (key) {
+        auto hash_value = std::hash<std::string_view>()(*key);
         return partitions[hash_value % partitions->size()];
     }
     else {
-        return partitions[(counter++) % partitions->size()];
+        return available_from(context, partitions, (counter++) % partitions->size());
+    }
+}
+
+sticky_partitioner::sticky_partitioner(size_t batch_size, key_hashing hashing)
+        : _batch_size(batch_size), _hashing(hashing), _random(std::random_device()()) {}
+
+const metadata_response_partition& sticky_partitioner::get_partition(const partitioner_context& context,
+        std::optional<std::string_view> key, const kafka_array_t<metadata_response_partition>& partitions) {
+    if (key) {
+        // Same as toPositive() of the Java client.
+        auto hash_value = static_cast<uint32_t>(murmur2(*key)) & 0x7fffffff;
+        auto position = _hashing == key_hashing::CONSISTENT
+                ? jump_consistent_hash(hash_value, partitions->size())
+                : hash_value % partitions->size();
+        return partitions[position];
+    }
+
+    auto [it, inserted] = _sticky_partitions.try_emplace(context.topic);
+    auto& sticky = it->second;
+    // The number of partitions may have changed with the metadata.
+    if (inserted || sticky.produced_bytes >= _batch_size || sticky.position >= partitions->size()
+            || !context.state_of(partitions[sticky.position]).available) {
+        sticky.position = draw_partition(context, partitions);
+        sticky.produced_bytes = 0;
+    }
+    sticky.produced_bytes += context.record_size;
+    return partitions[sticky.position];
+}
+
+size_t sticky_partitioner::draw_partition(const partitioner_context& context,
+        const kafka_array_t<metadata_response_partition>& partitions) {
+    std::vector<partition_state> states;
+    states.reserve(partitions->size());
+    double min_latency_ms = std::numeric_limits<double>::max();
+    for (const auto& partition : *partitions) {
+        states.push_back(context.state_of(partition));
+        if (states.back().available) {
+            min_latency_ms = std::min(min_latency_ms, states.back().latency_ms);
+        }
+    }
+
+    // With none of the partitions available, the records are
+    // spread over all of them until the metadata changes.
+    auto max_latency_ms = std::max(OVERLOADED_LATENCY_FACTOR * min_latency_ms, MIN_OVERLOADED_LATENCY_MS);
+    std::vector<bool> candidates(states.size());
+    for (size_t i = 0; i < states.size(); i++) {
+        candidates[i] = states[i].available && states[i].latency_ms <= max_latency_ms;
     }
+    if (std::find(candidates.begin(), candidates.end(), true) == candidates.end()) {
+        candidates.assign(states.size(), true);
+    }
+
+    // The odds of a candidate are the depth of the most loaded one less
+    // its own, plus one, so that all are drawn evenly when the depths are.
+    size_t max_depth = 0;
+    for (size_t i = 0; i < states.size(); i++) {
+        if (candidates[i]) {
+            max_depth = std::max(max_depth, states[i].queue_depth);
+        }
+    }
+    std::vector<size_t> cumulative_odds;
+    cumulative_odds.reserve(states.size());
+    size_t total_odds = 0;
+    for (size_t i = 0; i < states.size(); i++) {
+        if (candidates[i]) {
+            total_odds += max_depth - states[i].queue_depth + 1;
+        }
+        cumulative_odds.push_back(total_odds);
+    }
+
+    auto draw = std::uniform_int_distribution<size_t>(0, total_odds - 1)(_random);
+    return std::upper_bound(cumulative_odds.begin(), cumulative_odds.end(), draw) - cumulative_odds.begin();
 }
 
-}
\ No newline at end of file
+}
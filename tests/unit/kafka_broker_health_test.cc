@@ -0,0 +1,83 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2019 ScyllaDB
+ */
+
+#define BOOST_TEST_MODULE kafka
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <kafka4seastar/connection/broker_health.hh>
+
+using namespace std::chrono_literals;
+namespace k4s = kafka4seastar;
+
+using circuit_state = k4s::broker_health::circuit_state;
+
+BOOST_AUTO_TEST_CASE(kafka_broker_health_circuit_test) {
+    k4s::broker_health health(3, 1000ms);
+    k4s::broker_health::clock::time_point now;
+
+    BOOST_REQUIRE(health.allow_request(now));
+    health.record_failure(now);
+    health.record_failure(now);
+    BOOST_REQUIRE(health.state() == circuit_state::CLOSED);
+    BOOST_REQUIRE(health.allow_request(now));
+
+    health.record_failure(now);
+    BOOST_REQUIRE(health.state() == circuit_state::OPEN);
+    BOOST_REQUIRE(!health.healthy());
+    BOOST_REQUIRE(!health.allow_request(now + 500ms));
+
+    // A single probe is let through.
+    BOOST_REQUIRE(health.allow_request(now + 1000ms));
+    BOOST_REQUIRE(health.state() == circuit_state::HALF_OPEN);
+    BOOST_REQUIRE(!health.allow_request(now + 1000ms));
+
+    // Failed probe opens the circuit again.
+    health.record_failure(now + 1100ms);
+    BOOST_REQUIRE(health.state() == circuit_state::OPEN);
+    BOOST_REQUIRE(!health.allow_request(now + 2000ms));
+
+    BOOST_REQUIRE(health.allow_request(now + 2100ms));
+    health.record_success(10ms);
+    BOOST_REQUIRE(health.state() == circuit_state::CLOSED);
+    BOOST_REQUIRE(health.allow_request(now + 2100ms));
+}
+
+BOOST_AUTO_TEST_CASE(kafka_broker_health_ewma_test) {
+    k4s::broker_health health(100, 1000ms);
+
+    health.record_success(10ms);
+    BOOST_REQUIRE_CLOSE(health.latency_ms(), 10.0, 0.01);
+    health.record_success(60ms);
+    BOOST_REQUIRE_CLOSE(health.latency_ms(), 20.0, 0.01);
+    BOOST_REQUIRE(health.healthy());
+
+    // Failures interleaved with successes don't open the circuit, but make the broker unhealthy.
+    k4s::broker_health::clock::time_point now;
+    for (int i = 0; i < 10; i++) {
+        health.record_failure(now);
+        health.record_failure(now);
+        health.record_success(10ms);
+    }
+    BOOST_REQUIRE(health.state() == circuit_state::CLOSED);
+    BOOST_REQUIRE_GT(health.error_rate(), 0.5);
+    BOOST_REQUIRE(!health.healthy());
+}
@@ -0,0 +1,130 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (C) 2019 ScyllaDB Ltd.
+ */
+
+#include <seastar/testing/thread_test_case.hh>
+#include <seastar/testing/test_runner.hh>
+#include <seastar/core/sleep.hh>
+#include <kafka4seastar/connection/dns_cache.hh>
+
+using namespace seastar;
+namespace k4s = kafka4seastar;
+
+using addresses = std::vector<net::inet_address>;
+
+constexpr auto LONG_TTL = std::chrono::milliseconds(60000);
+constexpr auto SHORT_TTL = std::chrono::milliseconds(50);
+// Longer than SHORT_TTL by more than the lowres_clock granularity.
+constexpr auto PAST_SHORT_TTL = std::chrono::milliseconds(150);
+
+SEASTAR_THREAD_TEST_CASE(kafka_dns_cache_coalesces_resolutions_test) {
+    size_t calls = 0;
+    promise<addresses> resolved;
+    k4s::dns_cache cache([&] (const sstring& host) {
+        ++calls;
+        return resolved.get_future();
+    });
+
+    auto first = cache.resolve("broker", LONG_TTL, LONG_TTL);
+    auto second = cache.resolve("broker", LONG_TTL, LONG_TTL);
+    resolved.set_value(addresses{net::inet_address("127.0.0.1")});
+
+    BOOST_REQUIRE_EQUAL(first.get0().size(), 1);
+    BOOST_REQUIRE_EQUAL(second.get0().size(), 1);
+    BOOST_REQUIRE_EQUAL(calls, 1);
+}
+
+SEASTAR_THREAD_TEST_CASE(kafka_dns_cache_ttl_test) {
+    size_t calls = 0;
+    k4s::dns_cache cache([&] (const sstring& host) {
+        ++calls;
+        return make_ready_future<addresses>(addresses{net::inet_address("127.0.0.1")});
+    });
+
+    cache.resolve("broker", SHORT_TTL, SHORT_TTL).get();
+    cache.resolve("broker", SHORT_TTL, SHORT_TTL).get();
+    BOOST_REQUIRE_EQUAL(calls, 1);
+
+    // Other hosts are cached separately.
+    cache.resolve("other", SHORT_TTL, SHORT_TTL).get();
+    BOOST_REQUIRE_EQUAL(calls, 2);
+
+    seastar::sleep(PAST_SHORT_TTL).get();
+    cache.resolve("broker", SHORT_TTL, SHORT_TTL).get();
+    BOOST_REQUIRE_EQUAL(calls, 3);
+}
+
+SEASTAR_THREAD_TEST_CASE(kafka_dns_cache_negative_ttl_test) {
+    size_t calls = 0;
+    k4s::dns_cache cache([&] (const sstring& host) {
+        ++calls;
+        return make_exception_future<addresses>(std::runtime_error("resolution failed"));
+    });
+
+    BOOST_REQUIRE_THROW(cache.resolve("broker", LONG_TTL, SHORT_TTL).get(), std::runtime_error);
+    BOOST_REQUIRE_THROW(cache.resolve("broker", LONG_TTL, SHORT_TTL).get(), std::runtime_error);
+    BOOST_REQUIRE_EQUAL(calls, 1);
+
+    seastar::sleep(PAST_SHORT_TTL).get();
+    BOOST_REQUIRE_THROW(cache.resolve("broker", LONG_TTL, SHORT_TTL).get(), std::runtime_error);
+    BOOST_REQUIRE_EQUAL(calls, 2);
+}
+
+SEASTAR_THREAD_TEST_CASE(kafka_dns_cache_no_addresses_test) {
+    size_t calls = 0;
+    k4s::dns_cache cache([&] (const sstring& host) {
+        ++calls;
+        return make_ready_future<addresses>();
+    });
+
+    // A host without addresses is cached as a failed resolution.
+    BOOST_REQUIRE_THROW(cache.resolve("broker", LONG_TTL, LONG_TTL).get(), std::exception);
+    BOOST_REQUIRE_THROW(cache.resolve("broker", LONG_TTL, LONG_TTL).get(), std::exception);
+    BOOST_REQUIRE_EQUAL(calls, 1);
+}
+
+SEASTAR_THREAD_TEST_CASE(kafka_dns_cache_expire_within_test) {
+    size_t calls = 0;
+    k4s::dns_cache cache([&] (const sstring& host) {
+        ++calls;
+        return make_ready_future<addresses>(addresses{net::inet_address("127.0.0.1")});
+    });
+
+    cache.resolve("broker", LONG_TTL, SHORT_TTL).get();
+    cache.expire_within("broker", SHORT_TTL);
+
+    // Failing to connect doesn't make the next attempt resolve again right away...
+    cache.resolve("broker", LONG_TTL, SHORT_TTL).get();
+    BOOST_REQUIRE_EQUAL(calls, 1);
+
+    // ...but the addresses are refreshed soon after.
+    seastar::sleep(PAST_SHORT_TTL).get();
+    cache.resolve("broker", LONG_TTL, SHORT_TTL).get();
+    BOOST_REQUIRE_EQUAL(calls, 2);
+
+    // An expiry further away than the current one doesn't extend it.
+    cache.expire_within("broker", LONG_TTL);
+    cache.expire_within("broker", SHORT_TTL);
+    cache.expire_within("broker", LONG_TTL);
+    seastar::sleep(PAST_SHORT_TTL).get();
+    cache.resolve("broker", LONG_TTL, SHORT_TTL).get();
+    BOOST_REQUIRE_EQUAL(calls, 3);
+}
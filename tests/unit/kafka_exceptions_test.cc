@@ -0,0 +1,61 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2019 ScyllaDB
+ */
+
+
+#define BOOST_TEST_MODULE kafka
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <kafka4seastar/utils/exceptions.hh>
+
+#include <stdexcept>
+
+namespace k4s = kafka4seastar;
+
+namespace {
+
+struct derived_exception : public std::runtime_error {
+    explicit derived_exception(int code) : runtime_error("derived"), code(code) {}
+    int code;
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(kafka_try_catch_matches_type_test) {
+    auto ep = std::make_exception_ptr(derived_exception(42));
+    auto exception = k4s::try_catch<derived_exception>(ep);
+    BOOST_REQUIRE(exception);
+    BOOST_REQUIRE_EQUAL(exception->code, 42);
+}
+
+BOOST_AUTO_TEST_CASE(kafka_try_catch_matches_base_test) {
+    auto ep = std::make_exception_ptr(derived_exception(42));
+    BOOST_REQUIRE(k4s::try_catch<std::runtime_error>(ep));
+    BOOST_REQUIRE(k4s::try_catch<std::exception>(ep));
+    BOOST_REQUIRE_EQUAL(k4s::try_catch<std::exception>(ep)->what(), std::string("derived"));
+}
+
+BOOST_AUTO_TEST_CASE(kafka_try_catch_mismatch_test) {
+    auto ep = std::make_exception_ptr(derived_exception(42));
+    BOOST_REQUIRE(!k4s::try_catch<std::logic_error>(ep));
+    BOOST_REQUIRE(!k4s::try_catch<int>(ep));
+    BOOST_REQUIRE(!k4s::try_catch<std::exception>(std::exception_ptr()));
+}
@@ -0,0 +1,170 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2019 ScyllaDB
+ */
+
+#define BOOST_TEST_MODULE kafka
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <kafka4seastar/consumer/fetch_session.hh>
+
+using namespace seastar;
+namespace k4s = kafka4seastar;
+
+static size_t count_partitions(const k4s::fetch_request& request) {
+    size_t count = 0;
+    for (const auto& topic : *request.topics) {
+        count += topic.partitions->size();
+    }
+    return count;
+}
+
+static k4s::fetch_response session_response(int32_t session_id) {
+    k4s::fetch_response response;
+    response.session_id = session_id;
+    response.topics = std::vector<k4s::fetch_response_topic>();
+    return response;
+}
+
+BOOST_AUTO_TEST_CASE(kafka_fetch_session_incremental_test) {
+    k4s::fetch_session session;
+    k4s::fetch_session::partitions partitions {
+            {{"a", 0}, {10, 1024}},
+            {{"a", 1}, {20, 1024}},
+            {{"b", 0}, {30, 1024}}
+    };
+
+    auto request = session.build_request(partitions);
+    BOOST_REQUIRE_EQUAL(*request.session_id, k4s::fetch_session::INVALID_SESSION_ID);
+    BOOST_REQUIRE_EQUAL(*request.session_epoch, k4s::fetch_session::INITIAL_EPOCH);
+    BOOST_REQUIRE_EQUAL(request.topics->size(), 2);
+    BOOST_REQUIRE_EQUAL(count_partitions(request), 3);
+    BOOST_REQUIRE(request.forgotten_topics->empty());
+
+    BOOST_REQUIRE(session.handle_response(session_response(7)));
+    BOOST_REQUIRE(session.is_incremental());
+
+    // Nothing changed, nothing has to be sent.
+    request = session.build_request(partitions);
+    BOOST_REQUIRE_EQUAL(*request.session_id, 7);
+    BOOST_REQUIRE_EQUAL(*request.session_epoch, 1);
+    BOOST_REQUIRE(request.topics->empty());
+    BOOST_REQUIRE(session.handle_response(session_response(7)));
+
+    partitions[{"a", 1}].fetch_offset = 25;
+    partitions.erase({"b", 0});
+    partitions[{"c", 0}] = {0, 1024};
+    request = session.build_request(partitions);
+    BOOST_REQUIRE_EQUAL(*request.session_epoch, 2);
+    BOOST_REQUIRE_EQUAL(count_partitions(request), 2);
+    BOOST_REQUIRE_EQUAL(*request.topics[0].name, "a");
+    BOOST_REQUIRE_EQUAL(*request.topics[0].partitions[0].partition_index, 1);
+    BOOST_REQUIRE_EQUAL(*request.topics[0].partitions[0].fetch_offset, 25);
+    BOOST_REQUIRE_EQUAL(*request.topics[1].name, "c");
+    BOOST_REQUIRE_EQUAL(request.forgotten_topics->size(), 1);
+    BOOST_REQUIRE_EQUAL(*request.forgotten_topics[0].name, "b");
+    BOOST_REQUIRE_EQUAL(*request.forgotten_topics[0].partitions[0], 0);
+    BOOST_REQUIRE(session.handle_response(session_response(7)));
+
+    request = session.build_request(partitions);
+    BOOST_REQUIRE_EQUAL(*request.session_epoch, 3);
+    BOOST_REQUIRE(request.topics->empty());
+    BOOST_REQUIRE(request.forgotten_topics->empty());
+}
+
+BOOST_AUTO_TEST_CASE(kafka_fetch_session_error_test) {
+    k4s::fetch_session session;
+    k4s::fetch_session::partitions partitions {
+            {{"a", 0}, {10, 1024}},
+            {{"a", 1}, {20, 1024}}
+    };
+
+    session.build_request(partitions);
+    BOOST_REQUIRE(session.handle_response(session_response(7)));
+    session.build_request(partitions);
+
+    auto response = session_response(0);
+    response.error_code = k4s::error::kafka_error_code::FETCH_SESSION_ID_NOT_FOUND;
+    BOOST_REQUIRE(!session.handle_response(response));
+    BOOST_REQUIRE(!session.is_incremental());
+
+    auto request = session.build_request(partitions);
+    BOOST_REQUIRE_EQUAL(*request.session_id, k4s::fetch_session::INVALID_SESSION_ID);
+    BOOST_REQUIRE_EQUAL(*request.session_epoch, k4s::fetch_session::INITIAL_EPOCH);
+    BOOST_REQUIRE_EQUAL(count_partitions(request), 2);
+}
+
+BOOST_AUTO_TEST_CASE(kafka_fetch_session_not_created_test) {
+    k4s::fetch_session session;
+    k4s::fetch_session::partitions partitions {
+            {{"a", 0}, {10, 1024}}
+    };
+
+    // Brokers without fetch sessions always respond with session id 0.
+    session.build_request(partitions);
+    BOOST_REQUIRE(session.handle_response(session_response(0)));
+    BOOST_REQUIRE(!session.is_incremental());
+
+    auto request = session.build_request(partitions);
+    BOOST_REQUIRE_EQUAL(*request.session_epoch, k4s::fetch_session::INITIAL_EPOCH);
+    BOOST_REQUIRE_EQUAL(count_partitions(request), 1);
+}
+
+BOOST_AUTO_TEST_CASE(kafka_fetch_session_held_partition_test) {
+    k4s::fetch_session session;
+    k4s::fetch_session::partitions partitions {
+            {{"a", 0}, {10, 1024}},
+            {{"a", 1}, {20, 1024}}
+    };
+
+    session.build_request(partitions);
+    BOOST_REQUIRE(session.handle_response(session_response(7)));
+
+    // A paused partition stays in the session, only its max_bytes changes.
+    partitions[{"a", 1}].max_bytes = 0;
+    auto request = session.build_request(partitions);
+    BOOST_REQUIRE_EQUAL(count_partitions(request), 1);
+    BOOST_REQUIRE_EQUAL(*request.topics[0].partitions[0].partition_index, 1);
+    BOOST_REQUIRE_EQUAL(*request.topics[0].partitions[0].partition_max_bytes, 0);
+    BOOST_REQUIRE(request.forgotten_topics->empty());
+    BOOST_REQUIRE(session.handle_response(session_response(7)));
+
+    request = session.build_request(partitions);
+    BOOST_REQUIRE(request.topics->empty());
+    BOOST_REQUIRE(request.forgotten_topics->empty());
+}
+
+BOOST_AUTO_TEST_CASE(kafka_fetch_session_close_test) {
+    k4s::fetch_session session;
+    k4s::fetch_session::partitions partitions {
+            {{"a", 0}, {10, 1024}}
+    };
+
+    session.build_request(partitions);
+    BOOST_REQUIRE(session.handle_response(session_response(7)));
+
+    auto request = session.close_request();
+    BOOST_REQUIRE_EQUAL(*request.session_id, 7);
+    BOOST_REQUIRE_EQUAL(*request.session_epoch, k4s::fetch_session::FINAL_EPOCH);
+    BOOST_REQUIRE(request.topics->empty());
+    BOOST_REQUIRE(request.forgotten_topics->empty());
+    BOOST_REQUIRE_EQUAL(session.session_id(), k4s::fetch_session::INVALID_SESSION_ID);
+    BOOST_REQUIRE(!session.is_incremental());
+}
@@ -0,0 +1,116 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2019 ScyllaDB
+ */
+
+#define BOOST_TEST_MODULE kafka
+
+#include <algorithm>
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <kafka4seastar/consumer/partition_assignor.hh>
+
+using namespace seastar;
+namespace k4s = kafka4seastar;
+
+static size_t count_assigned(const k4s::partition_assignor::assignment& assignment) {
+    size_t count = 0;
+    for (const auto& [member, partitions] : assignment) {
+        count += partitions.size();
+    }
+    return count;
+}
+
+static std::vector<k4s::topic_partition> assigned_to(const k4s::partition_assignor::assignment& assignment,
+        const sstring& member) {
+    auto it = assignment.find(member);
+    return it == assignment.end() ? std::vector<k4s::topic_partition>() : it->second;
+}
+
+BOOST_AUTO_TEST_CASE(kafka_cooperative_sticky_assignor_initial_test) {
+    k4s::cooperative_sticky_assignor assignor;
+    std::map<sstring, k4s::member_subscription> subscriptions {
+            {"a", {{"test"}, {}}},
+            {"b", {{"test"}, {}}},
+            {"c", {{"test"}, {}}}
+    };
+
+    auto assignment = assignor.assign(subscriptions, {{"test", 7}});
+
+    BOOST_REQUIRE_EQUAL(assignment.size(), 3);
+    BOOST_REQUIRE_EQUAL(count_assigned(assignment), 7);
+    for (const auto& [member, partitions] : assignment) {
+        BOOST_REQUIRE(partitions.size() == 2 || partitions.size() == 3);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(kafka_cooperative_sticky_assignor_member_joined_test) {
+    k4s::cooperative_sticky_assignor assignor;
+    std::map<sstring, k4s::member_subscription> subscriptions {
+            {"a", {{"test"}, {}}},
+            {"b", {{"test"}, {}}}
+    };
+    std::map<sstring, int32_t> partitions_per_topic {{"test", 6}};
+
+    auto first = assignor.assign(subscriptions, partitions_per_topic);
+    BOOST_REQUIRE_EQUAL(assigned_to(first, "a").size(), 3);
+    BOOST_REQUIRE_EQUAL(assigned_to(first, "b").size(), 3);
+
+    // The new member gets nothing until the partitions
+    // moving to it are revoked by their previous owners.
+    subscriptions["a"].owned_partitions = assigned_to(first, "a");
+    subscriptions["b"].owned_partitions = assigned_to(first, "b");
+    subscriptions["c"] = {{"test"}, {}};
+    auto second = assignor.assign(subscriptions, partitions_per_topic);
+
+    BOOST_REQUIRE_EQUAL(assigned_to(second, "a").size(), 2);
+    BOOST_REQUIRE_EQUAL(assigned_to(second, "b").size(), 2);
+    BOOST_REQUIRE_EQUAL(assigned_to(second, "c").size(), 0);
+    for (const auto& partition : assigned_to(second, "a")) {
+        auto owned = assigned_to(first, "a");
+        BOOST_REQUIRE(std::find(owned.begin(), owned.end(), partition) != owned.end());
+    }
+
+    subscriptions["a"].owned_partitions = assigned_to(second, "a");
+    subscriptions["b"].owned_partitions = assigned_to(second, "b");
+    auto third = assignor.assign(subscriptions, partitions_per_topic);
+
+    BOOST_REQUIRE(assigned_to(third, "a") == assigned_to(second, "a"));
+    BOOST_REQUIRE(assigned_to(third, "b") == assigned_to(second, "b"));
+    BOOST_REQUIRE_EQUAL(assigned_to(third, "c").size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(kafka_cooperative_sticky_assignor_member_left_test) {
+    k4s::cooperative_sticky_assignor assignor;
+    std::map<sstring, k4s::member_subscription> subscriptions {
+            {"a", {{"test"}, {{"test", 0}, {"test", 1}}}},
+            {"b", {{"test"}, {{"test", 2}, {"test", 3}}}}
+    };
+
+    auto assignment = assignor.assign(subscriptions, {{"test", 4}, {"other", 2}});
+    BOOST_REQUIRE_EQUAL(assigned_to(assignment, "a").size(), 2);
+
+    subscriptions.erase("b");
+    assignment = assignor.assign(subscriptions, {{"test", 4}, {"other", 2}});
+
+    // Partitions of topics nobody subscribes to are left out.
+    BOOST_REQUIRE_EQUAL(assignment.size(), 1);
+    BOOST_REQUIRE_EQUAL(assigned_to(assignment, "a").size(), 4);
+}
@@ -0,0 +1,210 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2019 ScyllaDB
+ */
+
+#define BOOST_TEST_MODULE kafka
+
+#include <map>
+#include <set>
+#include <string>
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <kafka4seastar/utils/partitioner.hh>
+
+using namespace seastar;
+namespace k4s = kafka4seastar;
+
+static k4s::kafka_array_t<k4s::metadata_response_partition> make_partitions(int32_t count) {
+    std::vector<k4s::metadata_response_partition> partitions(count);
+    for (int32_t i = 0; i < count; i++) {
+        partitions[i].partition_index = i;
+        // Every partition is led by a different broker.
+        partitions[i].leader_id = i;
+    }
+    return k4s::kafka_array_t<k4s::metadata_response_partition>(std::move(partitions));
+}
+
+// Partitions are available unless given otherwise, states are looked up by the leader.
+static k4s::partitioner_context make_context(const sstring& topic, size_t record_size,
+        std::map<int32_t, k4s::partition_state> states = {}) {
+    return k4s::partitioner_context{topic, record_size,
+            [states = std::move(states)] (const k4s::metadata_response_partition& partition) {
+        auto it = states.find(*partition.leader_id);
+        if (it != states.end()) {
+            return it->second;
+        }
+        k4s::partition_state state;
+        state.available = true;
+        state.leader_id = *partition.leader_id;
+        return state;
+    }};
+}
+
+static k4s::partition_state make_state(bool available, size_t queue_depth = 0, double latency_ms = 0) {
+    k4s::partition_state state;
+    state.available = available;
+    state.queue_depth = queue_depth;
+    state.latency_ms = latency_ms;
+    return state;
+}
+
+BOOST_AUTO_TEST_CASE(kafka_sticky_partitioner_sticks_for_batch_test) {
+    k4s::sticky_partitioner partitioner(1000);
+    auto partitions = make_partitions(8);
+    sstring topic = "test";
+    auto context = make_context(topic, 100);
+
+    auto first = *partitioner.get_partition(context, std::nullopt, partitions).partition_index;
+    for (int i = 1; i < 10; i++) {
+        BOOST_REQUIRE_EQUAL(*partitioner.get_partition(context, std::nullopt, partitions).partition_index, first);
+    }
+
+    // A full batch makes the partitioner draw again, the switches
+    // spread the records over all the partitions eventually.
+    std::set<int32_t> used;
+    for (int i = 0; i < 1000; i++) {
+        used.insert(*partitioner.get_partition(context, std::nullopt, partitions).partition_index);
+    }
+    BOOST_REQUIRE_EQUAL(used.size(), 8);
+}
+
+BOOST_AUTO_TEST_CASE(kafka_sticky_partitioner_keys_test) {
+    k4s::sticky_partitioner partitioner(1000);
+    auto partitions = make_partitions(8);
+    sstring topic = "test";
+    auto context = make_context(topic, 1000);
+
+    auto partition = *partitioner.get_partition(context, "key", partitions).partition_index;
+    for (int i = 0; i < 10; i++) {
+        BOOST_REQUIRE_EQUAL(*partitioner.get_partition(context, "key", partitions).partition_index, partition);
+    }
+
+    // Partitions the DefaultPartitioner of the Java client picks.
+    BOOST_REQUIRE_EQUAL(*partitioner.get_partition(context, "foobar", partitions).partition_index,
+            (-790332482 & 0x7fffffff) % 8);
+    BOOST_REQUIRE_EQUAL(*partitioner.get_partition(context, "21", partitions).partition_index,
+            (-973932308 & 0x7fffffff) % 8);
+    // An empty key is a key, hashed like any other.
+    BOOST_REQUIRE_EQUAL(*partitioner.get_partition(context, "", partitions).partition_index,
+            (k4s::murmur2("") & 0x7fffffff) % 8);
+}
+
+BOOST_AUTO_TEST_CASE(kafka_murmur2_test) {
+    // Values computed by Utils.murmur2() of the Java client.
+    BOOST_REQUIRE_EQUAL(k4s::murmur2("21"), -973932308);
+    BOOST_REQUIRE_EQUAL(k4s::murmur2("foobar"), -790332482);
+    BOOST_REQUIRE_EQUAL(k4s::murmur2("a-little-bit-long-string"), -985981536);
+    BOOST_REQUIRE_EQUAL(k4s::murmur2("a-little-bit-longer-string"), -1486304829);
+    BOOST_REQUIRE_EQUAL(k4s::murmur2("lkjh234lh9fiuh90y23oiuhsafujhadof229phr9h19h89h8"), -58897971);
+    BOOST_REQUIRE_EQUAL(k4s::murmur2("abc"), 479470107);
+}
+
+BOOST_AUTO_TEST_CASE(kafka_consistent_hashing_test) {
+    k4s::sticky_partitioner partitioner(1000, k4s::key_hashing::CONSISTENT);
+    sstring topic = "test";
+    auto context = make_context(topic, 1);
+    auto before = make_partitions(10);
+    auto after = make_partitions(11);
+
+    // Growing by one partition moves about 1/11 of the keys, all to the new partition.
+    size_t moved = 0;
+    for (int i = 0; i < 1000; i++) {
+        auto key = std::to_string(i);
+        auto old_partition = *partitioner.get_partition(context, std::string_view(key), before).partition_index;
+        auto new_partition = *partitioner.get_partition(context, std::string_view(key), after).partition_index;
+        if (old_partition != new_partition) {
+            BOOST_REQUIRE_EQUAL(new_partition, 10);
+            moved++;
+        }
+    }
+    BOOST_REQUIRE_LT(moved, 200);
+}
+
+BOOST_AUTO_TEST_CASE(kafka_sticky_partitioner_avoids_loaded_brokers_test) {
+    k4s::sticky_partitioner partitioner(1);
+    auto partitions = make_partitions(2);
+    sstring topic = "test";
+    auto context = make_context(topic, 1, {{0, make_state(true, 0)}, {1, make_state(true, 99)}});
+
+    // Odds of the partitions are 100 to 1.
+    size_t loaded = 0;
+    for (int i = 0; i < 1000; i++) {
+        loaded += *partitioner.get_partition(context, std::nullopt, partitions).partition_index == 1;
+    }
+    BOOST_REQUIRE_LT(loaded, 50);
+}
+
+BOOST_AUTO_TEST_CASE(kafka_sticky_partitioner_partition_count_change_test) {
+    k4s::sticky_partitioner partitioner(1000000);
+    sstring topic = "test";
+    auto context = make_context(topic, 1);
+
+    auto many = make_partitions(64);
+    auto few = make_partitions(1);
+    partitioner.get_partition(context, std::nullopt, many);
+    BOOST_REQUIRE_EQUAL(*partitioner.get_partition(context, std::nullopt, few).partition_index, 0);
+}
+
+BOOST_AUTO_TEST_CASE(kafka_sticky_partitioner_avoids_unavailable_test) {
+    k4s::sticky_partitioner partitioner(1);
+    auto partitions = make_partitions(4);
+    sstring topic = "test";
+    // The leader of partition 1 is down, the one of partition 2 is overloaded.
+    auto context = make_context(topic, 1, {{1, make_state(false)}, {2, make_state(true, 0, 1000)},
+            {3, make_state(true, 0, 20)}});
+
+    for (int i = 0; i < 1000; i++) {
+        auto partition = *partitioner.get_partition(context, std::nullopt, partitions).partition_index;
+        BOOST_REQUIRE(partition == 0 || partition == 3);
+    }
+
+    // Records with a key keep going to their partition.
+    auto keyed = *partitioner.get_partition(context, "foobar", partitions).partition_index;
+    BOOST_REQUIRE_EQUAL(keyed, (-790332482 & 0x7fffffff) % 4);
+}
+
+BOOST_AUTO_TEST_CASE(kafka_sticky_partitioner_leaves_unavailable_test) {
+    k4s::sticky_partitioner partitioner(1000000);
+    auto partitions = make_partitions(2);
+    sstring topic = "test";
+
+    auto first = *partitioner.get_partition(make_context(topic, 1), std::nullopt, partitions).partition_index;
+    auto context = make_context(topic, 1, {{first, make_state(false)}});
+    BOOST_REQUIRE_EQUAL(*partitioner.get_partition(context, std::nullopt, partitions).partition_index, 1 - first);
+
+    // With none available, the records still go somewhere.
+    auto down = make_context(topic, 1, {{0, make_state(false)}, {1, make_state(false)}});
+    auto partition = *partitioner.get_partition(down, std::nullopt, partitions).partition_index;
+    BOOST_REQUIRE(partition == 0 || partition == 1);
+}
+
+BOOST_AUTO_TEST_CASE(kafka_rr_partitioner_skips_unavailable_test) {
+    k4s::rr_partitioner partitioner;
+    auto partitions = make_partitions(3);
+    sstring topic = "test";
+    auto context = make_context(topic, 1, {{1, make_state(false)}});
+
+    std::vector<int32_t> chosen;
+    for (int i = 0; i < 3; i++) {
+        chosen.push_back(*partitioner.get_partition(context, std::nullopt, partitions).partition_index);
+    }
+    BOOST_REQUIRE(chosen == std::vector<int32_t>({0, 2, 2}));
+}
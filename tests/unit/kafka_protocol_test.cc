@@ -30,11 +30,21 @@
 #include <kafka4seastar/protocol/metadata_request.hh>
 #include <kafka4seastar/protocol/metadata_response.hh>
 #include <kafka4seastar/protocol/kafka_primitives.hh>
+#include <kafka4seastar/protocol/kafka_buffer_istream.hh>
 #include <kafka4seastar/protocol/api_versions_response.hh>
 #include <kafka4seastar/protocol/kafka_records.hh>
+#include <kafka4seastar/protocol/kafka_records_view.hh>
+#include <kafka4seastar/protocol/kafka_varint.hh>
 #include <kafka4seastar/protocol/produce_request.hh>
 #include <kafka4seastar/protocol/produce_response.hh>
 #include <kafka4seastar/protocol/headers.hh>
+#include <kafka4seastar/protocol/find_coordinator_response.hh>
+#include <kafka4seastar/protocol/heartbeat_request.hh>
+#include <kafka4seastar/protocol/leave_group_request.hh>
+#include <kafka4seastar/protocol/join_group_response.hh>
+#include <kafka4seastar/protocol/consumer_protocol.hh>
+#include <kafka4seastar/protocol/fetch_response.hh>
+#include <kafka4seastar/protocol/offset_fetch_response.hh>
 #include <kafka4seastar/protocol/kafka_error_code.hh>
 
 using namespace seastar;
@@ -69,6 +79,20 @@ void test_deserialize_throw(std::vector<unsigned char> data,
     BOOST_REQUIRE_THROW(kafka_value.deserialize(input_stream, api_version), k4s::parsing_exception);
 }
 
+// Serializes the wrapped value with compact lengths, as in flexible versions.
+template <typename KafkaType>
+struct compact {
+    KafkaType& value;
+
+    void serialize(std::ostream& os, int16_t api_version) const {
+        value.serialize(os, api_version, true);
+    }
+
+    void deserialize(std::istream& is, int16_t api_version) {
+        value.deserialize(is, api_version, true);
+    }
+};
+
 BOOST_AUTO_TEST_CASE(kafka_primitives_number_test) {
     k4s::kafka_number_t<uint32_t> number(15);
     BOOST_REQUIRE_EQUAL(*number, 15);
@@ -94,6 +118,7 @@ BOOST_AUTO_TEST_CASE(kafka_primitives_varint_test) {
 
     test_deserialize_serialize({0xAC, 0x02}, number, 0);
     BOOST_REQUIRE_EQUAL(*number, 150);
+    BOOST_REQUIRE_EQUAL(number.serialized_size(0), 2);
 
     test_deserialize_serialize({0xAB, 0x02}, number, 0);
     BOOST_REQUIRE_EQUAL(*number, -150);
@@ -103,6 +128,7 @@ BOOST_AUTO_TEST_CASE(kafka_primitives_varint_test) {
 
     test_deserialize_serialize({0xFF, 0xFF, 0xFF, 0xFF, 0xF}, number, 0);
     BOOST_REQUIRE_EQUAL(*number, -2147483648);
+    BOOST_REQUIRE_EQUAL(number.serialized_size(0), 5);
 
     test_deserialize_throw({0xFF, 0xFF, 0xFF, 0xFF, 0x1F}, number, 0);
     BOOST_REQUIRE_EQUAL(*number, -2147483648);
@@ -159,6 +185,206 @@ BOOST_AUTO_TEST_CASE(kafka_primitives_array_test) {
     BOOST_REQUIRE_EQUAL(*strings[1], "fg");
 }
 
+BOOST_AUTO_TEST_CASE(kafka_primitives_unsigned_varint_test) {
+    k4s::kafka_unsigned_varint_t number;
+
+    test_deserialize_serialize({0x00}, number, 0);
+    BOOST_REQUIRE_EQUAL(*number, 0);
+
+    test_deserialize_serialize({0xAC, 0x02}, number, 0);
+    BOOST_REQUIRE_EQUAL(*number, 300);
+    BOOST_REQUIRE_EQUAL(number.serialized_size(0), 2);
+
+    test_deserialize_serialize({0xFF, 0xFF, 0xFF, 0xFF, 0x0F}, number, 0);
+    BOOST_REQUIRE_EQUAL(*number, 0xFFFFFFFF);
+
+    test_deserialize_throw({0xFF, 0xFF, 0xFF, 0xFF, 0x1F}, number, 0);
+    test_deserialize_throw({0xFF, 0xFF, 0xFF, 0xFF, 0x8F, 0x00}, number, 0);
+    test_deserialize_throw({0x80}, number, 0);
+}
+
+BOOST_AUTO_TEST_CASE(kafka_primitives_varlong_test) {
+    k4s::kafka_varlong_t number;
+
+    test_deserialize_serialize({0xAC, 0x02}, number, 0);
+    BOOST_REQUIRE_EQUAL(*number, 150);
+
+    test_deserialize_serialize({0x80, 0x80, 0x80, 0x80, 0x10}, number, 0);
+    BOOST_REQUIRE_EQUAL(*number, 0x80000000LL);
+    BOOST_REQUIRE_EQUAL(number.serialized_size(0), 5);
+
+    test_deserialize_serialize({0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01}, number, 0);
+    BOOST_REQUIRE_EQUAL(*number, std::numeric_limits<int64_t>::min());
+    BOOST_REQUIRE_EQUAL(number.serialized_size(0), 10);
+
+    test_deserialize_throw({0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x02}, number, 0);
+    test_deserialize_throw({0xFF, 0xFF}, number, 0);
+    BOOST_REQUIRE_EQUAL(*number, std::numeric_limits<int64_t>::min());
+}
+
+BOOST_AUTO_TEST_CASE(kafka_varint_codec_test) {
+    std::array<char, k4s::MAX_VARLONG_SIZE> buffer;
+
+    for (int64_t value : {0LL, 1LL, -1LL, 63LL, -64LL, 64LL, 8191LL, -8193LL, 1LL << 40,
+            static_cast<long long>(std::numeric_limits<int32_t>::min()),
+            static_cast<long long>(std::numeric_limits<int64_t>::max())}) {
+        auto end = k4s::encode_varlong(value, buffer.data());
+        BOOST_REQUIRE_EQUAL(end - buffer.data(), k4s::varlong_size(value));
+
+        const char* position = buffer.data();
+        int64_t decoded = 0;
+        BOOST_REQUIRE(k4s::decode_varlong(position, end, decoded));
+        BOOST_REQUIRE_EQUAL(decoded, value);
+        BOOST_REQUIRE(position == end);
+
+        // Truncated input is rejected without moving the position.
+        position = buffer.data();
+        BOOST_REQUIRE(!k4s::decode_varlong(position, end - 1, decoded));
+        BOOST_REQUIRE(position == buffer.data());
+    }
+
+    BOOST_REQUIRE_EQUAL(k4s::unsigned_varint_size(0), 1);
+    BOOST_REQUIRE_EQUAL(k4s::unsigned_varint_size(127), 1);
+    BOOST_REQUIRE_EQUAL(k4s::unsigned_varint_size(128), 2);
+    BOOST_REQUIRE_EQUAL(k4s::unsigned_varint_size(std::numeric_limits<uint64_t>::max()), 10);
+    BOOST_REQUIRE_EQUAL(k4s::varint_size(-64), 1);
+    BOOST_REQUIRE_EQUAL(k4s::varint_size(64), 2);
+
+    // A zero byte ends the value only when it comes without the continuation bit.
+    const char continued_zero[] = {static_cast<char>(0x80), 0x00, 0x05};
+    const char* position = continued_zero;
+    int32_t value = -1;
+    BOOST_REQUIRE(k4s::decode_varint(position, continued_zero + sizeof(continued_zero), value));
+    BOOST_REQUIRE_EQUAL(value, 0);
+    BOOST_REQUIRE(position == continued_zero + 2);
+
+    const char too_long[] = {static_cast<char>(0x80), static_cast<char>(0x80), static_cast<char>(0x80),
+            static_cast<char>(0x80), static_cast<char>(0x80), 0x00};
+    position = too_long;
+    BOOST_REQUIRE(!k4s::decode_varint(position, too_long + sizeof(too_long), value));
+    BOOST_REQUIRE(position == too_long);
+
+    // Bulk decoding takes the unchecked path only when all values surely fit.
+    std::vector<char> encoded(2 * k4s::MAX_VARLONG_SIZE);
+    auto end = k4s::encode_varlong(-3, encoded.data());
+    end = k4s::encode_varlong(300, end);
+    std::array<int64_t, 2> values;
+    for (auto buffer_end : {end, encoded.data() + encoded.size()}) {
+        const char* bulk_position = encoded.data();
+        BOOST_REQUIRE(k4s::decode_varlongs(bulk_position, buffer_end, values.data(), values.size()));
+        BOOST_REQUIRE_EQUAL(values[0], -3);
+        BOOST_REQUIRE_EQUAL(values[1], 300);
+        BOOST_REQUIRE(bulk_position == end);
+    }
+    const char* bulk_position = encoded.data();
+    BOOST_REQUIRE(!k4s::decode_varlongs(bulk_position, end - 1, values.data(), values.size()));
+    BOOST_REQUIRE(bulk_position == encoded.data());
+}
+
+BOOST_AUTO_TEST_CASE(kafka_primitives_decode_limits_test) {
+    // Lengths exceeding the remaining input fail before anything is allocated.
+    k4s::kafka_array_t<k4s::kafka_int32_t> array;
+    test_deserialize_throw({0x7F, 0xFF, 0xFF, 0xFF, 0, 0, 0, 1}, array, 0);
+    k4s::kafka_bytes_t bytes;
+    test_deserialize_throw({0x7F, 0xFF, 0xFF, 0xFF, 'a'}, bytes, 0);
+    k4s::kafka_nullable_bytes_t nullable_bytes;
+    test_deserialize_throw({0x7F, 0xFF, 0xFF, 0xFF, 'a'}, nullable_bytes, 0);
+    k4s::kafka_tagged_fields_t tagged_fields;
+    test_deserialize_throw({0x01, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0x0F}, tagged_fields, 0);
+
+    k4s::decode_limits limits;
+    limits.max_string_length = 2;
+    limits.max_array_length = 1;
+
+    std::vector<char> data{0, 3, 'a', 'b', 'c'};
+    boost::iostreams::stream<boost::iostreams::array_source> string_stream(data.data(), data.size());
+    limits.apply(string_stream);
+    k4s::kafka_string_t string;
+    BOOST_REQUIRE_THROW(string.deserialize(string_stream, 0), k4s::parsing_exception);
+
+    data = {0, 0, 0, 2, 0, 0, 0, 1, 0, 0, 0, 2};
+    boost::iostreams::stream<boost::iostreams::array_source> array_stream(data.data(), data.size());
+    limits.apply(array_stream);
+    BOOST_REQUIRE_THROW(array.deserialize(array_stream, 0), k4s::parsing_exception);
+
+    // Streams the limits were not applied to are checked against the input only.
+    test_deserialize_serialize({0, 0, 0, 2, 0, 0, 0, 1, 0, 0, 0, 2}, array, 0);
+    BOOST_REQUIRE_EQUAL(array->size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(kafka_buffer_istream_test) {
+    k4s::kafka_buffer_istream stream;
+    k4s::decode_limits limits;
+    limits.max_string_length = 3;
+    limits.apply(stream);
+
+    std::vector<char> data{0, 0, 0, 5, 0, 3, 'a', 'b', 'c'};
+    stream.reset(data.data(), data.size());
+    BOOST_REQUIRE_EQUAL(stream.rdbuf()->in_avail(), data.size());
+    k4s::kafka_int32_t number;
+    number.deserialize(stream, 0);
+    BOOST_REQUIRE_EQUAL(*number, 5);
+    BOOST_REQUIRE_EQUAL(stream.tellg(), 4);
+    stream.seekg(2, std::ios_base::cur);
+    BOOST_REQUIRE_EQUAL(stream.tellg(), 6);
+    stream.seekg(4);
+    k4s::kafka_string_t string;
+    string.deserialize(stream, 0);
+    BOOST_REQUIRE_EQUAL(*string, "abc");
+    stream.seekg(1, std::ios_base::cur);
+    BOOST_REQUIRE(!stream);
+
+    // The stream is reused for the next buffer, along with its limits.
+    data = {0, 4, 'a', 'b', 'c', 'd'};
+    stream.reset(data.data(), data.size());
+    BOOST_REQUIRE(stream);
+    BOOST_REQUIRE_THROW(string.deserialize(stream, 0), k4s::parsing_exception);
+}
+
+BOOST_AUTO_TEST_CASE(kafka_primitives_compact_test) {
+    k4s::kafka_string_t string;
+    compact<k4s::kafka_string_t> compact_string{string};
+    test_deserialize_serialize({4, 'a', 'b', 'c'}, compact_string, 0);
+    BOOST_REQUIRE_EQUAL(*string, "abc");
+    BOOST_REQUIRE_EQUAL(string.serialized_size(0, true), 4);
+    test_deserialize_throw({0}, compact_string, 0);
+    test_deserialize_throw({5, 'a', 'b', 'c'}, compact_string, 0);
+
+    k4s::kafka_nullable_string_t nullable_string;
+    compact<k4s::kafka_nullable_string_t> compact_nullable_string{nullable_string};
+    test_deserialize_serialize({0}, compact_nullable_string, 0);
+    BOOST_REQUIRE(nullable_string.is_null());
+    test_deserialize_serialize({1}, compact_nullable_string, 0);
+    BOOST_REQUIRE_EQUAL(*nullable_string, "");
+
+    k4s::kafka_array_t<k4s::kafka_string_t> strings;
+    compact<k4s::kafka_array_t<k4s::kafka_string_t>> compact_strings{strings};
+    test_deserialize_serialize({3, 6, 'a', 'b', 'c', 'd', 'e', 3, 'f', 'g'}, compact_strings, 0);
+    BOOST_REQUIRE_EQUAL(strings->size(), 2);
+    BOOST_REQUIRE_EQUAL(*strings[0], "abcde");
+    BOOST_REQUIRE_EQUAL(*strings[1], "fg");
+    BOOST_REQUIRE_EQUAL(strings.serialized_size(0, true), 10);
+    test_deserialize_serialize({0}, compact_strings, 0);
+    BOOST_REQUIRE(strings.is_null());
+}
+
+BOOST_AUTO_TEST_CASE(kafka_primitives_tagged_fields_test) {
+    k4s::kafka_tagged_fields_t tagged_fields;
+
+    test_deserialize_serialize({0x00}, tagged_fields, 0);
+    BOOST_REQUIRE((*tagged_fields).empty());
+
+    test_deserialize_serialize({0x02, 0x00, 0x02, 0xAA, 0xBB, 0x05, 0x00}, tagged_fields, 0);
+    BOOST_REQUIRE_EQUAL((*tagged_fields).size(), 2);
+    BOOST_REQUIRE_EQUAL((*tagged_fields)[0].first, 0);
+    BOOST_REQUIRE_EQUAL((*tagged_fields)[0].second, "\xAA\xBB");
+    BOOST_REQUIRE_EQUAL((*tagged_fields)[1].first, 5);
+    BOOST_REQUIRE_EQUAL(tagged_fields.serialized_size(0), 7);
+
+    test_deserialize_throw({0x02, 0x05, 0x00, 0x00, 0x00}, tagged_fields, 0);
+    test_deserialize_throw({0x01, 0x00, 0x03, 0xAA}, tagged_fields, 0);
+}
+
 
 BOOST_AUTO_TEST_CASE(kafka_request_header_parsing_test) {
     k4s::request_header header;
@@ -170,6 +396,15 @@ BOOST_AUTO_TEST_CASE(kafka_request_header_parsing_test) {
     BOOST_REQUIRE_EQUAL(*header.api_version, 1);
     BOOST_REQUIRE_EQUAL(*header.correlation_id, 0x42);
     BOOST_REQUIRE_EQUAL(*header.client_id, "abcde");
+
+    test_deserialize_serialize({
+                                       0x00, 0x03, 0x00, 0x09, 0x00, 0x00, 0x00, 0x01, 0x00, 0x01, 0x63, 0x00
+                               }, header, k4s::request_header_version<k4s::metadata_request>(9));
+    BOOST_REQUIRE_EQUAL(*header.api_version, 9);
+    BOOST_REQUIRE_EQUAL(*header.client_id, "c");
+    BOOST_REQUIRE_EQUAL(k4s::request_header_version<k4s::metadata_request>(8), 1);
+    BOOST_REQUIRE_EQUAL(k4s::response_header_version<k4s::metadata_request>(9), 1);
+    BOOST_REQUIRE_EQUAL(k4s::response_header_version<k4s::api_versions_request>(3), 0);
 }
 
 BOOST_AUTO_TEST_CASE(kafka_response_header_parsing_test) {
@@ -193,6 +428,26 @@ BOOST_AUTO_TEST_CASE(kafka_primitives_error_code_test) {
     test_deserialize_throw({0xAC, 0x02}, error_code, 0);
 }
 
+BOOST_AUTO_TEST_CASE(kafka_primitives_error_code_traits_test) {
+    for (int16_t code = k4s::error::MIN_ERROR_CODE; code <= k4s::error::MAX_ERROR_CODE; code++) {
+        const auto& error = k4s::error::kafka_error_code::get_error(code);
+        BOOST_REQUIRE_EQUAL(error.error_code, code);
+        k4s::kafka_error_code_t error_code(error);
+        BOOST_REQUIRE_EQUAL(error_code.retriable(), bool(error.retriable));
+        BOOST_REQUIRE_EQUAL(error_code.invalidates_metadata(), bool(error.invalidates_metadata));
+    }
+
+    k4s::kafka_error_code_t error_code;
+    BOOST_REQUIRE(!error_code.retriable());
+    test_deserialize_serialize({0x00, 0x06}, error_code, 0);
+    BOOST_REQUIRE(error_code.retriable());
+    BOOST_REQUIRE(error_code.invalidates_metadata());
+    error_code = k4s::error::kafka_error_code::REQUEST_TIMED_OUT;
+    BOOST_REQUIRE(error_code.retriable());
+    BOOST_REQUIRE(!error_code.invalidates_metadata());
+    BOOST_REQUIRE_EQUAL(k4s::error::kafka_error_code::get_error(1000).error_code, -1);
+}
+
 BOOST_AUTO_TEST_CASE(kafka_api_versions_response_parsing_test) {
     k4s::api_versions_response response;
     test_deserialize_serialize({
@@ -438,6 +693,7 @@ BOOST_AUTO_TEST_CASE(kafka_produce_request_parsing_test) {
                                        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x01, 0x10, 0x00, 0x00, 0x00,
                                        0x02, 0x30, 0x02, 0x30, 0x00
                                }, request, 7);
+    BOOST_REQUIRE_EQUAL(request.serialized_size(7), 101);
 
     BOOST_REQUIRE(request.transactional_id.is_null());
     BOOST_REQUIRE_EQUAL(*request.acks, -1);
@@ -492,4 +748,270 @@ BOOST_AUTO_TEST_CASE(kafka_produce_response_parsing_test) {
     BOOST_REQUIRE_EQUAL(*partition.base_offset, 0x46);
     BOOST_REQUIRE_EQUAL(*partition.log_append_time_ms, -1);
     BOOST_REQUIRE_EQUAL(*partition.log_start_offset, 0);
-}
\ No newline at end of file
+}
+BOOST_AUTO_TEST_CASE(kafka_find_coordinator_response_parsing_test) {
+    k4s::find_coordinator_response response;
+    test_deserialize_serialize({
+                                       0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0x00, 0x00, 0x00, 0x01, 0x00, 0x05, 0x6b, 0x61,
+                                       0x66, 0x6b, 0x61, 0x00, 0x00, 0x23, 0x84
+                               }, response, 1);
+
+    BOOST_REQUIRE_EQUAL(*response.throttle_time_ms, 0);
+    BOOST_REQUIRE(response.error_code == k4s::error::kafka_error_code::NONE);
+    BOOST_REQUIRE(response.error_message.is_null());
+    BOOST_REQUIRE_EQUAL(*response.node_id, 1);
+    BOOST_REQUIRE_EQUAL(*response.host, "kafka");
+    BOOST_REQUIRE_EQUAL(*response.port, 9092);
+}
+
+BOOST_AUTO_TEST_CASE(kafka_join_group_response_parsing_test) {
+    k4s::join_group_response response;
+    test_deserialize_serialize({
+                                       0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x00, 0x05, 0x72, 0x61, 0x6e, 0x67,
+                                       0x65, 0x00, 0x02, 0x6d, 0x31, 0x00, 0x02, 0x6d, 0x31, 0x00, 0x00, 0x00, 0x01, 0x00, 0x02, 0x6d,
+                                       0x31, 0xff, 0xff, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00
+                               }, response, 5);
+
+    BOOST_REQUIRE(response.error_code == k4s::error::kafka_error_code::NONE);
+    BOOST_REQUIRE_EQUAL(*response.generation_id, 3);
+    BOOST_REQUIRE_EQUAL(*response.protocol_name, "range");
+    BOOST_REQUIRE_EQUAL(*response.leader, "m1");
+    BOOST_REQUIRE_EQUAL(*response.member_id, "m1");
+    BOOST_REQUIRE_EQUAL(response.members->size(), 1);
+    BOOST_REQUIRE_EQUAL(*response.members[0].member_id, "m1");
+    BOOST_REQUIRE(response.members[0].group_instance_id.is_null());
+    BOOST_REQUIRE_EQUAL(response.members[0].metadata->size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(kafka_consumer_protocol_subscription_parsing_test) {
+    k4s::consumer_protocol_subscription subscription;
+    test_deserialize_serialize({
+                                       0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x00, 0x04, 0x74, 0x65, 0x73, 0x74, 0xff, 0xff, 0xff, 0xff,
+                                       0x00, 0x00, 0x00, 0x01, 0x00, 0x04, 0x74, 0x65, 0x73, 0x74, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00,
+                                       0x00, 0x00, 0x00, 0x00, 0x00, 0x01
+                               }, subscription, 1);
+
+    BOOST_REQUIRE_EQUAL(*subscription.version, 1);
+    BOOST_REQUIRE_EQUAL(subscription.topics->size(), 1);
+    BOOST_REQUIRE_EQUAL(*subscription.topics[0], "test");
+    BOOST_REQUIRE(subscription.user_data.is_null());
+    BOOST_REQUIRE_EQUAL(subscription.owned_partitions->size(), 1);
+    BOOST_REQUIRE_EQUAL(*subscription.owned_partitions[0].topic, "test");
+    BOOST_REQUIRE_EQUAL(subscription.owned_partitions[0].partitions->size(), 2);
+    BOOST_REQUIRE_EQUAL(*subscription.owned_partitions[0].partitions[1], 1);
+
+    std::vector<unsigned char> version_0 {
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x04, 0x74, 0x65, 0x73, 0x74, 0xff, 0xff, 0xff, 0xff
+    };
+    boost::iostreams::stream<boost::iostreams::array_source> input_stream(reinterpret_cast<char *>(version_0.data()),
+                                                                          version_0.size());
+    subscription.deserialize(input_stream, 1);
+    BOOST_REQUIRE_EQUAL(*subscription.version, 0);
+    BOOST_REQUIRE(subscription.owned_partitions->empty());
+}
+
+BOOST_AUTO_TEST_CASE(kafka_fetch_response_parsing_test) {
+    k4s::fetch_response response;
+    test_deserialize_serialize({
+                                       0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, 0x01, 0x00, 0x01,
+                                       0x61, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                       0x00, 0x00, 0x0a, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0a, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                       0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff
+                               }, response, 7);
+    BOOST_REQUIRE_EQUAL(response.serialized_size(7), 59);
+
+    BOOST_REQUIRE(response.error_code == k4s::error::kafka_error_code::NONE);
+    BOOST_REQUIRE_EQUAL(*response.session_id, 7);
+    BOOST_REQUIRE_EQUAL(response.topics->size(), 1);
+    BOOST_REQUIRE_EQUAL(*response.topics[0].name, "a");
+
+    const auto& partition = response.topics[0].partitions[0];
+    BOOST_REQUIRE_EQUAL(*partition.partition_index, 0);
+    BOOST_REQUIRE_EQUAL(*partition.high_watermark, 10);
+    BOOST_REQUIRE_EQUAL(*partition.last_stable_offset, 10);
+    BOOST_REQUIRE_EQUAL(*partition.log_start_offset, 0);
+    BOOST_REQUIRE(partition.aborted_transactions->empty());
+    BOOST_REQUIRE(partition.records.is_null());
+}
+
+BOOST_AUTO_TEST_CASE(kafka_records_view_test) {
+    std::vector<unsigned char> batch {
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3a, 0xff, 0xff, 0xff, 0xff, 0x02,
+            0x06, 0x76, 0x5e, 0x6f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x6e, 0x5b, 0x6e,
+            0xba, 0x2c, 0x00, 0x00, 0x01, 0x6e, 0x5b, 0x6e, 0xba, 0x2c, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+            0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x01, 0x10, 0x00, 0x00, 0x00,
+            0x02, 0x30, 0x02, 0x30, 0x00
+    };
+    // The last batch is cut in half, as if it didn't fit into the response.
+    std::vector<unsigned char> data(batch);
+    data.insert(data.end(), batch.begin(), batch.begin() + 35);
+
+    k4s::kafka_records_view records(temporary_buffer<char>(reinterpret_cast<char *>(data.data()), data.size()));
+    auto batches = records.batches();
+    BOOST_REQUIRE_EQUAL(batches.size(), 1);
+    BOOST_REQUIRE_EQUAL(batches[0].base_offset(), 0);
+    BOOST_REQUIRE_EQUAL(batches[0].last_offset(), 0);
+    BOOST_REQUIRE_EQUAL(batches[0].records_count(), 1);
+    BOOST_REQUIRE(!batches[0].is_control_batch());
+
+    size_t record_count = 0;
+    for (const auto& record : batches[0]) {
+        BOOST_REQUIRE_EQUAL(record.offset(), 0);
+        BOOST_REQUIRE_EQUAL(record.timestamp(), 0x16e5b6eba2c);
+        BOOST_REQUIRE(*record.key() == "0");
+        BOOST_REQUIRE(*record.value() == "0");
+        BOOST_REQUIRE_EQUAL(record.header_count(), 0);
+        // Key and value point into the shared buffer.
+        BOOST_REQUIRE(record.value()->data() > batches[0].buffer().get());
+        BOOST_REQUIRE(record.value()->data() < batches[0].buffer().get() + batches[0].buffer().size());
+        record_count++;
+    }
+    BOOST_REQUIRE_EQUAL(record_count, 1);
+
+    batch.back() = 0x01;
+    BOOST_REQUIRE_THROW(k4s::kafka_record_batch_view(temporary_buffer<char>(reinterpret_cast<char *>(batch.data()),
+            batch.size())), k4s::parsing_exception);
+}
+
+BOOST_AUTO_TEST_CASE(kafka_records_view_compressed_batch_test) {
+    std::vector<unsigned char> batch {
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3a, 0xff, 0xff, 0xff, 0xff, 0x02,
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x6e, 0x5b, 0x6e,
+            0xba, 0x2c, 0x00, 0x00, 0x01, 0x6e, 0x5b, 0x6e, 0xba, 0x2c, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+            0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x01, 0x10, 0x00, 0x00, 0x00,
+            0x02, 0x30, 0x02, 0x30, 0x00
+    };
+    // Attributes say GZIP, the CRC is computed over them.
+    auto crc = crc32c(reinterpret_cast<char *>(batch.data()) + 21, reinterpret_cast<char *>(batch.data()) + batch.size());
+    for (int i = 0; i < 4; i++) {
+        batch[17 + i] = (crc >> (24 - 8 * i)) & 0xff;
+    }
+
+    // The batch is valid, only its records can't be read.
+    k4s::kafka_record_batch_view view(temporary_buffer<char>(reinterpret_cast<char *>(batch.data()), batch.size()));
+    BOOST_REQUIRE(view.compression_type() == k4s::kafka_record_compression_type::GZIP);
+    BOOST_REQUIRE_EQUAL(view.last_offset(), 0);
+    BOOST_REQUIRE_THROW(view.begin(), k4s::unsupported_compression_exception);
+}
+
+BOOST_AUTO_TEST_CASE(kafka_offset_fetch_response_parsing_test) {
+    k4s::offset_fetch_response response;
+    test_deserialize_serialize({
+                                       0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x01, 0x74, 0x00, 0x00, 0x00, 0x01, 0x00,
+                                       0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x2a, 0xff, 0xff, 0xff, 0xff, 0xff,
+                                       0xff, 0x00, 0x00, 0x00, 0x00
+                               }, response, 5);
+
+    BOOST_REQUIRE(response.error_code == k4s::error::kafka_error_code::NONE);
+    BOOST_REQUIRE_EQUAL(response.topics->size(), 1);
+    BOOST_REQUIRE_EQUAL(*response.topics[0].name, "t");
+    BOOST_REQUIRE_EQUAL(response.topics[0].partitions->size(), 1);
+    BOOST_REQUIRE_EQUAL(*response.topics[0].partitions[0].partition_index, 2);
+    BOOST_REQUIRE_EQUAL(*response.topics[0].partitions[0].committed_offset, 42);
+    BOOST_REQUIRE_EQUAL(*response.topics[0].partitions[0].committed_leader_epoch, -1);
+    BOOST_REQUIRE(response.topics[0].partitions[0].metadata.is_null());
+    BOOST_REQUIRE(response.topics[0].partitions[0].error_code == k4s::error::kafka_error_code::NONE);
+}
+
+BOOST_AUTO_TEST_CASE(kafka_heartbeat_request_parsing_test) {
+    k4s::heartbeat_request request;
+    test_deserialize_serialize({
+                                       0x00, 0x01, 0x67, 0x00, 0x00, 0x00, 0x03, 0x00, 0x02, 0x6d, 0x31, 0x00, 0x02, 0x69, 0x31
+                               }, request, 3);
+
+    BOOST_REQUIRE_EQUAL(*request.group_id, "g");
+    BOOST_REQUIRE_EQUAL(*request.generation_id, 3);
+    BOOST_REQUIRE_EQUAL(*request.member_id, "m1");
+    BOOST_REQUIRE_EQUAL(*request.group_instance_id, "i1");
+    BOOST_REQUIRE_EQUAL(request.serialized_size(3), 15);
+    BOOST_REQUIRE_EQUAL(request.serialized_size<3>(), 15);
+
+    test_deserialize_serialize({
+                                       0x00, 0x01, 0x67, 0x00, 0x00, 0x00, 0x03, 0x00, 0x02, 0x6d, 0x31
+                               }, request, 2);
+    BOOST_REQUIRE_EQUAL(request.serialized_size(2), 11);
+
+    test_deserialize_throw({0x00, 0x01, 0x67}, request, k4s::heartbeat_request::MAX_SUPPORTED_VERSION + 1);
+}
+
+BOOST_AUTO_TEST_CASE(kafka_heartbeat_response_parsing_test) {
+    k4s::heartbeat_response response;
+    test_deserialize_serialize({
+                                       0x00, 0x00, 0x00, 0x64, 0x00, 0x1b
+                               }, response, 1);
+
+    BOOST_REQUIRE_EQUAL(*response.throttle_time_ms, 100);
+    BOOST_REQUIRE(response.error_code == k4s::error::kafka_error_code::REBALANCE_IN_PROGRESS);
+    BOOST_REQUIRE_EQUAL(response.serialized_size(0), 2);
+}
+
+BOOST_AUTO_TEST_CASE(kafka_leave_group_request_parsing_test) {
+    k4s::leave_group_request request;
+    test_deserialize_serialize({
+                                       0x00, 0x01, 0x67, 0x00, 0x02, 0x6d, 0x31
+                               }, request, 2);
+
+    BOOST_REQUIRE_EQUAL(*request.group_id, "g");
+    BOOST_REQUIRE_EQUAL(*request.member_id, "m1");
+    BOOST_REQUIRE_EQUAL(k4s::leave_group_request::MAX_SUPPORTED_VERSION, 2);
+}
+
+BOOST_AUTO_TEST_CASE(kafka_flexible_api_versions_response_parsing_test) {
+    k4s::api_versions_response response;
+    test_deserialize_serialize({
+                                       0x00, 0x00, 0x03, 0x00, 0x03, 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x12, 0x00, 0x00, 0x00, 0x03,
+                                       0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+                               }, response, 3);
+
+    BOOST_REQUIRE(response.error_code == k4s::error::kafka_error_code::NONE);
+    BOOST_REQUIRE_EQUAL(response.api_keys->size(), 2);
+    BOOST_REQUIRE_EQUAL(*response[k4s::api_versions_request::API_KEY].max_version, 3);
+    BOOST_REQUIRE_EQUAL(response.max_version<k4s::metadata_request>(), 9);
+
+    // Brokers answer the versions of ApiVersions they don't support in version 0.
+    std::vector<unsigned char> unsupported {
+            0x00, 0x23, 0x00, 0x00, 0x00, 0x01, 0x00, 0x12, 0x00, 0x00, 0x00, 0x02
+    };
+    boost::iostreams::stream<boost::iostreams::array_source> input_stream(reinterpret_cast<char *>(unsupported.data()),
+                                                                          unsupported.size());
+    response.deserialize(input_stream, 3);
+    BOOST_REQUIRE(response.error_code == k4s::error::kafka_error_code::UNSUPPORTED_VERSION);
+    BOOST_REQUIRE_EQUAL(*response[k4s::api_versions_request::API_KEY].max_version, 2);
+}
+
+BOOST_AUTO_TEST_CASE(kafka_flexible_metadata_response_parsing_test) {
+    k4s::metadata_response response;
+    test_deserialize_serialize({
+                                       0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x01, 0x06, 0x6b, 0x61, 0x66, 0x6b, 0x61, 0x00,
+                                       0x00, 0x23, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x00, 0x00, 0x02, 0x74, 0x00,
+                                       0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x02,
+                                       0x00, 0x00, 0x00, 0x01, 0x02, 0x00, 0x00, 0x00, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                       0x00, 0x00, 0x00, 0x00, 0x00
+                               }, response, 9);
+
+    BOOST_REQUIRE_EQUAL(response.brokers->size(), 1);
+    BOOST_REQUIRE_EQUAL(*response.brokers[0].host, "kafka");
+    BOOST_REQUIRE_EQUAL(*response.brokers[0].port, 9092);
+    BOOST_REQUIRE(response.brokers[0].rack.is_null());
+    BOOST_REQUIRE(response.cluster_id.is_null());
+    BOOST_REQUIRE_EQUAL(*response.controller_id, 1);
+    BOOST_REQUIRE_EQUAL(response.topics->size(), 1);
+    BOOST_REQUIRE_EQUAL(*response.topics[0].name, "t");
+    BOOST_REQUIRE_EQUAL(response.topics[0].partitions->size(), 1);
+    BOOST_REQUIRE_EQUAL(*response.topics[0].partitions[0].leader_id, 1);
+    BOOST_REQUIRE_EQUAL(*response.topics[0].partitions[0].replica_nodes[0], 1);
+    BOOST_REQUIRE(response.topics[0].partitions[0].offline_replicas->empty());
+}
+
+BOOST_AUTO_TEST_CASE(kafka_flexible_heartbeat_request_parsing_test) {
+    k4s::heartbeat_request request;
+    test_deserialize_serialize({
+                                       0x02, 0x67, 0x00, 0x00, 0x00, 0x03, 0x03, 0x6d, 0x31, 0x00, 0x00
+                               }, request, 4);
+
+    BOOST_REQUIRE_EQUAL(*request.group_id, "g");
+    BOOST_REQUIRE_EQUAL(*request.member_id, "m1");
+    BOOST_REQUIRE(request.group_instance_id.is_null());
+    BOOST_REQUIRE_EQUAL(request.serialized_size(4), 11);
+    BOOST_REQUIRE_EQUAL(k4s::heartbeat_request::FIRST_FLEXIBLE_VERSION, 4);
+}
@@ -0,0 +1,67 @@
+/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ * Copyright (C) 2019 ScyllaDB
+ */
+
+#define BOOST_TEST_MODULE kafka
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <kafka4seastar/connection/window_controller.hh>
+
+namespace k4s = kafka4seastar;
+
+BOOST_AUTO_TEST_CASE(kafka_window_controller_grows_with_flat_latency_test) {
+    k4s::window_controller controller(2, 16);
+    BOOST_REQUIRE_EQUAL(controller.window(), 2);
+
+    for (int i = 0; i < 200; i++) {
+        controller.on_success(10);
+    }
+    BOOST_REQUIRE_EQUAL(controller.window(), 16);
+}
+
+BOOST_AUTO_TEST_CASE(kafka_window_controller_shrinks_with_rising_latency_test) {
+    k4s::window_controller controller(16, 16);
+    controller.on_success(10);
+    for (int i = 0; i < 200; i++) {
+        controller.on_success(40);
+    }
+    // With the latency four times the base one, most of the window is queued.
+    BOOST_REQUIRE_LT(controller.window(), 16);
+    BOOST_REQUIRE_GE(controller.window(), 1);
+    auto shrunk = controller.window();
+
+    // Back to the base latency, the window grows again.
+    for (int i = 0; i < 200; i++) {
+        controller.on_success(10);
+    }
+    BOOST_REQUIRE_GT(controller.window(), shrunk);
+}
+
+BOOST_AUTO_TEST_CASE(kafka_window_controller_congestion_test) {
+    k4s::window_controller controller(16, 16);
+    controller.on_congestion();
+    BOOST_REQUIRE_EQUAL(controller.window(), 8);
+    controller.on_congestion();
+    controller.on_congestion();
+    controller.on_congestion();
+    controller.on_congestion();
+    BOOST_REQUIRE_EQUAL(controller.window(), 1);
+}
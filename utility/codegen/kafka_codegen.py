@@ -0,0 +1,463 @@
+#!/usr/bin/env python3
+#
+# This file is open source software, licensed to you under the terms
+# of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+# distributed with this work for additional information regarding copyright
+# ownership.  You may not use this file except in compliance with the License.
+#
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+#
+
+#
+# Copyright (C) 2020 ScyllaDB Ltd.
+#
+
+# Generates the C++ classes of the protocol messages from the JSON message
+# specifications of Apache Kafka (clients/src/main/resources/common/message).
+#
+# Every message becomes a header with the same interface as the hand-written
+# ones in include/kafka4seastar/protocol. The serializers are templates on the
+# API version, so the checks of the version of each field are resolved at
+# compile time, and the runtime overloads only dispatch on the version once.
+#
+# Records are bytes unless --records-type says otherwise: kafka_records
+# encodes the batches of produce requests, kafka_records_view refers to the
+# batches of fetch responses in place, and the messages holding them get
+# share_buffer(), which points the views at the buffer they were read from.
+
+import argparse
+import json
+import os
+import re
+import sys
+
+LICENSE = """/*
+ * This file is open source software, licensed to you under the terms
+ * of the Apache License, Version 2.0 (the "License").  See the NOTICE file
+ * distributed with this work for additional information regarding copyright
+ * ownership.  You may not use this file except in compliance with the License.
+ *
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Copyright (C) 2020 ScyllaDB Ltd.
+ */
+"""
+
+PRIMITIVE_TYPES = {
+    "bool": "kafka_bool_t",
+    "int8": "kafka_int8_t",
+    "int16": "kafka_int16_t",
+    "int32": "kafka_int32_t",
+    "int64": "kafka_int64_t",
+    "uint32": "kafka_uint32_t",
+    "string": "kafka_string_t",
+    "bytes": "kafka_bytes_t",
+    "records": "kafka_nullable_bytes_t",
+}
+
+NULLABLE_TYPES = {
+    "string": "kafka_nullable_string_t",
+    "bytes": "kafka_nullable_bytes_t",
+    "records": "kafka_nullable_bytes_t",
+}
+
+NUMERIC_TYPES = {"bool", "int8", "int16", "int32", "int64", "uint32"}
+
+RECORDS_TYPES = {"kafka_records", "kafka_records_view"}
+
+# Types whose length is compact in flexible versions, besides arrays.
+COMPACT_TYPES = {"string", "bytes", "records"}
+
+INDENT = "    "
+
+
+class schema_error(Exception):
+    pass
+
+
+class version_range:
+    """An inclusive range of versions, as written in the specifications ("3+", "0-2", "none")."""
+
+    UNBOUNDED = 0x7fff
+
+    def __init__(self, low, high):
+        self.low = low
+        self.high = high
+
+    @staticmethod
+    def parse(text):
+        text = text.strip()
+        if text == "none":
+            return version_range(1, 0)
+        if text.endswith("+"):
+            return version_range(int(text[:-1]), version_range.UNBOUNDED)
+        if "-" in text:
+            low, high = text.split("-")
+            return version_range(int(low), int(high))
+        return version_range(int(text), int(text))
+
+    def empty(self):
+        return self.low > self.high
+
+    def intersect(self, other):
+        return version_range(max(self.low, other.low), min(self.high, other.high))
+
+    def condition(self, generated):
+        """The compile-time condition selecting this range, within the generated versions."""
+        checks = []
+        if self.low > generated.low:
+            checks.append("Version >= {}".format(self.low))
+        if self.high < generated.high:
+            checks.append("Version <= {}".format(self.high))
+        return " && ".join(checks)
+
+
+def snake_case(name):
+    name = re.sub(r"([A-Z]+)([A-Z][a-z])", r"\1_\2", name)
+    name = re.sub(r"([a-z0-9])([A-Z])", r"\1_\2", name)
+    return name.lower()
+
+
+def load_schema(path):
+    # The specifications are JSON with full-line // comments.
+    with open(path) as schema_file:
+        lines = [line for line in schema_file if not line.lstrip().startswith("//")]
+    return json.loads("".join(lines))
+
+
+class field:
+    def __init__(self, spec, generated, flexible, structs, prefix):
+        self.name = snake_case(spec["name"])
+        self.versions = version_range.parse(spec["versions"]).intersect(generated)
+        # Tagged fields are kept with the unknown ones, in tagged_fields.
+        self.present = not self.versions.empty() and "tag" not in spec
+        self.struct = None
+        self.records_view = False
+        self.compact = None
+        self.initializer = ""
+        if not self.present:
+            # Structures used only by the fields left out aren't declared at all.
+            self.cpp_type = None
+            return
+
+        kafka_type = spec["type"]
+        flexible_versions = flexible.intersect(self.versions)
+        if (kafka_type.startswith("[]") or kafka_type in COMPACT_TYPES) and not flexible_versions.empty():
+            if flexible_versions.low <= self.versions.low:
+                self.compact = "true"
+            else:
+                self.compact = "Version >= {}".format(flexible_versions.low)
+
+        nullable = not version_range.parse(spec.get("nullableVersions", "none")).intersect(generated).empty()
+
+        if kafka_type.startswith("[]"):
+            element_type = kafka_type[2:]
+            if element_type in PRIMITIVE_TYPES:
+                self.cpp_type = "kafka_array_t<{}>".format(PRIMITIVE_TYPES[element_type])
+            else:
+                self.struct = structs.declare(element_type, spec.get("fields"), prefix, self.versions, flexible)
+                self.cpp_type = "kafka_array_t<{}>".format(self.struct)
+        elif kafka_type == "records" and structs.records_type:
+            self.cpp_type = structs.records_type
+            self.records_view = structs.records_type == "kafka_records_view"
+        elif kafka_type in PRIMITIVE_TYPES:
+            if spec["name"].endswith("ErrorCode") and kafka_type == "int16":
+                self.cpp_type = "kafka_error_code_t"
+            elif nullable and kafka_type in NULLABLE_TYPES:
+                self.cpp_type = NULLABLE_TYPES[kafka_type]
+            else:
+                self.cpp_type = PRIMITIVE_TYPES[kafka_type]
+        else:
+            raise schema_error("Unsupported type {} of field {}".format(kafka_type, spec["name"]))
+
+        default = spec.get("default")
+        if default is not None and self.cpp_type != "kafka_error_code_t":
+            if kafka_type == "bool":
+                self.initializer = "{{{}}}".format(1 if default in (True, "true") else 0)
+            elif kafka_type in NUMERIC_TYPES:
+                self.initializer = "{{{}}}".format(int(str(default), 0))
+            elif kafka_type == "string" and default not in ("", "null"):
+                self.initializer = "{{{}}}".format(json.dumps(default))
+
+    def declaration(self):
+        return "{}{} {}{};".format(INDENT, self.cpp_type, self.name, self.initializer)
+
+    def statements(self, generated, call):
+        condition = self.versions.condition(generated)
+        statement = call.format(name=self.name)
+        if not condition:
+            return [statement]
+        return ["if constexpr ({}) {{".format(condition), INDENT + statement, "}"]
+
+    def arguments(self, *arguments):
+        arguments = list(arguments)
+        if self.compact:
+            arguments.append(self.compact)
+        return ", ".join(arguments)
+
+    def size_call(self):
+        if self.struct:
+            return "size += {{name}}.template serialized_size<Version>({});".format(self.arguments())
+        return "size += {{name}}.serialized_size({});".format(self.arguments("Version"))
+
+    def serialize_call(self):
+        if self.struct:
+            return "{{name}}.template serialize<Version>({});".format(self.arguments("os"))
+        return "{{name}}.serialize({});".format(self.arguments("os", "Version"))
+
+    def deserialize_call(self):
+        if self.struct:
+            return "{{name}}.template deserialize<Version>({});".format(self.arguments("is"))
+        return "{{name}}.deserialize({});".format(self.arguments("is", "Version"))
+
+
+class struct_registry:
+    """Collects the nested structures in the order they have to be declared."""
+
+    def __init__(self, common_structs, records_type):
+        self.common_structs = {spec["name"]: spec["fields"] for spec in common_structs}
+        self.records_type = records_type
+        self.declared = set()
+        self.ordered = []
+        # Structures holding records views, directly or in their elements.
+        self.sharing = set()
+
+    def declare(self, kafka_name, fields, prefix, versions, flexible):
+        # The fields of a structure are only checked against the versions it is used in.
+        if fields is None:
+            if kafka_name not in self.common_structs:
+                raise schema_error("Unknown structure {}".format(kafka_name))
+            fields = self.common_structs[kafka_name]
+        # Names already starting with the message name (e.g. MetadataResponseTopic) aren't prefixed again.
+        cpp_name = snake_case(kafka_name)
+        if not cpp_name.startswith(prefix + "_"):
+            cpp_name = "{}_{}".format(prefix, cpp_name)
+        if cpp_name not in self.declared:
+            # The fields are created first, so the structures they use are declared earlier.
+            members = [field(spec, versions, flexible, self, prefix) for spec in fields]
+            self.declared.add(cpp_name)
+            self.ordered.append((cpp_name, members, versions))
+            if self.shares_buffer(members):
+                self.sharing.add(cpp_name)
+        return cpp_name
+
+    def shares_buffer(self, fields):
+        return any(f.present and (f.records_view or f.struct in self.sharing) for f in fields)
+
+
+def tagged_fields_statements(generated, flexible, call):
+    # Structures end with their tagged fields in the flexible versions.
+    flexible_versions = flexible.intersect(generated)
+    if flexible_versions.empty():
+        return []
+    condition = version_range(flexible_versions.low, generated.high).condition(generated)
+    if not condition:
+        return [call]
+    return ["if constexpr ({}) {{".format(condition), INDENT + call, "}"]
+
+
+def emit_versioned_methods(lines, fields, generated, flexible):
+    present = [f for f in fields if f.present]
+
+    lines.append(INDENT + "template<int16_t Version>")
+    lines.append(INDENT + "[[nodiscard]] size_t serialized_size() const {")
+    lines.append(INDENT * 2 + "size_t size = 0;")
+    for f in present:
+        lines.extend(INDENT * 2 + line for line in f.statements(generated, f.size_call()))
+    lines.extend(INDENT * 2 + line for line in tagged_fields_statements(generated, flexible,
+            "size += tagged_fields.serialized_size(Version);"))
+    lines.append(INDENT * 2 + "return size;")
+    lines.append(INDENT + "}")
+    lines.append("")
+
+    lines.append(INDENT + "template<int16_t Version>")
+    lines.append(INDENT + "void serialize(std::ostream& os) const {")
+    for f in present:
+        lines.extend(INDENT * 2 + line for line in f.statements(generated, f.serialize_call()))
+    lines.extend(INDENT * 2 + line for line in tagged_fields_statements(generated, flexible,
+            "tagged_fields.serialize(os, Version);"))
+    lines.append(INDENT + "}")
+    lines.append("")
+
+    lines.append(INDENT + "template<int16_t Version>")
+    lines.append(INDENT + "void deserialize(std::istream& is) {")
+    for f in present:
+        lines.extend(INDENT * 2 + line for line in f.statements(generated, f.deserialize_call()))
+    lines.extend(INDENT * 2 + line for line in tagged_fields_statements(generated, flexible,
+            "tagged_fields.deserialize(is, Version);"))
+    lines.append(INDENT + "}")
+
+
+def emit_share_buffer(lines, fields, structs):
+    if not structs.shares_buffer(fields):
+        return
+    lines.append("")
+    lines.append(INDENT + "// Makes the records refer to the buffer the message was deserialized from.")
+    lines.append(INDENT + "void share_buffer(const seastar::temporary_buffer<char>& buffer) {")
+    for f in fields:
+        if not f.present:
+            continue
+        if f.records_view:
+            lines.append(INDENT * 2 + "{}.share_buffer(buffer);".format(f.name))
+        elif f.struct in structs.sharing:
+            lines.append(INDENT * 2 + "if (!{}.is_null()) {{".format(f.name))
+            lines.append(INDENT * 3 + "for (auto& element : *{}) {{".format(f.name))
+            lines.append(INDENT * 4 + "element.share_buffer(buffer);")
+            lines.append(INDENT * 3 + "}")
+            lines.append(INDENT * 2 + "}")
+    lines.append(INDENT + "}")
+
+
+def emit_dispatch(lines, signature, call, failure, generated):
+    lines.append(INDENT + signature + " {")
+    lines.append(INDENT * 2 + "switch (api_version) {")
+    for version in range(generated.low, generated.high + 1):
+        lines.append(INDENT * 2 + "case {}:".format(version))
+        lines.append(INDENT * 3 + call.format(version=version))
+    lines.append(INDENT * 2 + "default:")
+    lines.append(INDENT * 3 + failure)
+    lines.append(INDENT * 2 + "}")
+    lines.append(INDENT + "}")
+
+
+def emit_fields(lines, fields, generated, flexible):
+    lines.extend(f.declaration() for f in fields if f.present)
+    if not flexible.intersect(generated).empty():
+        lines.append(INDENT + "kafka_tagged_fields_t tagged_fields;")
+
+
+def emit_class(lines, name, fields, generated, flexible, structs):
+    lines.append("class {} {{".format(name))
+    lines.append("public:")
+    emit_fields(lines, fields, generated, flexible)
+    emit_share_buffer(lines, fields, structs)
+    lines.append("")
+    emit_versioned_methods(lines, fields, generated, flexible)
+    lines.append("};")
+    lines.append("")
+
+
+def generate(schema, schema_name, min_version, max_version, records_type):
+    if schema["type"] not in ("request", "response"):
+        raise schema_error("Only requests and responses are supported, got {}".format(schema["type"]))
+
+    class_name = snake_case(schema["name"])
+    generated = version_range.parse(schema["validVersions"])
+    flexible = version_range.parse(schema.get("flexibleVersions", "none"))
+    if min_version is not None:
+        generated.low = max(generated.low, min_version)
+    if max_version is not None:
+        generated.high = min(generated.high, max_version)
+    if generated.empty():
+        raise schema_error("No versions of {} can be generated".format(schema["name"]))
+
+    structs = struct_registry(schema.get("commonStructs", []), records_type)
+    fields = [field(spec, generated, flexible, structs, class_name) for spec in schema["fields"]]
+
+    lines = [LICENSE]
+    lines.append("// Generated by utility/codegen/kafka_codegen.py from {}, do not edit.".format(schema_name))
+    lines.append("")
+    lines.append("#pragma once")
+    lines.append("")
+    lines.append("#include <kafka4seastar/protocol/kafka_primitives.hh>")
+    if records_type:
+        lines.append("#include <kafka4seastar/protocol/{}.hh>".format(records_type))
+    response_name = None
+    if schema["type"] == "request":
+        response_name = snake_case(re.sub(r"Request$", "Response", schema["name"]))
+        lines.append("#include <kafka4seastar/protocol/{}.hh>".format(response_name))
+    lines.append("")
+    lines.append("namespace kafka4seastar {")
+    lines.append("")
+
+    for struct_name, members, versions in structs.ordered:
+        emit_class(lines, struct_name, members, versions, flexible, structs)
+
+    lines.append("class {} {{".format(class_name))
+    lines.append("public:")
+    if response_name:
+        lines.append(INDENT + "using response_type = {};".format(response_name))
+    lines.append(INDENT + "static constexpr int16_t API_KEY = {};".format(schema["apiKey"]))
+    lines.append(INDENT + "static constexpr int16_t MIN_SUPPORTED_VERSION = {};".format(generated.low))
+    lines.append(INDENT + "static constexpr int16_t MAX_SUPPORTED_VERSION = {};".format(generated.high))
+    if not flexible.intersect(generated).empty():
+        lines.append(INDENT + "static constexpr int16_t FIRST_FLEXIBLE_VERSION = {};".format(
+                max(flexible.low, generated.low)))
+    lines.append("")
+    emit_fields(lines, fields, generated, flexible)
+    if schema["type"] == "response" and not any(f.present and f.name == "error_code" for f in fields):
+        lines.append(INDENT + "// Not a part of the message, set when the request fails on the client side.")
+        lines.append(INDENT + "kafka_error_code_t error_code;")
+    emit_share_buffer(lines, fields, structs)
+    lines.append("")
+    emit_versioned_methods(lines, fields, generated, flexible)
+    lines.append("")
+
+    unsupported = 'throw std::invalid_argument("Unsupported version of {}");'.format(class_name)
+    emit_dispatch(lines, "[[nodiscard]] size_t serialized_size(int16_t api_version) const",
+            "return serialized_size<{version}>();", unsupported, generated)
+    lines.append("")
+    emit_dispatch(lines, "void serialize(std::ostream& os, int16_t api_version) const",
+            "return serialize<{version}>(os);", unsupported, generated)
+    lines.append("")
+    emit_dispatch(lines, "void deserialize(std::istream& is, int16_t api_version)",
+            "return deserialize<{version}>(is);",
+            'throw parsing_exception("Unsupported version of {}");'.format(class_name), generated)
+    lines.append("};")
+    lines.append("")
+    lines.append("}")
+    lines.append("")
+    return class_name, "\n".join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generates protocol messages from Kafka JSON specifications.")
+    parser.add_argument("--schema", required=True, help="JSON specification of the message")
+    parser.add_argument("--output-dir", required=True, help="directory the include tree is generated into")
+    parser.add_argument("--min-version", type=int, help="lowest version of the message to generate")
+    parser.add_argument("--max-version", type=int, help="highest version of the message to generate")
+    parser.add_argument("--records-type", choices=sorted(RECORDS_TYPES), help="C++ type of the records fields")
+    args = parser.parse_args()
+
+    try:
+        class_name, header = generate(load_schema(args.schema), os.path.basename(args.schema),
+                args.min_version, args.max_version, args.records_type)
+    except (schema_error, KeyError, ValueError) as e:
+        print("{}: {}".format(args.schema, e), file=sys.stderr)
+        return 1
+
+    directory = os.path.join(args.output_dir, "kafka4seastar", "protocol")
+    os.makedirs(directory, exist_ok=True)
+    path = os.path.join(directory, class_name + ".hh")
+    # Leave an unchanged header alone, so the sources including it aren't rebuilt.
+    if os.path.exists(path):
+        with open(path) as existing:
+            if existing.read() == header:
+                return 0
+    with open(path, "w") as output:
+        output.write(header)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())